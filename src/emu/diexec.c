@@ -86,6 +86,7 @@ device_execute_interface::device_execute_interface(const machine_config &mconfig
 	  m_icountptr(NULL),
 	  m_cycles_running(0),
 	  m_cycles_stolen(0),
+	  m_executing(false),
 	  m_suspend(0),
 	  m_nextsuspend(0),
 	  m_eatcycles(0),
@@ -185,7 +186,7 @@ void device_execute_interface::static_set_periodic_int(device_t &device, device_
 
 bool device_execute_interface::executing() const
 {
-	return (this == device().machine().scheduler().currently_executing());
+	return m_executing;
 }
 
 
@@ -243,7 +244,7 @@ void device_execute_interface::adjust_icount(int delta)
 void device_execute_interface::abort_timeslice()
 {
 	// ignore if not the executing device
-	if (this != device().machine().scheduler().currently_executing())
+	if (!executing())
 		return;
 
 	// swallow the remaining cycles
@@ -315,6 +315,7 @@ protected:
 	int *					m_icountptr;				// pointer to the icount
 	int 					m_cycles_running;			// number of cycles we are executing
 	int						m_cycles_stolen;			// number of cycles we artificially stole
+	bool					m_executing;				// true while within our execute function
 
 	// suspend states
 	UINT32					m_suspend;					// suspend reason mask (0 = not suspended)
@@ -96,6 +96,8 @@ const options_entry emu_options::s_option_entries[] =
 	{ OPTION_SNAPSIZE,                                   "auto",      OPTION_STRING,     "specify snapshot/movie resolution (<width>x<height>) or 'auto' to use minimal size " },
 	{ OPTION_SNAPVIEW,                                   "internal",  OPTION_STRING,     "specify snapshot/movie view or 'internal' to use internal pixel-aspect views" },
 	{ OPTION_BURNIN,                                     "0",         OPTION_BOOLEAN,    "create burn-in snapshots for each screen" },
+	{ OPTION_REWIND_SIZE,                                "0",         OPTION_INTEGER,    "megabytes of memory to keep for rewind history; 0 disables rewinding" },
+	{ OPTION_REWIND_INTERVAL,                            "1",         OPTION_INTEGER,    "number of frames between rewind history captures" },
 
 	// performance options
 	{ NULL,                                              NULL,        OPTION_HEADER,     "CORE PERFORMANCE OPTIONS" },
@@ -106,6 +108,9 @@ const options_entry emu_options::s_option_entries[] =
 	{ OPTION_SLEEP,                                      "1",         OPTION_BOOLEAN,    "enable sleeping, which gives time back to other applications when idle" },
 	{ OPTION_SPEED "(0.01-100)",                         "1.0",       OPTION_FLOAT,      "controls the speed of gameplay, relative to realtime; smaller numbers are slower" },
 	{ OPTION_REFRESHSPEED ";rs",                         "0",         OPTION_BOOLEAN,    "automatically adjusts the speed of gameplay to keep the refresh rate lower than the screen" },
+	{ OPTION_PARALLEL_EXECUTION,                         "0",         OPTION_BOOLEAN,    "execute CPUs on separate threads, for games whose drivers declare it safe" },
+	{ OPTION_CHD_CACHE_SIZE,                             "16",        OPTION_INTEGER,    "megabytes of decompressed hunks to cache for each disk image (CHD); 0 caches a single hunk" },
+	{ OPTION_CHD_READAHEAD,                              "1",         OPTION_BOOLEAN,    "decompress disk image (CHD) hunks ahead of sequential reads on a worker thread" },
 
 	// rotation options
 	{ NULL,                                              NULL,        OPTION_HEADER,     "CORE ROTATION OPTIONS" },
@@ -147,6 +152,7 @@ const options_entry emu_options::s_option_entries[] =
 	{ OPTION_SAMPLERATE ";sr(1000-1000000)",             "48000",     OPTION_INTEGER,    "set sound output sample rate" },
 	{ OPTION_SAMPLES,                                    "1",         OPTION_BOOLEAN,    "enable the use of external samples if available" },
 	{ OPTION_VOLUME ";vol",                              "0",         OPTION_INTEGER,    "sound volume in decibels (-32 min, 0 max)" },
+	{ OPTION_AUDIO_FORMAT,                               "int16",     OPTION_STRING,     "format of audio passed to the OSD: int16 (clipped stereo), float (unclipped stereo) or float_speakers (unclipped, one channel per speaker)" },
 
 	// input options
 	{ NULL,                                              NULL,        OPTION_HEADER,     "CORE INPUT OPTIONS" },
@@ -185,6 +191,10 @@ const options_entry emu_options::s_option_entries[] =
 	{ OPTION_DEBUG ";d",                                 "0",         OPTION_BOOLEAN,    "enable/disable debugger" },
 	{ OPTION_DEBUGSCRIPT,                                NULL,        OPTION_STRING,     "script for debugger" },
 	{ OPTION_DEBUG_INTERNAL ";di",                       "0",         OPTION_BOOLEAN,    "use the internal debugger for debugging" },
+	{ OPTION_BENCH_TIMERS,                               "0",         OPTION_INTEGER,    "number of extra do-nothing periodic timers to run, for measuring scheduler overhead" },
+	{ OPTION_STATE_CHECKSUMS,                            NULL,        OPTION_STRING,     "file to log a checksum of the machine state to each frame, for comparing runs" },
+	{ OPTION_PROFILE_SAMPLES,                            NULL,        OPTION_STRING,     "file to write a JSON histogram of sampled profiler types to on exit" },
+	{ OPTION_PROFILE_SAMPLE_RATE,                        "250",       OPTION_INTEGER,    "number of profiler samples to take per second, at most 250" },
 
 	// misc options
 	{ NULL,                                              NULL,        OPTION_HEADER,     "CORE MISC OPTIONS" },
@@ -108,6 +108,8 @@ enum
 #define OPTION_SNAPSIZE				"snapsize"
 #define OPTION_SNAPVIEW				"snapview"
 #define OPTION_BURNIN				"burnin"
+#define OPTION_REWIND_SIZE			"rewind_size"
+#define OPTION_REWIND_INTERVAL		"rewind_interval"
 
 // core performance options
 #define OPTION_AUTOFRAMESKIP		"autoframeskip"
@@ -117,6 +119,9 @@ enum
 #define OPTION_SLEEP				"sleep"
 #define OPTION_SPEED				"speed"
 #define OPTION_REFRESHSPEED			"refreshspeed"
+#define OPTION_PARALLEL_EXECUTION	"parallel_execution"
+#define OPTION_CHD_CACHE_SIZE		"chd_cache_size"
+#define OPTION_CHD_READAHEAD		"chd_readahead"
 
 // core rotation options
 #define OPTION_ROTATE				"rotate"
@@ -153,6 +158,7 @@ enum
 #define OPTION_SAMPLERATE			"samplerate"
 #define OPTION_SAMPLES				"samples"
 #define OPTION_VOLUME				"volume"
+#define OPTION_AUDIO_FORMAT			"audio_format"
 
 // core input options
 #define OPTION_COIN_LOCKOUT			"coin_lockout"
@@ -188,6 +194,10 @@ enum
 #define OPTION_DEBUG				"debug"
 #define OPTION_DEBUG_INTERNAL		"debug_internal"
 #define OPTION_DEBUGSCRIPT			"debugscript"
+#define OPTION_BENCH_TIMERS			"bench_timers"
+#define OPTION_STATE_CHECKSUMS		"state_checksums"
+#define OPTION_PROFILE_SAMPLES		"profile_samples"
+#define OPTION_PROFILE_SAMPLE_RATE	"profile_sample_rate"
 
 // core misc options
 #define OPTION_BIOS					"bios"
@@ -263,6 +273,8 @@ public:
 	const char *snap_size() const { return value(OPTION_SNAPSIZE); }
 	const char *snap_view() const { return value(OPTION_SNAPVIEW); }
 	bool burnin() const { return bool_value(OPTION_BURNIN); }
+	int rewind_size() const { return int_value(OPTION_REWIND_SIZE); }
+	int rewind_interval() const { return int_value(OPTION_REWIND_INTERVAL); }
 
 	// core performance options
 	bool auto_frameskip() const { return bool_value(OPTION_AUTOFRAMESKIP); }
@@ -272,6 +284,9 @@ public:
 	bool sleep() const { return bool_value(OPTION_SLEEP); }
 	float speed() const { return float_value(OPTION_SPEED); }
 	bool refresh_speed() const { return bool_value(OPTION_REFRESHSPEED); }
+	bool parallel_execution() const { return bool_value(OPTION_PARALLEL_EXECUTION); }
+	int chd_cache_size() const { return int_value(OPTION_CHD_CACHE_SIZE); }
+	bool chd_readahead() const { return bool_value(OPTION_CHD_READAHEAD); }
 
 	// core rotation options
 	bool rotate() const { return bool_value(OPTION_ROTATE); }
@@ -307,6 +322,7 @@ public:
 	int sample_rate() const { return int_value(OPTION_SAMPLERATE); }
 	bool samples() const { return bool_value(OPTION_SAMPLES); }
 	int volume() const { return int_value(OPTION_VOLUME); }
+	const char *audio_format() const { return value(OPTION_AUDIO_FORMAT); }
 
 	// core input options
 	bool coin_lockout() const { return bool_value(OPTION_COIN_LOCKOUT); }
@@ -340,6 +356,10 @@ public:
 	bool debug_internal() const { return bool_value(OPTION_DEBUG_INTERNAL); }
 	const char *debug_script() const { return value(OPTION_DEBUGSCRIPT); }
 	bool update_in_pause() const { return bool_value(OPTION_UPDATEINPAUSE); }
+	int bench_timers() const { return int_value(OPTION_BENCH_TIMERS); }
+	const char *state_checksums() const { return value(OPTION_STATE_CHECKSUMS); }
+	const char *profile_samples() const { return value(OPTION_PROFILE_SAMPLES); }
+	int profile_sample_rate() const { return int_value(OPTION_PROFILE_SAMPLE_RATE); }
 
 	// core misc options
 	const char *bios() const { return value(OPTION_BIOS); }
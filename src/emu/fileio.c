@@ -583,6 +583,35 @@ UINT32 emu_file::read(void *buffer, UINT32 length)
 }
 
 
+//-------------------------------------------------
+//  read_into - read a whole file from the start
+//  into a buffer, which then backs the file until
+//  it is closed; a ZIPped file not yet loaded is
+//  inflated straight into the buffer
+//-------------------------------------------------
+
+UINT32 emu_file::read_into(void *buffer, UINT32 length)
+{
+	// anything other than an unloaded ZIP just reads normally
+	if (m_zipfile == NULL || m_file != NULL || length < m_ziplength)
+		return read(buffer, length);
+
+	// inflate straight into the buffer
+	if (zip_file_decompress(m_zipfile, buffer, m_ziplength) != ZIPERR_NONE)
+		return 0;
+
+	// wrap the buffer as our file, positioned after what we've read
+	if (core_fopen_ram(buffer, m_ziplength, m_openflags, &m_file) != FILERR_NONE)
+		return 0;
+	core_fseek(m_file, m_ziplength, SEEK_SET);
+
+	// close out the ZIP file
+	zip_file_close(m_zipfile);
+	m_zipfile = NULL;
+	return m_ziplength;
+}
+
+
 //-------------------------------------------------
 //  getc - read a character from a file
 //-------------------------------------------------
@@ -728,23 +757,16 @@ file_error emu_file::attempt_zipped()
 			continue;
 
 		// see if we can find a file with the right name and (if available) crc
-		const zip_file_header *header;
-		for (header = zip_file_first_file(zip); header != NULL; header = zip_file_next_file(zip))
-			if (zip_filename_match(*header, filename) && (!(m_openflags & OPEN_FLAG_HAS_CRC) || header->crc == m_crc))
-				break;
+		const zip_file_header *header = zip_file_find(zip, filename, m_crc, (m_openflags & OPEN_FLAG_HAS_CRC) ? (ZIP_FIND_NAME | ZIP_FIND_CRC) : ZIP_FIND_NAME);
 
 		// if that failed, look for a file with the right crc, but the wrong filename
 		if (header == NULL && (m_openflags & OPEN_FLAG_HAS_CRC))
-			for (header = zip_file_first_file(zip); header != NULL; header = zip_file_next_file(zip))
-				if (header->crc == m_crc && !zip_header_is_path(*header))
-					break;
+			header = zip_file_find(zip, filename, m_crc, ZIP_FIND_CRC);
 
 		// if that failed, look for a file with the right name; reporting a bad checksum
 		// is more helpful and less confusing than reporting "rom not found"
-		if (header == NULL)
-			for (header = zip_file_first_file(zip); header != NULL; header = zip_file_next_file(zip))
-				if (zip_filename_match(*header, filename))
-					break;
+		if (header == NULL && (m_openflags & OPEN_FLAG_HAS_CRC))
+			header = zip_file_find(zip, filename, m_crc, ZIP_FIND_NAME);
 
 		// if we got it, read the data
 		if (header != NULL)
@@ -802,29 +824,6 @@ file_error emu_file::load_zipped_file()
 }
 
 
-//-------------------------------------------------
-//  zip_filename_match - compare zip filename
-//  to expected filename, ignoring any directory
-//-------------------------------------------------
-
-bool emu_file::zip_filename_match(const zip_file_header &header, const astring &filename)
-{
-	const char *zipfile = header.filename + header.filename_length - filename.len();
-	return (zipfile >= header.filename && filename.icmp(zipfile) == 0 && (zipfile == header.filename || zipfile[-1] == '/'));
-}
-
-
-//-------------------------------------------------
-//  zip_header_is_path - check whether filename
-//  in header is a path
-//-------------------------------------------------
-
-bool emu_file::zip_header_is_path(const zip_file_header &header)
-{
-	const char *zipfile = header.filename + header.filename_length - 1;
-	return (zipfile >= header.filename && zipfile[0] == '/');
-}
-
 //-------------------------------------------------
 //  attempt__7zped - attempt to open a .7z file
 //-------------------------------------------------
@@ -153,6 +153,7 @@ public:
 
 	// reading
 	UINT32 read(void *buffer, UINT32 length);
+	UINT32 read_into(void *buffer, UINT32 length);
 	int getc();
 	int ungetc(int c);
 	char *gets(char *s, int n);
@@ -169,8 +170,6 @@ private:
 	// internal helpers
 	file_error attempt_zipped();
 	file_error load_zipped_file();
-	bool zip_filename_match(const zip_file_header &header, const astring &filename);
-	bool zip_header_is_path(const zip_file_header &header);
 
 	file_error attempt__7zped();
 	file_error load__7zped_file();
@@ -104,6 +104,7 @@
 #include "debugger.h"
 #include "render.h"
 #include "cheat.h"
+#include "rewind.h"
 #include "uimain.h"
 #include "uiinput.h"
 #include "crsshair.h"
@@ -150,6 +151,7 @@ running_machine::running_machine(const machine_config &_config, osd_interface &o
 	  m_system(_config.gamedrv()),
 	  m_osd(osd),
 	  m_cheat(NULL),
+	  m_rewind(NULL),
 	  m_render(NULL),
 	  m_input(NULL),
 	  m_sound(NULL),
@@ -168,9 +170,18 @@ running_machine::running_machine(const machine_config &_config, osd_interface &o
 	  m_basename(_config.gamedrv().name),
 	  m_sample_rate(_config.options().sample_rate()),
 	  m_logfile(NULL),
+	  m_checksum_file(NULL),
+	  m_checksum_frame(~(UINT64)0),
 	  m_saveload_schedule(SLS_NONE),
 	  m_saveload_schedule_time(attotime::zero),
 	  m_saveload_searchpath(NULL),
+	  m_saveload_buffer(NULL),
+	  m_saveload_buffer_size(0),
+	  m_saveload_buffer_compress(false),
+	  m_saveload_base(NULL),
+	  m_saveload_base_size(0),
+	  m_saveload_buffer_result(STATERR_NOT_REQUESTED),
+	  m_saveload_buffer_actual(0),
 	  m_logerror_list(m_respool),
 
 	  m_save(*this),
@@ -358,6 +369,9 @@ void running_machine::start()
 	// set up the cheat engine
 	m_cheat = auto_alloc(*this, cheat_manager(*this));
 
+	// set up the rewind history
+	m_rewind = auto_alloc(*this, rewind_manager(*this));
+
     announce_init_phase(STARTUP_PHASE_INITIALIZING_STATE, 80);
 
 	// disallow save state registrations starting here
@@ -390,6 +404,7 @@ device_t &running_machine::add_dynamic_device(device_t &owner, device_type type,
 int running_machine::run(bool firstrun, bool benchmarking)
 {
 	int error = MAMERR_NONE;
+	bool sampling = false;
 
 	// use try/catch for deep error recovery
 	try
@@ -406,6 +421,22 @@ int running_machine::run(bool firstrun, bool benchmarking)
 			add_logerror_callback(logfile_callback);
 		}
 
+		// if we are logging state checksums, open that file too
+		if (options().state_checksums() != NULL && options().state_checksums()[0] != 0)
+		{
+			m_checksum_file = auto_alloc(*this, emu_file(OPEN_FLAG_WRITE | OPEN_FLAG_CREATE | OPEN_FLAG_CREATE_PATHS));
+			file_error filerr = m_checksum_file->open(options().state_checksums());
+			assert_always(filerr == FILERR_NONE, "unable to open state checksum file");
+		}
+
+		// if we are writing a sampled profile, start sampling
+		if (options().profile_samples() != NULL && options().profile_samples()[0] != 0)
+		{
+			sampling = g_sampling_profiler.start(options().profile_sample_rate());
+			if (!sampling)
+				mame_printf_warning("Unable to start the sampling profiler\n");
+		}
+
 		// then finish setting up our local machine
 		start();
 
@@ -450,6 +481,13 @@ int running_machine::run(bool firstrun, bool benchmarking)
 			if (m_saveload_schedule != SLS_NONE)
 				handle_saveload();
 
+			// capture or restore rewind history
+			m_rewind->update();
+
+			// log the state for comparing against other runs
+			if (m_checksum_file != NULL)
+				log_state_checksum();
+
 			g_profiler.stop();
 		}
 
@@ -483,11 +521,21 @@ int running_machine::run(bool firstrun, bool benchmarking)
 	// in case we got here via exception
 	m_current_phase = MACHINE_PHASE_EXIT;
 
+	// stop sampling and write out the profile, if we started it
+	if (sampling)
+	{
+		g_sampling_profiler.stop();
+		emu_file file(OPEN_FLAG_WRITE | OPEN_FLAG_CREATE | OPEN_FLAG_CREATE_PATHS);
+		if (file.open(options().profile_samples()) == FILERR_NONE)
+			g_sampling_profiler.write_json(*this, file);
+	}
+
 	// call all exit callbacks registered
 	call_notifiers(MACHINE_NOTIFY_EXIT);
 	zip_file_cache_clear();
 
-	// close the logfile
+	// close the logfiles
+	auto_free(*this, m_checksum_file);
 	auto_free(*this, m_logfile);
 	return error;
 }
@@ -572,6 +620,11 @@ void running_machine::schedule_new_driver(const game_driver &driver)
 
 void running_machine::set_saveload_filename(const char *filename)
 {
+	// a file operation replaces any pending in-memory one
+	if (m_saveload_buffer != NULL)
+		m_saveload_buffer_result = STATERR_CANCELLED;
+	m_saveload_buffer = NULL;
+
 	// free any existing request and allocate a copy of the requested name
 	if (osd_is_absolute_path(filename))
 	{
@@ -624,6 +677,87 @@ void running_machine::schedule_load(const char *filename)
 }
 
 
+//-------------------------------------------------
+//  schedule_save - schedule a save into a block
+//  of memory to occur as soon as possible; the
+//  memory must remain valid until it happens
+//-------------------------------------------------
+
+void running_machine::schedule_save(void *buffer, UINT32 size, bool compress)
+{
+	// no file is involved
+	m_saveload_pending_file.reset();
+	m_saveload_searchpath = NULL;
+	m_saveload_buffer = (UINT8 *)buffer;
+	m_saveload_buffer_size = size;
+	m_saveload_buffer_compress = compress;
+	m_saveload_base = NULL;
+	m_saveload_buffer_result = STATERR_PENDING;
+	m_saveload_buffer_actual = 0;
+
+	// note the start time and set a timer for the next timeslice to actually schedule it
+	m_saveload_schedule = SLS_SAVE;
+	m_saveload_schedule_time = this->time();
+
+	// we can't be paused since we need to clear out anonymous timers
+	resume();
+}
+
+
+//-------------------------------------------------
+//  schedule_load - schedule a load from a block
+//  of memory to occur as soon as possible; the
+//  memory must remain valid until it happens
+//-------------------------------------------------
+
+void running_machine::schedule_load(const void *buffer, UINT32 size)
+{
+	// no file is involved
+	m_saveload_pending_file.reset();
+	m_saveload_searchpath = NULL;
+	m_saveload_buffer = (UINT8 *)buffer;
+	m_saveload_buffer_size = size;
+	m_saveload_base = NULL;
+	m_saveload_buffer_result = STATERR_PENDING;
+	m_saveload_buffer_actual = 0;
+
+	// note the start time and set a timer for the next timeslice to actually schedule it
+	m_saveload_schedule = SLS_LOAD;
+	m_saveload_schedule_time = this->time();
+
+	// we can't be paused since we need to clear out anonymous timers
+	resume();
+}
+
+
+//-------------------------------------------------
+//  schedule_save_delta - schedule a save of only
+//  what differs from an uncompressed in-memory
+//  state into a block of memory
+//-------------------------------------------------
+
+void running_machine::schedule_save_delta(const void *base, UINT32 basesize, void *buffer, UINT32 size)
+{
+	schedule_save(buffer, size, false);
+	m_saveload_base = (const UINT8 *)base;
+	m_saveload_base_size = basesize;
+}
+
+
+//-------------------------------------------------
+//  schedule_load_delta - schedule a load of an
+//  uncompressed in-memory state plus a delta
+//  against it
+//-------------------------------------------------
+
+void running_machine::schedule_load_delta(const void *base, UINT32 basesize, const void *buffer, UINT32 size)
+{
+	schedule_load(buffer, size);
+	m_saveload_base = (const UINT8 *)base;
+	m_saveload_base_size = basesize;
+}
+
+
 //-------------------------------------------------
 //  pause - pause the system
 //-------------------------------------------------
@@ -788,9 +922,9 @@ void running_machine::handle_saveload()
 	const char *opname = (m_saveload_schedule == SLS_LOAD) ? "load" : "save";
 	file_error filerr = FILERR_NONE;
 
-	// if no name, bail
+	// if no name and no buffer, bail
 	emu_file file(m_saveload_searchpath, openflags);
-	if (!m_saveload_pending_file)
+	if (!m_saveload_pending_file && m_saveload_buffer == NULL)
 		goto cancel;
 
 	// if there are anonymous timers, we can't save just yet, and we can't load yet either
@@ -801,11 +935,28 @@ void running_machine::handle_saveload()
 		if ((this->time() - m_saveload_schedule_time) > attotime::from_seconds(1))
 		{
 			popmessage("Unable to %s due to pending anonymous timers. See error.log for details.", opname);
+			if (m_saveload_buffer != NULL)
+				m_saveload_buffer_result = STATERR_CANCELLED;
 			goto cancel;
 		}
 		return;
 	}
 
+	// in-memory operations never touch the filesystem, and report their
+	// result to the caller rather than to the user
+	if (m_saveload_buffer != NULL)
+	{
+		if (m_saveload_base != NULL && m_saveload_schedule == SLS_LOAD)
+			m_saveload_buffer_result = m_save.read_delta(m_saveload_base, m_saveload_base_size, m_saveload_buffer, m_saveload_buffer_size);
+		else if (m_saveload_base != NULL)
+			m_saveload_buffer_result = m_save.write_delta(m_saveload_base, m_saveload_base_size, m_saveload_buffer, m_saveload_buffer_size, m_saveload_buffer_actual);
+		else if (m_saveload_schedule == SLS_LOAD)
+			m_saveload_buffer_result = m_save.read_buffer(m_saveload_buffer, m_saveload_buffer_size);
+		else
+			m_saveload_buffer_result = m_save.write_buffer(m_saveload_buffer, m_saveload_buffer_size, m_saveload_buffer_actual, m_saveload_buffer_compress);
+		goto cancel;
+	}
+
 	// open the file
 	filerr = file.open(m_saveload_pending_file);
 	if (filerr == FILERR_NONE)
@@ -855,10 +1006,32 @@ void running_machine::handle_saveload()
 cancel:
 	m_saveload_pending_file.reset();
 	m_saveload_searchpath = NULL;
+	m_saveload_buffer = NULL;
+	m_saveload_base = NULL;
 	m_saveload_schedule = SLS_NONE;
 }
 
 
+//-------------------------------------------------
+//  log_state_checksum - log a checksum of the
+//  machine state once per frame, so that two runs
+//  which should be identical can be compared
+//-------------------------------------------------
+
+void running_machine::log_state_checksum()
+{
+	// once per frame, and only when the state could be saved
+	if (primary_screen == NULL)
+		return;
+	UINT64 frame = primary_screen->frame_number();
+	if (frame == m_checksum_frame || !m_scheduler.can_save())
+		return;
+
+	m_checksum_frame = frame;
+	m_checksum_file->printf("%" I64FMT "u %s %08X\n", frame, time().as_string(), save().checksum());
+}
+
+
 //-------------------------------------------------
 //  soft_reset - actually perform a soft-reset
 //  of the system
@@ -154,6 +154,7 @@ const int DEBUG_FLAG_OSD_ENABLED	= 0x00001000;		// The OSD debugger is enabled
 class gfx_element;
 class colortable_t;
 class cheat_manager;
+class rewind_manager;
 class render_manager;
 class sound_manager;
 class video_manager;
@@ -232,6 +233,7 @@ public:
 	memory_manager &memory() { return m_memory; }
 	ioport_manager &ioport() { return m_ioport; }
 	cheat_manager &cheat() const { assert(m_cheat != NULL); return *m_cheat; }
+	rewind_manager &rewind() const { assert(m_rewind != NULL); return *m_rewind; }
 	render_manager &render() const { assert(m_render != NULL); return *m_render; }
 	input_manager &input() const { assert(m_input != NULL); return *m_input; }
 	sound_manager &sound() const { assert(m_sound != NULL); return *m_sound; }
@@ -250,7 +252,8 @@ public:
 	bool ui_active() const { return m_ui_active; }
 	const char *basename() const { return m_basename; }
 	int sample_rate() const { return m_sample_rate; }
-	bool save_or_load_pending() const { return m_saveload_pending_file; }
+	bool save_or_load_pending() const { return m_saveload_pending_file || m_saveload_buffer != NULL; }
+	save_error saveload_buffer_result(UINT32 &actual) const { actual = m_saveload_buffer_actual; return m_saveload_buffer_result; }
 	screen_device *first_screen() const { return primary_screen; }
 
 	// additional helpers
@@ -282,6 +285,10 @@ public:
 	void schedule_new_driver(const game_driver &driver);
 	void schedule_save(const char *filename);
 	void schedule_load(const char *filename);
+	void schedule_save(void *buffer, UINT32 size, bool compress);
+	void schedule_load(const void *buffer, UINT32 size);
+	void schedule_save_delta(const void *base, UINT32 basesize, void *buffer, UINT32 size);
+	void schedule_load_delta(const void *base, UINT32 basesize, const void *buffer, UINT32 size);
 
 	// date & time
 	void base_datetime(system_time &systime);
@@ -328,6 +335,7 @@ private:
 	void set_saveload_filename(const char *filename);
 	void fill_systime(system_time &systime, time_t t);
 	void handle_saveload();
+	void log_state_checksum();
 	void soft_reset(void *ptr = NULL, INT32 param = 0);
 	void watchdog_fired(void *ptr = NULL, INT32 param = 0);
 	void watchdog_vblank(screen_device &screen, bool vblank_state);
@@ -349,6 +357,7 @@ private:
 
 	// managers
 	cheat_manager *			m_cheat;				// internal data from cheat.c
+	rewind_manager *		m_rewind;				// internal data from rewind.c
 	render_manager *		m_render;				// internal data from render.c
 	input_manager *			m_input;				// internal data from input.c
 	sound_manager *			m_sound;				// internal data from sound.c
@@ -380,6 +389,8 @@ private:
 	astring					m_context;				// context string buffer
 	int						m_sample_rate;			// the digital audio sample rate
 	emu_file *				m_logfile;				// pointer to the active log file
+	emu_file *				m_checksum_file;		// pointer to the active state checksum log
+	UINT64					m_checksum_frame;		// frame of the last logged state checksum
 
 	// load/save management
 	enum saveload_schedule
@@ -392,6 +403,13 @@ private:
 	attotime				m_saveload_schedule_time;
 	astring					m_saveload_pending_file;
 	const char *			m_saveload_searchpath;
+	UINT8 *					m_saveload_buffer;		// memory to save to/load from instead of a file
+	UINT32					m_saveload_buffer_size;
+	bool					m_saveload_buffer_compress;
+	const UINT8 *			m_saveload_base;		// base state for delta save/load, or NULL
+	UINT32					m_saveload_base_size;
+	save_error				m_saveload_buffer_result;	// result of the last in-memory save/load
+	UINT32					m_saveload_buffer_actual;	// bytes written by the last in-memory save
 
 	// notifier callbacks
 	struct notifier_callback_item
@@ -137,6 +137,7 @@ public:
 	// public state
 	attotime				m_minimum_quantum;			// minimum scheduling quantum
 	const char *			m_perfect_cpu_quantum;		// tag of CPU to use for "perfect" scheduling
+	bool					m_parallel_execution;		// can executing devices run concurrently within a quantum?
 	INT32					m_watchdog_vblank_count;	// number of VBLANKs until the watchdog kills us
 	attotime				m_watchdog_time;			// length of time until the watchdog kills us
 
@@ -235,6 +236,12 @@ ATTR_COLD device_t *MACHINE_CONFIG_NAME(_name)(machine_config &config, device_t
 #define MCFG_QUANTUM_PERFECT_CPU(_cputag) \
 	config.m_perfect_cpu_quantum = _cputag; \
 
+// declares that the executing devices share no memory or other state that
+// they touch while executing, other than through timers, so that they may
+// be run on separate threads up to each quantum boundary
+#define MCFG_PARALLEL_EXECUTION() \
+	config.m_parallel_execution = true; \
+
 
 // watchdog configuration
 #define MCFG_WATCHDOG_VBLANK_INIT(_count) \
@@ -1132,6 +1132,8 @@ public:
 		{
 			_NativeType *dest = reinterpret_cast<_NativeType *>(handler.ramptr(offset));
 			*dest = (*dest & ~mask) | (data & mask);
+			if (m_dirty != NULL)
+				mark_dirty(byteaddress);
 		}
 		else if (sizeof(_NativeType) == 1) handler.write8(*this, offset, data, mask);
 		else if (sizeof(_NativeType) == 2) handler.write16(*this, offset >> 1, data, mask);
@@ -1153,7 +1155,12 @@ public:
 
 		// either write directly to RAM, or call the delegate
 		offset = handler.byteoffset(byteaddress);
-		if (entry <= STATIC_BANKMAX) *reinterpret_cast<_NativeType *>(handler.ramptr(offset)) = data;
+		if (entry <= STATIC_BANKMAX)
+		{
+			*reinterpret_cast<_NativeType *>(handler.ramptr(offset)) = data;
+			if (m_dirty != NULL)
+				mark_dirty(byteaddress);
+		}
 		else if (sizeof(_NativeType) == 1) handler.write8(*this, offset, data, 0xff);
 		else if (sizeof(_NativeType) == 2) handler.write16(*this, offset >> 1, data, 0xffff);
 		else if (sizeof(_NativeType) == 4) handler.write32(*this, offset >> 2, data, 0xffffffff);
@@ -1673,6 +1680,9 @@ address_space::address_space(memory_manager &manager, device_memory_interface &m
 	  m_name(memory.space_config(spacenum)->name()),
 	  m_addrchars((m_config.m_addrbus_width + 3) / 4),
 	  m_logaddrchars((m_config.m_logaddr_width + 3) / 4),
+	  m_dirty(NULL),
+	  m_dirty_shift(0),
+	  m_dirty_pages(0),
 	  m_manager(manager),
 	  m_machine(memory.device().machine())
 {
@@ -1687,6 +1697,7 @@ address_space::address_space(memory_manager &manager, device_memory_interface &m
 
 address_space::~address_space()
 {
+	auto_free(machine(), m_dirty);
 	global_free(&m_direct);
 	global_free(m_map);
 }
@@ -2105,6 +2116,47 @@ void address_space::allocate_memory()
 }
 
 
+//-------------------------------------------------
+//  enable_write_tracking - start tracking which
+//  pages of RAM, ROM and banks are written
+//-------------------------------------------------
+
+void address_space::enable_write_tracking(int granularity)
+{
+	// pages must hold a whole native access
+	granularity = MAX(granularity, 3);
+	granularity = MIN(granularity, 31);
+
+	disable_write_tracking();
+	m_dirty_shift = granularity;
+	m_dirty_pages = (m_bytemask >> granularity) + 1;
+	m_dirty = auto_alloc_array_clear(machine(), UINT32, (m_dirty_pages + 31) / 32);
+}
+
+
+//-------------------------------------------------
+//  disable_write_tracking - stop tracking writes
+//-------------------------------------------------
+
+void address_space::disable_write_tracking()
+{
+	auto_free(machine(), m_dirty);
+	m_dirty = NULL;
+	m_dirty_pages = 0;
+}
+
+
+//-------------------------------------------------
+//  reset_dirty - mark every tracked page clean
+//-------------------------------------------------
+
+void address_space::reset_dirty()
+{
+	if (m_dirty != NULL)
+		memset(m_dirty, 0, ((m_dirty_pages + 31) / 32) * sizeof(m_dirty[0]));
+}
+
+
 //-------------------------------------------------
 //  locate_memory - find all the requested
 //  pointers into the final allocated memory
@@ -347,6 +347,16 @@ public:
 	virtual void enable_read_watchpoints(bool enable = true) = 0;
 	virtual void enable_write_watchpoints(bool enable = true) = 0;
 
+	// write tracking of RAM, ROM and banks, as a bitmap of pages of 1 << granularity bytes
+	void enable_write_tracking(int granularity = 12);
+	void disable_write_tracking();
+	bool write_tracking() const { return (m_dirty != NULL); }
+	int dirty_granularity() const { return m_dirty_shift; }
+	UINT32 dirty_pages() const { return m_dirty_pages; }
+	const UINT32 *dirty_bitmap() const { return m_dirty; }
+	bool page_dirty(UINT32 page) const { return (m_dirty != NULL && (m_dirty[page >> 5] & (1U << (page & 31))) != 0); }
+	void reset_dirty();
+
 	// general accessors
 	virtual void accessors(data_accessors &accessors) const = 0;
 	virtual void *get_read_ptr(offs_t byteaddress) = 0;
@@ -556,6 +566,12 @@ protected:
 	const char *			m_name;				// friendly name of the address space
 	UINT8					m_addrchars;		// number of characters to use for physical addresses
 	UINT8					m_logaddrchars;		// number of characters to use for logical addresses
+	UINT32 *				m_dirty;			// bitmap of written pages, or NULL if not tracking
+	int						m_dirty_shift;		// number of address bits within a tracked page
+	UINT32					m_dirty_pages;		// number of tracked pages
+
+	// mark the tracked page containing a byte address as written
+	void mark_dirty(offs_t byteaddress) { UINT32 page = byteaddress >> m_dirty_shift; m_dirty[page >> 5] |= 1U << (page & 31); }
 
 private:
 	memory_manager &		m_manager;			// reference to the owning manager
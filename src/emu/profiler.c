@@ -72,6 +72,53 @@ struct profile_string
 //**************************************************************************
 
 profiler_state g_profiler;
+sampling_profiler g_sampling_profiler;
+volatile UINT32 g_profiler_sample_generation;
+PROFILER_THREAD_LOCAL profiler_thread_state *g_profiler_thread;
+PROFILER_THREAD_LOCAL UINT32 g_profiler_thread_generation;
+PROFILER_THREAD_LOCAL bool g_profiler_parallel_thread;
+
+// states of the sampled threads, and their histograms, written only by the sampler
+static profiler_thread_state s_thread_states[PROFILER_SAMPLE_THREADS];
+static UINT32 s_thread_samples[PROFILER_SAMPLE_THREADS][PROFILER_SAMPLE_BUCKETS];
+
+// state of a thread that found no free sampled state; it is never read
+static PROFILER_THREAD_LOCAL profiler_thread_state s_unsampled_thread_state;
+
+// generation of the most recent sampling run
+static UINT32 s_last_generation;
+
+// display names of the non-device types
+static const profile_string names[] =
+{
+	{ PROFILER_DRC_COMPILE,      "DRC Compilation" },
+	{ PROFILER_MEM_REMAP,        "Memory Remapping" },
+	{ PROFILER_MEMREAD,          "Memory Read" },
+	{ PROFILER_MEMWRITE,         "Memory Write" },
+	{ PROFILER_VIDEO,            "Video Update" },
+	{ PROFILER_DRAWGFX,          "drawgfx" },
+	{ PROFILER_COPYBITMAP,       "copybitmap" },
+	{ PROFILER_TILEMAP_DRAW,     "Tilemap Draw" },
+	{ PROFILER_TILEMAP_DRAW_ROZ, "Tilemap ROZ Draw" },
+	{ PROFILER_TILEMAP_UPDATE,   "Tilemap Update" },
+	{ PROFILER_BLIT,             "OSD Blitting" },
+	{ PROFILER_SOUND,            "Sound Generation" },
+	{ PROFILER_TIMER_CALLBACK,   "Timer Callbacks" },
+	{ PROFILER_INPUT,            "Input Processing" },
+	{ PROFILER_MOVIE_REC,        "Movie Recording" },
+	{ PROFILER_LOGERROR,         "Error Logging" },
+	{ PROFILER_EXTRA,            "Unaccounted/Overhead" },
+	{ PROFILER_USER1,            "User 1" },
+	{ PROFILER_USER2,            "User 2" },
+	{ PROFILER_USER3,            "User 3" },
+	{ PROFILER_USER4,            "User 4" },
+	{ PROFILER_USER5,            "User 5" },
+	{ PROFILER_USER6,            "User 6" },
+	{ PROFILER_USER7,            "User 7" },
+	{ PROFILER_USER8,            "User 8" },
+	{ PROFILER_PROFILER,         "Profiler" },
+	{ PROFILER_IDLE,             "Idle" }
+};
 
 
 
@@ -105,6 +152,7 @@ real_profiler_state::real_profiler_state()
 {
 	memset(m_filo, 0, sizeof(m_filo));
 	memset(m_data, 0, sizeof(m_data));
+	memset(m_total, 0, sizeof(m_total));
 }
 
 
@@ -135,6 +183,7 @@ void real_profiler_state::real_start(profile_type type)
 	{
 		filo_entry &preventry = m_filo[index - 1];
 		data.duration[preventry.type] += curticks - preventry.start;
+		m_total[preventry.type] += curticks - preventry.start;
 	}
 
 	// fill in this entry
@@ -160,6 +209,7 @@ void real_profiler_state::real_stop()
 		// account for the time taken
 		history_data &data = m_data[m_dataindex];
 		data.duration[entry.type] += curticks - entry.start;
+		m_total[entry.type] += curticks - entry.start;
 
 		// if we have a previous entry, restart his time now
 		if (index != 0)
@@ -177,37 +227,6 @@ void real_profiler_state::real_stop()
 
 const char *real_profiler_state::text(running_machine &machine, astring &string)
 {
-	static const profile_string names[] =
-	{
-		{ PROFILER_DRC_COMPILE,      "DRC Compilation" },
-		{ PROFILER_MEM_REMAP,        "Memory Remapping" },
-		{ PROFILER_MEMREAD,          "Memory Read" },
-		{ PROFILER_MEMWRITE,         "Memory Write" },
-		{ PROFILER_VIDEO,            "Video Update" },
-		{ PROFILER_DRAWGFX,          "drawgfx" },
-		{ PROFILER_COPYBITMAP,       "copybitmap" },
-		{ PROFILER_TILEMAP_DRAW,     "Tilemap Draw" },
-		{ PROFILER_TILEMAP_DRAW_ROZ, "Tilemap ROZ Draw" },
-		{ PROFILER_TILEMAP_UPDATE,   "Tilemap Update" },
-		{ PROFILER_BLIT,             "OSD Blitting" },
-		{ PROFILER_SOUND,            "Sound Generation" },
-		{ PROFILER_TIMER_CALLBACK,   "Timer Callbacks" },
-		{ PROFILER_INPUT,            "Input Processing" },
-		{ PROFILER_MOVIE_REC,        "Movie Recording" },
-		{ PROFILER_LOGERROR,         "Error Logging" },
-		{ PROFILER_EXTRA,            "Unaccounted/Overhead" },
-		{ PROFILER_USER1,            "User 1" },
-		{ PROFILER_USER2,            "User 2" },
-		{ PROFILER_USER3,            "User 3" },
-		{ PROFILER_USER4,            "User 4" },
-		{ PROFILER_USER5,            "User 5" },
-		{ PROFILER_USER6,            "User 6" },
-		{ PROFILER_USER7,            "User 7" },
-		{ PROFILER_USER8,            "User 8" },
-		{ PROFILER_PROFILER,         "Profiler" },
-		{ PROFILER_IDLE,             "Idle" }
-	};
-
 	g_profiler.start(PROFILER_PROFILER);
 
 	// compute the total time for all bits, not including profiler or idle
@@ -255,12 +274,11 @@ const char *real_profiler_state::text(running_machine &machine, astring &string)
 			if (curtype >= PROFILER_DEVICE_FIRST && curtype <= PROFILER_DEVICE_MAX)
 				string.catprintf("'%s'", iter.byindex(curtype - PROFILER_DEVICE_FIRST)->tag());
 			else
-				for (int nameindex = 0; nameindex < ARRAY_LENGTH(names); nameindex++)
-					if (names[nameindex].type == curtype)
-					{
-						string.cat(names[nameindex].string);
-						break;
-					}
+			{
+				const char *name = profiler_type_name(curtype);
+				if (name != NULL)
+					string.cat(name);
+			}
 
 			// followed by a carriage return
 			string.cat("\n");
@@ -287,3 +305,273 @@ const char *real_profiler_state::text(running_machine &machine, astring &string)
 	g_profiler.stop();
 	return string;
 }
+
+
+
+//**************************************************************************
+//  SAMPLING PROFILER
+//**************************************************************************
+
+//-------------------------------------------------
+//  sampling_profiler - constructor
+//-------------------------------------------------
+
+sampling_profiler::sampling_profiler()
+	: m_queue(NULL),
+	  m_exiting(false),
+	  m_rate(0),
+	  m_samples(0),
+	  m_start_ticks(0),
+	  m_stop_ticks(0)
+{
+}
+
+
+//-------------------------------------------------
+//  start - start sampling every thread's current
+//  type the given number of times per second
+//-------------------------------------------------
+
+bool sampling_profiler::start(UINT32 rate)
+{
+	if (running())
+		return false;
+
+	// start each histogram over, with no state read until a thread claims it for this run
+	memset(s_thread_samples, 0, sizeof(s_thread_samples));
+	for (int index = 0; index < PROFILER_SAMPLE_THREADS; index++)
+		s_thread_states[index].registered = false;
+	m_samples = 0;
+
+	// the OSDs can't sleep reliably for much less than a few milliseconds, so cap the rate
+	m_rate = (rate > 0) ? MIN(rate, PROFILER_MAX_SAMPLE_RATE) : PROFILER_MAX_SAMPLE_RATE;
+	m_exiting = false;
+
+	// the sampler loop runs for as long as sampling does, so give it a queue of its own
+	m_queue = osd_work_queue_alloc(WORK_QUEUE_FLAG_IO);
+	if (m_queue == NULL)
+		return false;
+	m_start_ticks = osd_ticks();
+
+	// threads only record their types from here on, each starting with an empty stack
+	if (++s_last_generation == 0)
+		s_last_generation = 1;
+	g_profiler_sample_generation = s_last_generation;
+	osd_work_item_queue(m_queue, sample_loop, this, WORK_ITEM_FLAG_AUTO_RELEASE);
+	return true;
+}
+
+
+//-------------------------------------------------
+//  stop - stop sampling, keeping the histograms
+//-------------------------------------------------
+
+void sampling_profiler::stop()
+{
+	if (!running())
+		return;
+
+	g_profiler_sample_generation = 0;
+	m_exiting = true;
+	// if the loop is somehow still running, leave its queue alone rather than free it under it
+	if (osd_work_queue_wait(m_queue, 10 * osd_ticks_per_second()))
+		osd_work_queue_free(m_queue);
+	m_queue = NULL;
+	m_stop_ticks = osd_ticks();
+}
+
+
+//-------------------------------------------------
+//  sample_loop - body of the sampler thread
+//-------------------------------------------------
+
+void *sampling_profiler::sample_loop(void *param, int threadid)
+{
+	sampling_profiler *profiler = reinterpret_cast<sampling_profiler *>(param);
+	osd_ticks_t period = osd_ticks_per_second() / profiler->m_rate;
+	if (period == 0)
+		period = 1;
+
+	// sleep until each sample is due; an OSD whose sleep returns early, or does
+	// nothing, makes this spin, but the samples still come no faster than the rate
+	osd_ticks_t next = osd_ticks() + period;
+	while (!profiler->m_exiting)
+	{
+		for (osd_ticks_t now = osd_ticks(); now < next && !profiler->m_exiting; now = osd_ticks())
+			osd_sleep(next - now);
+		next += period;
+
+		// count each registered thread's current type
+		for (int index = 0; index < PROFILER_SAMPLE_THREADS; index++)
+		{
+			profiler_thread_state &state = s_thread_states[index];
+			if (state.registered)
+			{
+				UINT32 current = state.current;
+				s_thread_samples[index][MIN(current, (UINT32)PROFILER_TOTAL)]++;
+			}
+		}
+		profiler->m_samples++;
+	}
+	return NULL;
+}
+
+
+//-------------------------------------------------
+//  write_json - write the histograms, one per
+//  thread and one for all threads together, as a
+//  JSON object
+//-------------------------------------------------
+
+void sampling_profiler::write_json(running_machine &machine, emu_file &file)
+{
+	osd_ticks_t elapsed = (running() ? osd_ticks() : m_stop_ticks) - m_start_ticks;
+
+	// sum the threads' histograms
+	UINT64 totals[PROFILER_SAMPLE_BUCKETS] = { 0 };
+	for (int index = 0; index < PROFILER_SAMPLE_THREADS; index++)
+		for (int type = 0; type < PROFILER_SAMPLE_BUCKETS; type++)
+			totals[type] += s_thread_samples[index][type];
+
+	file.printf("{\n");
+	file.printf("\t\"rate\": %u,\n", m_rate);
+	file.printf("\t\"measured_rate\": %.1f,\n", (elapsed > 0) ? (double)m_samples * (double)osd_ticks_per_second() / (double)elapsed : 0.0);
+	file.printf("\t\"seconds\": %.3f,\n", (double)elapsed / (double)osd_ticks_per_second());
+	file.printf("\t\"samples\": %" I64FMT "u,\n", m_samples);
+	file.printf("\t\"total\": ");
+	write_json_buckets(machine, file, totals);
+	file.printf(",\n\t\"threads\": [");
+
+	// states are handed out afresh each run, so each entry is really a thread slot
+	bool first = true;
+	for (int index = 0; index < PROFILER_SAMPLE_THREADS; index++)
+	{
+		UINT64 samples[PROFILER_SAMPLE_BUCKETS];
+		bool any = false;
+		for (int type = 0; type < PROFILER_SAMPLE_BUCKETS; type++)
+			any |= ((samples[type] = s_thread_samples[index][type]) != 0);
+		if (!any)
+			continue;
+
+		file.printf("%s\n\t\t{ \"thread\": %d, \"buckets\": ", first ? "" : ",", index);
+		write_json_buckets(machine, file, samples);
+		file.printf(" }");
+		first = false;
+	}
+	file.printf("\n\t]\n}\n");
+}
+
+
+//-------------------------------------------------
+//  write_json_buckets - write the nonzero entries
+//  of a histogram as a JSON object keyed by the
+//  name of each type
+//-------------------------------------------------
+
+void sampling_profiler::write_json_buckets(running_machine &machine, emu_file &file, const UINT64 *samples)
+{
+	execute_interface_iterator iter(machine.root_device());
+	astring name;
+	bool first = true;
+
+	file.printf("{");
+	for (int type = 0; type < PROFILER_SAMPLE_BUCKETS; type++)
+	{
+		if (samples[type] == 0)
+			continue;
+
+		// devices are named by their tags, like the profiler display does
+		if (type == PROFILER_TOTAL)
+			name.cpy("(none)");
+		else if (type >= PROFILER_DEVICE_FIRST && type <= PROFILER_DEVICE_MAX)
+		{
+			device_execute_interface *exec = iter.byindex(type - PROFILER_DEVICE_FIRST);
+			if (exec != NULL)
+				name.cpy("'").cat(exec->device().tag()).cat("'");
+			else
+				name.printf("device %d", type - PROFILER_DEVICE_FIRST);
+		}
+		else
+		{
+			const char *typestr = profiler_type_name(profile_type(type));
+			name.cpy((typestr != NULL) ? typestr : "unknown");
+		}
+
+		// escape the name as a JSON string
+		file.printf("%s \"", first ? "" : ",");
+		for (const char *c = name.cstr(); *c != 0; c++)
+		{
+			if (*c == '"' || *c == '\\')
+				file.printf("\\%c", *c);
+			else if ((UINT8)*c < 0x20)
+				file.printf("\\u%04x", (UINT8)*c);
+			else
+				file.printf("%c", *c);
+		}
+		file.printf("\": %" I64FMT "u", samples[type]);
+		first = false;
+	}
+	file.printf(" }");
+}
+
+
+
+//**************************************************************************
+//  GLOBAL HELPERS
+//**************************************************************************
+
+//-------------------------------------------------
+//  profiler_type_name - return the display name
+//  of a non-device profiler type, or NULL
+//-------------------------------------------------
+
+const char *profiler_type_name(profile_type type)
+{
+	for (int nameindex = 0; nameindex < ARRAY_LENGTH(names); nameindex++)
+		if (names[nameindex].type == type)
+			return names[nameindex].string;
+	return NULL;
+}
+
+
+//-------------------------------------------------
+//  profiler_thread_register - give the current
+//  thread a state for the sampler to read, with
+//  an empty stack for the given sampling run
+//
+//  States are handed out afresh for each run:
+//  a thread keeps its state from the last run
+//  if no other thread has claimed it since, and
+//  otherwise claims any not yet claimed in this
+//  run. So threads that have exited, or that no
+//  longer profile, give up their states without
+//  having to be told.
+//-------------------------------------------------
+
+profiler_thread_state *profiler_thread_register(UINT32 generation)
+{
+	profiler_thread_state *state = g_profiler_thread;
+	if (state == NULL || state == &s_unsampled_thread_state || compare_exchange32(&state->owner_generation, g_profiler_thread_generation, generation) != (INT32)g_profiler_thread_generation)
+	{
+		state = &s_unsampled_thread_state;
+		for (int index = 0; index < PROFILER_SAMPLE_THREADS; index++)
+		{
+			INT32 owner = s_thread_states[index].owner_generation;
+			if (owner != (INT32)generation && compare_exchange32(&s_thread_states[index].owner_generation, owner, generation) == owner)
+			{
+				state = &s_thread_states[index];
+				break;
+			}
+		}
+	}
+
+	// start the stack over; the sampler may be reading, so the type is reset first
+	state->current = PROFILER_TOTAL;
+	state->depth = 0;
+	state->overflow = 0;
+	state->registered = (state != &s_unsampled_thread_state);
+
+	g_profiler_thread = state;
+	g_profiler_thread_generation = generation;
+	return state;
+}
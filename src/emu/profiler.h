@@ -48,6 +48,13 @@
 
     the profiler handles a FILO list so calls may be nested.
 
+    Independently of the above, while sampling is running every thread
+    records which type it is currently in, and a sampler thread reads
+    those records at a fixed rate and builds a histogram per thread.
+    This costs almost nothing on the profiled threads and so can be left
+    running in production; when sampling is not running, each start and
+    stop costs only a test of one global.
+
 ***************************************************************************/
 
 #pragma once
@@ -100,12 +107,123 @@ enum profile_type
 };
 DECLARE_ENUM_OPERATORS(profile_type);
 
+// the sampler's histograms have one extra bucket for time outside any type
+const int PROFILER_SAMPLE_BUCKETS = PROFILER_TOTAL + 1;
+
+// maximum number of threads whose current type is sampled
+const int PROFILER_SAMPLE_THREADS = 32;
+
+// highest rate the sampler runs at, in samples per second
+const UINT32 PROFILER_MAX_SAMPLE_RATE = 250;
+
+
+
+//**************************************************************************
+//  MACROS
+//**************************************************************************
+
+#ifdef _MSC_VER
+#define PROFILER_THREAD_LOCAL __declspec(thread)
+#else
+#define PROFILER_THREAD_LOCAL __thread
+#endif
+
 
 
 //**************************************************************************
 //  TYPE DEFINITIONS
 //**************************************************************************
 
+class emu_file;
+
+
+// ======================> profiler_thread_state
+
+// the type a thread is currently in, as read by the sampler
+struct profiler_thread_state
+{
+	volatile UINT32		current;					// type the thread is in, or PROFILER_TOTAL for none
+	UINT32				depth;						// number of entries on the stack
+	UINT32				overflow;					// number of starts beyond a full stack
+	UINT16				stack[16];					// types to return to on each stop
+	volatile bool		registered;					// true once the sampler may read this state
+	volatile INT32		owner_generation;			// sampling generation in which a thread last claimed this state
+};
+
+
+// nonzero while sampling, and different each time sampling starts
+extern volatile UINT32 g_profiler_sample_generation;
+
+// this thread's state, and the sampling generation it was claimed for
+extern PROFILER_THREAD_LOCAL profiler_thread_state *g_profiler_thread;
+extern PROFILER_THREAD_LOCAL UINT32 g_profiler_thread_generation;
+
+profiler_thread_state *profiler_thread_register(UINT32 generation);
+
+// true on threads executing devices alongside the main thread, which the
+// FILO profiler ignores since it is not thread safe
+extern PROFILER_THREAD_LOCAL bool g_profiler_parallel_thread;
+
+
+//-------------------------------------------------
+//  profiler_mark_start - record that the current
+//  thread has entered the given type; this does
+//  nothing unless sampling is running
+//-------------------------------------------------
+
+inline void profiler_mark_start(profile_type type)
+{
+	UINT32 generation = g_profiler_sample_generation;
+	if (generation == 0)
+		return;
+
+	// a stack left over from an earlier sampling run starts over
+	profiler_thread_state *state = g_profiler_thread;
+	if (g_profiler_thread_generation != generation)
+		state = profiler_thread_register(generation);
+
+	// past the end of the stack, only count how far, so each stop is matched
+	UINT32 depth = state->depth;
+	if (depth < ARRAY_LENGTH(state->stack))
+	{
+		state->stack[depth] = state->current;
+		state->depth = depth + 1;
+		state->current = type;
+	}
+	else
+		state->overflow++;
+}
+
+
+//-------------------------------------------------
+//  profiler_mark_stop - record that the current
+//  thread has left its current type
+//-------------------------------------------------
+
+inline void profiler_mark_stop()
+{
+	UINT32 generation = g_profiler_sample_generation;
+	if (generation == 0)
+		return;
+
+	// ignore stops whose starts were not recorded in this sampling run
+	if (g_profiler_thread_generation != generation)
+		return;
+	profiler_thread_state *state = g_profiler_thread;
+
+	if (state->overflow > 0)
+		state->overflow--;
+	else
+	{
+		UINT32 depth = state->depth;
+		if (depth > 0)
+		{
+			state->depth = --depth;
+			state->current = state->stack[depth];
+		}
+	}
+}
+
 
 // ======================> real_profiler_state
 
@@ -120,6 +238,7 @@ public:
 	// getters
 	bool enabled() const { return m_enabled; }
 	const char *text(running_machine &machine, astring &string);
+	osd_ticks_t total(profile_type type) const { return m_total[type]; }
 
 	// enable/disable
 	void enable(bool state = true)
@@ -131,13 +250,14 @@ public:
 			{
 				m_dataready = false;
 				m_filoindex = m_dataindex = 0;
+				memset(m_total, 0, sizeof(m_total));
 			}
 		}
 	}
 
 	// start/stop
-	void start(profile_type type) { if (m_enabled) real_start(type); }
-	void stop() { if (m_enabled) real_stop(); }
+	void start(profile_type type) { profiler_mark_start(type); if (m_enabled && !g_profiler_parallel_thread) real_start(type); }
+	void stop() { profiler_mark_stop(); if (m_enabled && !g_profiler_parallel_thread) real_stop(); }
 
 private:
 	void real_start(profile_type type);
@@ -164,6 +284,7 @@ private:
 	UINT8				m_dataindex;				// current data index
 	filo_entry			m_filo[16];					// array of FILO entries
 	history_data		m_data[16];					// array of data
+	osd_ticks_t			m_total[PROFILER_TOTAL];	// duration spent in each entry since enabled
 };
 
 
@@ -178,13 +299,53 @@ public:
 	// getters
 	bool enabled() const { return false; }
 	const char *text(running_machine &machine, astring &string) { return string.cpy(""); }
+	osd_ticks_t total(profile_type type) const { return 0; }
 
 	// enable/disable
 	void enable(bool state = true) { }
 
 	// start/stop
-	void start(profile_type type) { }
-	void stop() { }
+	void start(profile_type type) { profiler_mark_start(type); }
+	void stop() { profiler_mark_stop(); }
+};
+
+
+// ======================> sampling_profiler
+
+// the threads it samples are those of the whole process, so there is only
+// ever one, g_sampling_profiler, and only one machine may use it at a time
+class sampling_profiler
+{
+public:
+	// construction/destruction
+	sampling_profiler();
+
+	// getters
+	bool running() const { return m_queue != NULL; }
+	UINT64 samples() const { return m_samples; }
+
+	// start/stop sampling; start fails if sampling is already running
+	bool start(UINT32 rate);
+	void stop();
+
+	// output
+	void write_json(running_machine &machine, emu_file &file);
+
+private:
+	static void *sample_loop(void *param, int threadid);
+	void write_json_buckets(running_machine &machine, emu_file &file, const UINT64 *samples);
+
+	// internal state
+	osd_work_queue *	m_queue;					// queue running the sampler loop
+	volatile bool		m_exiting;					// set to tell the sampler loop to exit
+	UINT32				m_rate;						// samples per second
+	volatile UINT64		m_samples;					// number of samples taken since started
+	osd_ticks_t			m_start_ticks;				// time sampling started
+	osd_ticks_t			m_stop_ticks;				// time sampling stopped
+
+	// there is only one
+	sampling_profiler(const sampling_profiler &);
+	sampling_profiler &operator=(const sampling_profiler &);
 };
 
 
@@ -203,6 +364,15 @@ typedef dummy_profiler_state profiler_state;
 //**************************************************************************
 
 extern profiler_state g_profiler;
+extern sampling_profiler g_sampling_profiler;
+
+
+
+//**************************************************************************
+//  FUNCTION PROTOTYPES
+//**************************************************************************
+
+const char *profiler_type_name(profile_type type);
 
 
 #endif	/* __PROFILER_H__ */
@@ -39,11 +39,23 @@
 
 
 #include "emucore.h"
+#include "osdcore.h"
 #include "eminline.h"
 #include "video/rgbutil.h"
 #include "render.h"
 
 
+// the SSE2 row kernels are built where SSE2 is baseline; rendersw_test builds
+// this file both with and without them to check that they draw the same pixels
+#ifndef RENDERSW_ROW_KERNELS
+#if (defined(__SSE2__) && defined(PTR64))
+#define RENDERSW_ROW_KERNELS	1
+#else
+#define RENDERSW_ROW_KERNELS	0
+#endif
+#endif
+
+
 template<typename _PixelType, int _SrcShiftR, int _SrcShiftG, int _SrcShiftB, int _DstShiftR, int _DstShiftG, int _DstShiftB, bool _NoDestRead = false, bool _BilinearFilter = false>
 class software_renderer
 {
@@ -57,6 +69,20 @@ private:
 		INT32			endx, endy;
 	};
 
+	// a horizontal band of the destination, rendered by one work item
+	struct band_data
+	{
+		const render_primitive_list *primlist;
+		_PixelType *	dstdata;
+		INT32			width, height;
+		UINT32			pitch;
+		INT32			miny, maxy;
+	};
+
+	// banding parameters
+	static const int MIN_BAND_HEIGHT = 16;
+	static const int MAX_BANDS = 64;
+
 	// internal helpers
 	static inline bool is_opaque(float alpha) { return (alpha >= (_NoDestRead ? 0.5f : 1.0f)); }
 	static inline bool is_transparent(float alpha) { return (alpha < (_NoDestRead ? 0.5f : 0.0001f)); }
@@ -373,14 +399,28 @@ private:
 
 
 	//-------------------------------------------------
-	//  draw_line - draw a line or point
+	//  cosine_table - return the table used to size
+	//  antialiased beams, building it on first use
 	//-------------------------------------------------
 
-	static void draw_line(const render_primitive &prim, _PixelType *dstdata, INT32 width, INT32 height, UINT32 pitch)
+	static const UINT32 *cosine_table()
 	{
-		// internal tables
 		static UINT32 s_cosine_table[2049];
 
+		// build up the cosine table if we haven't yet
+		if (s_cosine_table[0] == 0)
+			for (int entry = 0; entry <= 2048; entry++)
+				s_cosine_table[entry] = int(double(1.0 / cos(atan(double(entry) / 2048.0))) * 0x10000000 + 0.5);
+		return s_cosine_table;
+	}
+
+
+	//-------------------------------------------------
+	//  draw_line - draw a line or point
+	//-------------------------------------------------
+
+	static void draw_line(const render_primitive &prim, _PixelType *dstdata, INT32 width, INT32 height, UINT32 pitch, INT32 miny, INT32 maxy)
+	{
 		// compute the start/end coordinates
 		int x1 = int(prim.bounds.x0 * 65536.0f);
 		int y1 = int(prim.bounds.y0 * 65536.0f);
@@ -392,11 +432,7 @@ private:
 
 		if (PRIMFLAG_GET_ANTIALIAS(prim.flags))
 		{
-			// build up the cosine table if we haven't yet
-			if (s_cosine_table[0] == 0)
-				for (int entry = 0; entry <= 2048; entry++)
-					s_cosine_table[entry] = int(double(1.0 / cos(atan(double(entry) / 2048.0))) * 0x10000000 + 0.5);
-
+			const UINT32 *cosine = cosine_table();
 			int beam = prim.width * 65536.0f;
 			if (beam < 0x00010000)
 				beam = 0x00010000;
@@ -413,7 +449,7 @@ private:
 					dy--;
 				x1 >>= 16;
 				int xx = x2 >> 16;
-				int bwidth = mul_32x32_hi(beam << 4, s_cosine_table[abs(sy) >> 5]);
+				int bwidth = mul_32x32_hi(beam << 4, cosine[abs(sy) >> 5]);
 				y1 -= bwidth >> 1; // start back half the diameter
 				for (;;)
 				{
@@ -421,7 +457,7 @@ private:
 					{
 						dx = bwidth;    // init diameter of beam
 						dy = y1 >> 16;
-						if (dy >= 0 && dy < height)
+						if (dy >= miny && dy < maxy)
 							draw_aa_pixel(dstdata, pitch, x1, dy, apply_intensity(0xff & (~y1 >> 8), col));
 						dy++;
 						dx -= 0x10000 - (0xffff & y1); // take off amount plotted
@@ -429,11 +465,11 @@ private:
 						dx >>= 16;                   // adjust to pixel (solid) count
 						while (dx--)                 // plot rest of pixels
 						{
-							if (dy >= 0 && dy < height)
+							if (dy >= miny && dy < maxy)
 								draw_aa_pixel(dstdata, pitch, x1, dy, col);
 							dy++;
 						}
-						if (dy >= 0 && dy < height)
+						if (dy >= miny && dy < maxy)
 							draw_aa_pixel(dstdata, pitch, x1, dy, apply_intensity(a1,col));
 					}
 					if (x1 == xx) break;
@@ -449,11 +485,11 @@ private:
 					dx--;
 				y1 >>= 16;
 				int yy = y2 >> 16;
-				int bwidth = mul_32x32_hi(beam << 4,s_cosine_table[abs(sx) >> 5]);
+				int bwidth = mul_32x32_hi(beam << 4,cosine[abs(sx) >> 5]);
 				x1 -= bwidth >> 1; // start back half the width
 				for (;;)
 				{
-					if (y1 >= 0 && y1 < height)
+					if (y1 >= miny && y1 < maxy)
 					{
 						dy = bwidth;    // calc diameter of beam
 						dx = x1 >> 16;
@@ -496,7 +532,7 @@ private:
 			{
 				for (;;)
 				{
-					if (x1 >= 0 && x1 < width && y1 >= 0 && y1 < height)
+					if (x1 >= 0 && x1 < width && y1 >= miny && y1 < maxy)
 						draw_aa_pixel(dstdata, pitch, x1, y1, col);
 					if (x1 == x2) break;
 					x1 += sx;
@@ -512,7 +548,7 @@ private:
 			{
 				for (;;)
 				{
-					if (x1 >= 0 && x1 < width && y1 >= 0 && y1 < height)
+					if (x1 >= 0 && x1 < width && y1 >= miny && y1 < maxy)
 						draw_aa_pixel(dstdata, pitch, x1, y1, col);
 					if (y1 == y2) break;
 					y1 += sy;
@@ -537,7 +573,7 @@ private:
 	//  draw_rect - draw a solid rectangle
 	//-------------------------------------------------
 
-	static void draw_rect(const render_primitive &prim, _PixelType *dstdata, INT32 width, INT32 height, UINT32 pitch)
+	static void draw_rect(const render_primitive &prim, _PixelType *dstdata, INT32 width, INT32 height, UINT32 pitch, INT32 miny, INT32 maxy)
 	{
 		render_bounds fpos = prim.bounds;
 		assert(fpos.x0 <= fpos.x1);
@@ -559,6 +595,10 @@ private:
 		if (endy < 0) endy = 0;
 		if (endy >= height) endy = height;
 
+		// clip to the band
+		if (starty < miny) starty = miny;
+		if (endy > maxy) endy = maxy;
+
 		// bail if nothing left
 		if (fpos.x0 > fpos.x1 || fpos.y0 > fpos.y1)
 			return;
@@ -633,6 +673,163 @@ private:
 	}
 
 
+	//**************************************************************************
+	//  SSE2 ROW KERNELS
+	//**************************************************************************
+
+#if RENDERSW_ROW_KERNELS
+
+	//-------------------------------------------------
+	//  use_row_kernels - return true if the rows of
+	//  a quad can go through the vector kernels: an
+	//  unfiltered, standard 32bpp destination, and a
+	//  texture walked along a single row
+	//-------------------------------------------------
+
+	static inline bool use_row_kernels(const quad_setup_data &setup)
+	{
+		return (sizeof(_PixelType) == 4 && !_BilinearFilter && setup.dvdx == 0 &&
+				_SrcShiftR == 0 && _SrcShiftG == 0 && _SrcShiftB == 0 &&
+				_DstShiftR == 16 && _DstShiftG == 8 && _DstShiftB == 0);
+	}
+
+
+	//-------------------------------------------------
+	//  fetch_texels_sse2 - return four texels from
+	//  a texture row; SSE2 has no gather, so only the
+	//  coordinates are stepped as a vector
+	//-------------------------------------------------
+
+	static inline __m128i fetch_texels_sse2(const UINT32 *texrow, const rgb_t *palette, __m128i u)
+	{
+		__m128i index = _mm_srai_epi32(u, 16);
+		INT32 i0 = _mm_cvtsi128_si32(index);
+		INT32 i1 = _mm_cvtsi128_si32(_mm_shuffle_epi32(index, _MM_SHUFFLE(1,1,1,1)));
+		INT32 i2 = _mm_cvtsi128_si32(_mm_shuffle_epi32(index, _MM_SHUFFLE(2,2,2,2)));
+		INT32 i3 = _mm_cvtsi128_si32(_mm_shuffle_epi32(index, _MM_SHUFFLE(3,3,3,3)));
+		return _mm_set_epi32(texrow[i3], texrow[i2], texrow[i1], texrow[i0]);
+	}
+
+	static inline __m128i fetch_texels_sse2(const UINT16 *texrow, const rgb_t *palette, __m128i u)
+	{
+		__m128i index = _mm_srai_epi32(u, 16);
+		INT32 i0 = _mm_cvtsi128_si32(index);
+		INT32 i1 = _mm_cvtsi128_si32(_mm_shuffle_epi32(index, _MM_SHUFFLE(1,1,1,1)));
+		INT32 i2 = _mm_cvtsi128_si32(_mm_shuffle_epi32(index, _MM_SHUFFLE(2,2,2,2)));
+		INT32 i3 = _mm_cvtsi128_si32(_mm_shuffle_epi32(index, _MM_SHUFFLE(3,3,3,3)));
+		return _mm_set_epi32(palette[texrow[i3]], palette[texrow[i2]], palette[texrow[i1]], palette[texrow[i0]]);
+	}
+
+
+	//-------------------------------------------------
+	//  copy_row_sse2 - copy texels straight to the
+	//  destination; returns the number of pixels
+	//  written, leaving any remainder to the caller
+	//-------------------------------------------------
+
+	template<typename _TexelType>
+	static INT32 copy_row_sse2(_PixelType *dest, const render_texinfo &texture, INT32 curu, INT32 curv, INT32 dudx, INT32 count)
+	{
+		const _TexelType *texrow = reinterpret_cast<const _TexelType *>(texture.base) + (curv >> 16) * texture.rowpixels;
+		const rgb_t *palette = texture.palette;
+
+		// unscaled direct texels are just a copy
+		if (sizeof(_TexelType) == 4 && dudx == 0x10000)
+		{
+			memcpy(dest, texrow + (curu >> 16), count * sizeof(_PixelType));
+			return count;
+		}
+
+		__m128i u = _mm_set_epi32(curu + 3 * dudx, curu + 2 * dudx, curu + dudx, curu);
+		__m128i step = _mm_set1_epi32(4 * dudx);
+		INT32 x;
+		for (x = 0; x + 4 <= count; x += 4)
+		{
+			_mm_storeu_si128((__m128i *)&dest[x], fetch_texels_sse2(texrow, palette, u));
+			u = _mm_add_epi32(u, step);
+		}
+		return x;
+	}
+
+
+	//-------------------------------------------------
+	//  scale_row_sse2 - scale texels by constant
+	//  per-channel factors and blend them over the
+	//  destination as (s * scale + d * inva) >> 8;
+	//  each scale + inva must be at most 0x100 so the
+	//  sums fit in 16 bits
+	//-------------------------------------------------
+
+	template<typename _TexelType>
+	static INT32 scale_row_sse2(_PixelType *dest, const render_texinfo &texture, INT32 curu, INT32 curv, INT32 dudx, INT32 count, UINT32 sr, UINT32 sg, UINT32 sb, UINT32 inva)
+	{
+		const _TexelType *texrow = reinterpret_cast<const _TexelType *>(texture.base) + (curv >> 16) * texture.rowpixels;
+		const rgb_t *palette = texture.palette;
+		__m128i u = _mm_set_epi32(curu + 3 * dudx, curu + 2 * dudx, curu + dudx, curu);
+		__m128i step = _mm_set1_epi32(4 * dudx);
+		__m128i scale = _mm_set_epi16(0, sr, sg, sb, 0, sr, sg, sb);
+		__m128i invscale = _mm_set_epi16(0, inva, inva, inva, 0, inva, inva, inva);
+		__m128i zero = _mm_setzero_si128();
+		INT32 x;
+		for (x = 0; x + 4 <= count; x += 4)
+		{
+			__m128i pix = fetch_texels_sse2(texrow, palette, u);
+			__m128i dpix = _NoDestRead ? zero : _mm_loadu_si128((__m128i *)&dest[x]);
+			__m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(pix, zero), scale), _mm_mullo_epi16(_mm_unpacklo_epi8(dpix, zero), invscale));
+			__m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(pix, zero), scale), _mm_mullo_epi16(_mm_unpackhi_epi8(dpix, zero), invscale));
+			_mm_storeu_si128((__m128i *)&dest[x], _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8)));
+			u = _mm_add_epi32(u, step);
+		}
+		return x;
+	}
+
+
+	//-------------------------------------------------
+	//  alpha_row_sse2 - blend ARGB texels over the
+	//  destination by their own alpha, leaving fully
+	//  transparent pixels untouched; this reads the
+	//  destination, so it is not for _NoDestRead
+	//-------------------------------------------------
+
+	static INT32 alpha_row_sse2(_PixelType *dest, const render_texinfo &texture, INT32 curu, INT32 curv, INT32 dudx, INT32 count)
+	{
+		const UINT32 *texrow = reinterpret_cast<const UINT32 *>(texture.base) + (curv >> 16) * texture.rowpixels;
+		__m128i u = _mm_set_epi32(curu + 3 * dudx, curu + 2 * dudx, curu + dudx, curu);
+		__m128i step = _mm_set1_epi32(4 * dudx);
+		__m128i rgbmask = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+		__m128i one = _mm_set1_epi16(0x100);
+		__m128i alphamask = _mm_set1_epi32(0xff000000);
+		__m128i zero = _mm_setzero_si128();
+		INT32 x;
+		for (x = 0; x + 4 <= count; x += 4)
+		{
+			__m128i pix = fetch_texels_sse2(texrow, NULL, u);
+			__m128i dpix = _mm_loadu_si128((__m128i *)&dest[x]);
+
+			// low two pixels
+			__m128i s = _mm_unpacklo_epi8(pix, zero);
+			__m128i ta = _mm_and_si128(_mm_shufflehi_epi16(_mm_shufflelo_epi16(s, _MM_SHUFFLE(3,3,3,3)), _MM_SHUFFLE(3,3,3,3)), rgbmask);
+			__m128i invta = _mm_and_si128(_mm_sub_epi16(one, ta), rgbmask);
+			__m128i lo = _mm_add_epi16(_mm_mullo_epi16(s, ta), _mm_mullo_epi16(_mm_unpacklo_epi8(dpix, zero), invta));
+
+			// high two pixels
+			s = _mm_unpackhi_epi8(pix, zero);
+			ta = _mm_and_si128(_mm_shufflehi_epi16(_mm_shufflelo_epi16(s, _MM_SHUFFLE(3,3,3,3)), _MM_SHUFFLE(3,3,3,3)), rgbmask);
+			invta = _mm_and_si128(_mm_sub_epi16(one, ta), rgbmask);
+			__m128i hi = _mm_add_epi16(_mm_mullo_epi16(s, ta), _mm_mullo_epi16(_mm_unpackhi_epi8(dpix, zero), invta));
+
+			// keep the destination wherever the texel has no alpha
+			__m128i result = _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8));
+			__m128i keep = _mm_cmpeq_epi32(_mm_and_si128(pix, alphamask), zero);
+			_mm_storeu_si128((__m128i *)&dest[x], _mm_or_si128(_mm_and_si128(keep, dpix), _mm_andnot_si128(keep, result)));
+			u = _mm_add_epi32(u, step);
+		}
+		return x;
+	}
+
+#endif
+
+
 	//**************************************************************************
 	//  16-BIT PALETTE RASTERIZERS
 	//**************************************************************************
@@ -654,6 +851,10 @@ private:
 		// fast case: no coloring, no alpha
 		if (prim.color.r >= 1.0f && prim.color.g >= 1.0f && prim.color.b >= 1.0f && is_opaque(prim.color.a))
 		{
+#if RENDERSW_ROW_KERNELS
+			bool vectorize = use_row_kernels(setup);
+#endif
+
 			// loop over rows
 			for (INT32 y = setup.starty; y < setup.endy; y++)
 			{
@@ -661,8 +862,20 @@ private:
 				INT32 curu = setup.startu + (y - setup.starty) * setup.dudy;
 				INT32 curv = setup.startv + (y - setup.starty) * setup.dvdy;
 
+				INT32 x = setup.startx;
+#if RENDERSW_ROW_KERNELS
+				// let the row kernel take whole groups of pixels first
+				if (vectorize)
+				{
+					INT32 count = copy_row_sse2<UINT16>(dest, prim.texture, curu, curv, dudx, endx - x);
+					dest += count;
+					curu += count * dudx;
+					x += count;
+				}
+#endif
+
 				// loop over cols
-				for (INT32 x = setup.startx; x < endx; x++)
+				for ( ; x < endx; x++)
 				{
 					UINT32 pix = get_texel_palette16(prim.texture, curu, curv);
 					*dest++ = source32_to_dest(pix);
@@ -684,6 +897,10 @@ private:
 			if (sg > 0x100) { if (INT32(sg) < 0) sg = 0; else sg = 0x100; }
 			if (sb > 0x100) { if (INT32(sb) < 0) sb = 0; else sb = 0x100; }
 
+#if RENDERSW_ROW_KERNELS
+			bool vectorize = use_row_kernels(setup);
+#endif
+
 			// loop over rows
 			for (INT32 y = setup.starty; y < setup.endy; y++)
 			{
@@ -691,8 +908,20 @@ private:
 				INT32 curu = setup.startu + (y - setup.starty) * setup.dudy;
 				INT32 curv = setup.startv + (y - setup.starty) * setup.dvdy;
 
+				INT32 x = setup.startx;
+#if RENDERSW_ROW_KERNELS
+				// let the row kernel take whole groups of pixels first
+				if (vectorize)
+				{
+					INT32 count = scale_row_sse2<UINT16>(dest, prim.texture, curu, curv, dudx, endx - x, sr, sg, sb, 0);
+					dest += count;
+					curu += count * dudx;
+					x += count;
+				}
+#endif
+
 				// loop over cols
-				for (INT32 x = setup.startx; x < endx; x++)
+				for ( ; x < endx; x++)
 				{
 					UINT32 pix = get_texel_palette16(prim.texture, curu, curv);
 					UINT32 r = (source32_r(pix) * sr) >> 8;
@@ -720,6 +949,11 @@ private:
 			if (sb > 0x100) { if (INT32(sb) < 0) sb = 0; else sb = 0x100; }
 			if (invsa > 0x100) { if (INT32(invsa) < 0) invsa = 0; else invsa = 0x100; }
 
+#if RENDERSW_ROW_KERNELS
+			// the row kernel works in 16 bits, which only holds while no channel can exceed 255
+			bool vectorize = use_row_kernels(setup) && sr + invsa <= 0x100 && sg + invsa <= 0x100 && sb + invsa <= 0x100;
+#endif
+
 			// loop over rows
 			for (INT32 y = setup.starty; y < setup.endy; y++)
 			{
@@ -727,8 +961,20 @@ private:
 				INT32 curu = setup.startu + (y - setup.starty) * setup.dudy;
 				INT32 curv = setup.startv + (y - setup.starty) * setup.dvdy;
 
+				INT32 x = setup.startx;
+#if RENDERSW_ROW_KERNELS
+				// let the row kernel take whole groups of pixels first
+				if (vectorize)
+				{
+					INT32 count = scale_row_sse2<UINT16>(dest, prim.texture, curu, curv, dudx, endx - x, sr, sg, sb, invsa);
+					dest += count;
+					curu += count * dudx;
+					x += count;
+				}
+#endif
+
 				// loop over cols
-				for (INT32 x = setup.startx; x < endx; x++)
+				for ( ; x < endx; x++)
 				{
 					UINT32 pix = get_texel_palette16(prim.texture, curu, curv);
 					UINT32 dpix = _NoDestRead ? 0 : *dest;
@@ -1119,6 +1365,10 @@ private:
 		// fast case: no coloring, no alpha
 		if (prim.color.r >= 1.0f && prim.color.g >= 1.0f && prim.color.b >= 1.0f && is_opaque(prim.color.a))
 		{
+#if RENDERSW_ROW_KERNELS
+			bool vectorize = use_row_kernels(setup);
+#endif
+
 			// loop over rows
 			for (INT32 y = setup.starty; y < setup.endy; y++)
 			{
@@ -1129,8 +1379,20 @@ private:
 				// no lookup case
 				if (palbase == NULL)
 				{
+					INT32 x = setup.startx;
+#if RENDERSW_ROW_KERNELS
+					// let the row kernel take whole groups of pixels first
+					if (vectorize)
+					{
+						INT32 count = copy_row_sse2<UINT32>(dest, prim.texture, curu, curv, dudx, endx - x);
+						dest += count;
+						curu += count * dudx;
+						x += count;
+					}
+#endif
+
 					// loop over cols
-					for (INT32 x = setup.startx; x < endx; x++)
+					for ( ; x < endx; x++)
 					{
 						UINT32 pix = get_texel_rgb32(prim.texture, curu, curv);
 						*dest++ = source32_to_dest(pix);
@@ -1170,6 +1432,10 @@ private:
 			if (sg > 0x100) { if (INT32(sg) < 0) sg = 0; else sg = 0x100; }
 			if (sb > 0x100) { if (INT32(sb) < 0) sb = 0; else sb = 0x100; }
 
+#if RENDERSW_ROW_KERNELS
+			bool vectorize = use_row_kernels(setup);
+#endif
+
 			// loop over rows
 			for (INT32 y = setup.starty; y < setup.endy; y++)
 			{
@@ -1180,8 +1446,20 @@ private:
 				// no lookup case
 				if (palbase == NULL)
 				{
+					INT32 x = setup.startx;
+#if RENDERSW_ROW_KERNELS
+					// let the row kernel take whole groups of pixels first
+					if (vectorize)
+					{
+						INT32 count = scale_row_sse2<UINT32>(dest, prim.texture, curu, curv, dudx, endx - x, sr, sg, sb, 0);
+						dest += count;
+						curu += count * dudx;
+						x += count;
+					}
+#endif
+
 					// loop over cols
-					for (INT32 x = setup.startx; x < endx; x++)
+					for ( ; x < endx; x++)
 					{
 						UINT32 pix = get_texel_rgb32(prim.texture, curu, curv);
 						UINT32 r = (source32_r(pix) * sr) >> 8;
@@ -1227,6 +1505,11 @@ private:
 			if (sb > 0x100) { if (INT32(sb) < 0) sb = 0; else sb = 0x100; }
 			if (invsa > 0x100) { if (INT32(invsa) < 0) invsa = 0; else invsa = 0x100; }
 
+#if RENDERSW_ROW_KERNELS
+			// the row kernel works in 16 bits, which only holds while no channel can exceed 255
+			bool vectorize = use_row_kernels(setup) && sr + invsa <= 0x100 && sg + invsa <= 0x100 && sb + invsa <= 0x100;
+#endif
+
 			// loop over rows
 			for (INT32 y = setup.starty; y < setup.endy; y++)
 			{
@@ -1237,8 +1520,20 @@ private:
 				// no lookup case
 				if (palbase == NULL)
 				{
+					INT32 x = setup.startx;
+#if RENDERSW_ROW_KERNELS
+					// let the row kernel take whole groups of pixels first
+					if (vectorize)
+					{
+						INT32 count = scale_row_sse2<UINT32>(dest, prim.texture, curu, curv, dudx, endx - x, sr, sg, sb, invsa);
+						dest += count;
+						curu += count * dudx;
+						x += count;
+					}
+#endif
+
 					// loop over cols
-					for (INT32 x = setup.startx; x < endx; x++)
+					for ( ; x < endx; x++)
 					{
 						UINT32 pix = get_texel_rgb32(prim.texture, curu, curv);
 						UINT32 dpix = _NoDestRead ? 0 : *dest;
@@ -1427,6 +1722,10 @@ private:
 		// fast case: no coloring, no alpha
 		if (prim.color.r >= 1.0f && prim.color.g >= 1.0f && prim.color.b >= 1.0f && is_opaque(prim.color.a))
 		{
+#if RENDERSW_ROW_KERNELS
+			bool vectorize = use_row_kernels(setup) && !_NoDestRead;
+#endif
+
 			// loop over rows
 			for (INT32 y = setup.starty; y < setup.endy; y++)
 			{
@@ -1437,8 +1736,20 @@ private:
 				// no lookup case
 				if (palbase == NULL)
 				{
+					INT32 x = setup.startx;
+#if RENDERSW_ROW_KERNELS
+					// let the row kernel take whole groups of pixels first
+					if (vectorize)
+					{
+						INT32 count = alpha_row_sse2(dest, prim.texture, curu, curv, dudx, endx - x);
+						dest += count;
+						curu += count * dudx;
+						x += count;
+					}
+#endif
+
 					// loop over cols
-					for (INT32 x = setup.startx; x < endx; x++)
+					for ( ; x < endx; x++)
 					{
 						UINT32 pix = get_texel_argb32(prim.texture, curu, curv);
 						UINT32 ta = pix >> 24;
@@ -1840,7 +2151,7 @@ private:
 	//  drawing routine
 	//-------------------------------------------------
 
-	static void setup_and_draw_textured_quad(const render_primitive &prim, _PixelType *dstdata, INT32 width, INT32 height, UINT32 pitch)
+	static void setup_and_draw_textured_quad(const render_primitive &prim, _PixelType *dstdata, INT32 width, INT32 height, UINT32 pitch, INT32 miny, INT32 maxy)
 	{
 		assert(prim.bounds.x0 <= prim.bounds.x1);
 		assert(prim.bounds.y0 <= prim.bounds.y1);
@@ -1887,6 +2198,15 @@ private:
 			setup.startv -= 0x8000;
 		}
 
+		// clip to the band, stepping U/V down to the first row so every row samples as before
+		if (setup.starty < miny)
+		{
+			setup.startu += (miny - setup.starty) * setup.dudy;
+			setup.startv += (miny - setup.starty) * setup.dvdy;
+			setup.starty = miny;
+		}
+		if (setup.endy > maxy) setup.endy = maxy;
+
 		// render based on the texture coordinates
 		switch (prim.flags & (PRIMFLAG_TEXFORMAT_MASK | PRIMFLAG_BLENDMODE_MASK))
 		{
@@ -1941,30 +2261,115 @@ private:
 	//**************************************************************************
 
 	//-------------------------------------------------
-	//  draw_primitives - draw a series of primitives
-	//  using a software rasterizer
+	//  draw_band_primitives - draw a series of
+	//  primitives, clipped to rows miny..maxy-1
 	//-------------------------------------------------
 
-public:
-	static void draw_primitives(const render_primitive_list &primlist, void *dstdata, UINT32 width, UINT32 height, UINT32 pitch)
+	static void draw_band_primitives(const render_primitive_list &primlist, _PixelType *dstdata, INT32 width, INT32 height, UINT32 pitch, INT32 miny, INT32 maxy)
 	{
 		// loop over the list and render each element
 		for (const render_primitive *prim = primlist.first(); prim != NULL; prim = prim->next())
-			switch (prim->type)
-			{
-				case render_primitive::LINE:
-					draw_line(*prim, reinterpret_cast<_PixelType *>(dstdata), width, height, pitch);
-					break;
-
-				case render_primitive::QUAD:
-					if (!prim->texture.base)
-						draw_rect(*prim, reinterpret_cast<_PixelType *>(dstdata), width, height, pitch);
-					else
-						setup_and_draw_textured_quad(*prim, reinterpret_cast<_PixelType *>(dstdata), width, height, pitch);
-					break;
-
-				default:
-					throw emu_fatalerror("Unexpected render_primitive type");
-			}
+			draw_band_primitive(*prim, dstdata, width, height, pitch, miny, maxy);
+	}
+
+
+	//-------------------------------------------------
+	//  draw_band_primitive - draw a single primitive,
+	//  clipped to rows miny..maxy-1
+	//-------------------------------------------------
+
+	static void draw_band_primitive(const render_primitive &prim, _PixelType *dstdata, INT32 width, INT32 height, UINT32 pitch, INT32 miny, INT32 maxy)
+	{
+		switch (prim.type)
+		{
+			case render_primitive::LINE:
+				draw_line(prim, dstdata, width, height, pitch, miny, maxy);
+				break;
+
+			case render_primitive::QUAD:
+				if (!prim.texture.base)
+					draw_rect(prim, dstdata, width, height, pitch, miny, maxy);
+				else
+					setup_and_draw_textured_quad(prim, dstdata, width, height, pitch, miny, maxy);
+				break;
+
+			default:
+				throw emu_fatalerror("Unexpected render_primitive type");
+		}
+	}
+
+
+	//-------------------------------------------------
+	//  draw_band - work item callback that draws a
+	//  single band
+	//-------------------------------------------------
+
+	static void *draw_band(void *param, int threadid)
+	{
+		band_data &band = *reinterpret_cast<band_data *>(param);
+		draw_band_primitives(*band.primlist, band.dstdata, band.width, band.height, band.pitch, band.miny, band.maxy);
+		return NULL;
+	}
+
+
+public:
+	//-------------------------------------------------
+	//  draw_primitive - draw a single primitive
+	//  using a software rasterizer
+	//-------------------------------------------------
+
+	static void draw_primitive(const render_primitive &prim, void *dstdata, UINT32 width, UINT32 height, UINT32 pitch)
+	{
+		draw_band_primitive(prim, reinterpret_cast<_PixelType *>(dstdata), width, height, pitch, 0, height);
+	}
+
+
+	//-------------------------------------------------
+	//  draw_primitives - draw a series of primitives
+	//  using a software rasterizer; given a work
+	//  queue, the destination is split into bands
+	//  that are drawn in parallel
+	//-------------------------------------------------
+
+	static void draw_primitives(const render_primitive_list &primlist, void *dstdata, UINT32 width, UINT32 height, UINT32 pitch, osd_work_queue *queue = NULL)
+	{
+		// every band walks the whole list in order, so each pixel sees the same sequence of
+		// operations as it would drawing serially; only the rows each band touches differ
+		int bands = (queue != NULL) ? MIN(height / MIN_BAND_HEIGHT, MAX_BANDS) : 1;
+		if (bands <= 1)
+		{
+			draw_band_primitives(primlist, reinterpret_cast<_PixelType *>(dstdata), width, height, pitch, 0, height);
+			return;
+		}
+
+		// build the line table here so that the workers only ever read it
+		cosine_table();
+
+		// split the rows as evenly as possible
+		band_data band[MAX_BANDS];
+		for (int bandnum = 0; bandnum < bands; bandnum++)
+		{
+			band[bandnum].primlist = &primlist;
+			band[bandnum].dstdata = reinterpret_cast<_PixelType *>(dstdata);
+			band[bandnum].width = width;
+			band[bandnum].height = height;
+			band[bandnum].pitch = pitch;
+			band[bandnum].miny = height * bandnum / bands;
+			band[bandnum].maxy = height * (bandnum + 1) / bands;
+		}
+
+		// draw them all; if they can't be queued, draw serially
+		osd_work_item *item = osd_work_item_queue_multiple(queue, draw_band, bands, band, sizeof(band[0]), 0);
+		if (item == NULL)
+		{
+			draw_band_primitives(primlist, reinterpret_cast<_PixelType *>(dstdata), width, height, pitch, 0, height);
+			return;
+		}
+
+		// the bands live on our stack, so we can't return while any are still being drawn; some
+		// OSDs hand back only the last band's item, so also wait for the (dedicated) queue to drain
+		if (!osd_work_item_wait(item, osd_ticks_per_second() * 100) || !osd_work_queue_wait(queue, osd_ticks_per_second() * 100))
+			fatalerror("Timed out waiting for software rendering bands\n");
+		osd_work_item_release(item);
 	}
 };
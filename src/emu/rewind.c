@@ -0,0 +1,355 @@
+/***************************************************************************
+
+    rewind.c
+
+    In-memory rewind history built from periodic save states.
+
+    Copyright Bryan Ischo and the MAME Team.
+    Visit http://mamedev.org for licensing and usage restrictions.
+
+****************************************************************************
+
+    The rewind history lives in a single ring buffer whose size is fixed
+    by the rewind_size option. Every rewind_interval frames of the primary
+    screen, the current state is captured into the ring. Captures are
+    either uncompressed keyframes, or deltas against the most recent
+    keyframe; once a delta grows past a quarter of the keyframe size, a
+    new keyframe is taken instead.
+
+    When the ring fills up, the oldest captures are discarded. Deltas
+    are useless without their keyframe, so the oldest capture in the
+    ring is always a keyframe.
+
+    Both capturing and rewinding only happen at the same safe point in
+    the main loop that is used for regular save states.
+
+***************************************************************************/
+
+#include "emu.h"
+#include "emuopts.h"
+#include "rewind.h"
+
+
+
+//**************************************************************************
+//  CONSTANTS
+//**************************************************************************
+
+// largest ring buffer we will allocate, in megabytes
+const int MAX_REWIND_SIZE = 2047;
+
+// initial number of entries in the capture index
+const int INITIAL_INDEX_SIZE = 64;
+
+
+
+//**************************************************************************
+//  REWIND MANAGER
+//**************************************************************************
+
+//-------------------------------------------------
+//  rewind_manager - constructor
+//-------------------------------------------------
+
+rewind_manager::rewind_manager(running_machine &machine)
+	: m_machine(machine),
+	  m_enabled(false),
+	  m_budget(0),
+	  m_interval(1),
+	  m_first(0),
+	  m_count(0),
+	  m_head(0),
+	  m_have_keyframe(false),
+	  m_keyframe_offset(0),
+	  m_keyframe_size(0),
+	  m_last_frame(0),
+	  m_captured_any(false),
+	  m_pending_frames(0),
+	  m_rewind_result(STATERR_NONE)
+{
+	emu_options &options = machine.options();
+	int size = options.rewind_size();
+	if (size <= 0)
+		return;
+
+	// rewinding is built on save states, so it needs a game that supports them
+	if ((machine.system().flags & GAME_SUPPORTS_SAVE) == 0)
+	{
+		mame_printf_warning("Rewind disabled: save states are not supported by this game\n");
+		return;
+	}
+
+	// the budget is fixed up front; the buffer itself is allocated at the first capture
+	m_enabled = true;
+	m_budget = MIN(size, MAX_REWIND_SIZE) * 1024 * 1024;
+	m_interval = MAX(options.rewind_interval(), 1);
+}
+
+
+//-------------------------------------------------
+//  update - called from the main loop at the
+//  save state safe point; performs any pending
+//  rewind and captures new states as needed
+//-------------------------------------------------
+
+void rewind_manager::update()
+{
+	// nothing to do if disabled or screenless
+	if (!m_enabled || machine().primary_screen == NULL)
+		return;
+
+	// if there are anonymous timers, try again later
+	if (!machine().scheduler().can_save())
+		return;
+
+	UINT64 frame = machine().primary_screen->frame_number();
+
+	// handle pending rewinds first
+	if (m_pending_frames != 0)
+	{
+		perform_rewind(frame);
+		return;
+	}
+
+	// if time moved backwards, a state was loaded behind our back; start over
+	if (m_captured_any && frame < m_last_frame)
+		reset();
+
+	// capture every m_interval frames
+	if (m_captured_any && frame < m_last_frame + m_interval)
+		return;
+	if (ensure_allocated())
+		perform_capture(frame);
+}
+
+
+//-------------------------------------------------
+//  rewind - request that the machine be rewound
+//  by the given number of frames at the next
+//  safe point
+//-------------------------------------------------
+
+void rewind_manager::rewind(int frames)
+{
+	if (m_enabled && frames > 0)
+		m_pending_frames += frames;
+}
+
+
+//-------------------------------------------------
+//  reset - discard all captured history
+//-------------------------------------------------
+
+void rewind_manager::reset()
+{
+	m_first = 0;
+	m_count = 0;
+	m_head = 0;
+	m_have_keyframe = false;
+	m_captured_any = false;
+}
+
+
+//-------------------------------------------------
+//  ensure_allocated - allocate the ring buffer
+//  the first time it is needed
+//-------------------------------------------------
+
+bool rewind_manager::ensure_allocated()
+{
+	if (m_buffer.count() != 0)
+		return true;
+
+	// make sure at least a couple of keyframes fit
+	save_manager &save = machine().save();
+	if (m_budget / 2 < save.binary_size())
+	{
+		mame_printf_warning("Rewind disabled: rewind_size is too small to hold a save state (%d bytes)\n", save.binary_size());
+		m_enabled = false;
+		return false;
+	}
+
+	m_buffer.resize(m_budget);
+	m_scratch.resize(save.delta_bound());
+	m_index.resize(INITIAL_INDEX_SIZE);
+	return true;
+}
+
+
+//-------------------------------------------------
+//  perform_capture - capture the current state
+//  into the ring, as a delta if possible
+//-------------------------------------------------
+
+void rewind_manager::perform_capture(UINT64 frame)
+{
+	save_manager &save = machine().save();
+	UINT32 keysize = save.binary_size();
+	UINT32 actual;
+
+	// try a delta against the current keyframe first
+	if (m_have_keyframe)
+	{
+		save_error err = save.write_delta(&m_buffer[m_keyframe_offset], m_keyframe_size, m_scratch, m_scratch.count(), actual);
+		if (err == STATERR_NONE && actual < keysize / 4)
+		{
+			UINT32 offset = make_room(actual);
+
+			// making room may have evicted the keyframe, in which case fall through
+			if (m_have_keyframe)
+			{
+				memcpy(&m_buffer[offset], m_scratch, actual);
+				append(offset, actual, m_keyframe_offset, m_keyframe_size, frame);
+				return;
+			}
+		}
+	}
+
+	// otherwise, write a new keyframe directly into the ring
+	UINT32 offset = make_room(keysize);
+	save_error err = save.write_buffer(&m_buffer[offset], keysize, actual, false);
+	if (err != STATERR_NONE)
+	{
+		mame_printf_warning("Rewind disabled: unable to capture state (error %d)\n", err);
+		m_enabled = false;
+		reset();
+		return;
+	}
+	append(offset, actual, 0, 0, frame);
+	m_have_keyframe = true;
+	m_keyframe_offset = offset;
+	m_keyframe_size = actual;
+}
+
+
+//-------------------------------------------------
+//  perform_rewind - restore the newest capture
+//  at or before the requested frame
+//-------------------------------------------------
+
+void rewind_manager::perform_rewind(UINT64 frame)
+{
+	UINT64 frames = m_pending_frames;
+	m_pending_frames = 0;
+	if (m_count == 0)
+	{
+		m_rewind_result = STATERR_READ_ERROR;
+		return;
+	}
+
+	// find the newest capture at or before the target; if they are all
+	// newer, go back as far as we can
+	UINT64 target = (frame > frames) ? (frame - frames) : 0;
+	int index = m_count - 1;
+	while (index > 0 && nth(index).m_frame > target)
+		index--;
+	capture &cap = nth(index);
+
+	// load it
+	save_manager &save = machine().save();
+	if (cap.m_base_size == 0)
+		m_rewind_result = save.read_buffer(&m_buffer[cap.m_offset], cap.m_size);
+	else
+		m_rewind_result = save.read_delta(&m_buffer[cap.m_base_offset], cap.m_base_size, &m_buffer[cap.m_offset], cap.m_size);
+	if (m_rewind_result != STATERR_NONE)
+	{
+		// the machine is untouched, but the history can no longer be trusted
+		mame_printf_warning("Rewind disabled: unable to restore state (error %d)\n", m_rewind_result);
+		m_enabled = false;
+		reset();
+		return;
+	}
+
+	// everything newer belongs to a future that no longer exists
+	m_count = index + 1;
+	m_head = cap.m_offset + cap.m_size;
+	m_last_frame = cap.m_frame;
+	m_have_keyframe = true;
+	m_keyframe_offset = (cap.m_base_size == 0) ? cap.m_offset : cap.m_base_offset;
+	m_keyframe_size = (cap.m_base_size == 0) ? cap.m_size : cap.m_base_size;
+}
+
+
+//-------------------------------------------------
+//  make_room - evict old captures until there is
+//  a contiguous block of the given size following
+//  the newest capture, and return its offset
+//-------------------------------------------------
+
+UINT32 rewind_manager::make_room(UINT32 size)
+{
+	// wrap to the start if we don't fit at the end
+	UINT32 start = m_head;
+	bool wrapped = false;
+	if (start + size > m_buffer.count())
+	{
+		start = 0;
+		wrapped = true;
+	}
+
+	// captures are laid out in age order around the ring, so evicting the
+	// oldest first always frees the space in front of the head; when we
+	// wrap, anything still sitting past the head is older than what is at
+	// the start and has to go first
+	while (m_count > 0)
+	{
+		capture &oldest = nth(0);
+		if ((wrapped && oldest.m_offset >= m_head) || (oldest.m_offset < start + size && oldest.m_offset + oldest.m_size > start))
+			evict_oldest();
+		else
+			break;
+	}
+	return start;
+}
+
+
+//-------------------------------------------------
+//  append - add a new capture to the index
+//-------------------------------------------------
+
+void rewind_manager::append(UINT32 offset, UINT32 size, UINT32 base_offset, UINT32 base_size, UINT64 frame)
+{
+	// grow the index if full, linearizing it first so the ring stays in order
+	if (m_count == m_index.count())
+	{
+		if (m_first != 0)
+		{
+			dynamic_array<capture> temp(m_count);
+			for (int index = 0; index < m_count; index++)
+				temp[index] = nth(index);
+			for (int index = 0; index < m_count; index++)
+				m_index[index] = temp[index];
+			m_first = 0;
+		}
+		m_index.resize(m_index.count() * 2, true);
+	}
+
+	capture &cap = nth(m_count++);
+	cap.m_offset = offset;
+	cap.m_size = size;
+	cap.m_base_offset = base_offset;
+	cap.m_base_size = base_size;
+	cap.m_frame = frame;
+
+	m_head = offset + size;
+	m_last_frame = frame;
+	m_captured_any = true;
+}
+
+
+//-------------------------------------------------
+//  evict_oldest - discard the oldest capture,
+//  along with any deltas orphaned by doing so
+//-------------------------------------------------
+
+void rewind_manager::evict_oldest()
+{
+	do
+	{
+		capture &oldest = nth(0);
+		if (oldest.m_base_size == 0 && m_have_keyframe && oldest.m_offset == m_keyframe_offset)
+			m_have_keyframe = false;
+		m_first = (m_first + 1) % m_index.count();
+		m_count--;
+	} while (m_count > 0 && nth(0).m_base_size != 0);
+}
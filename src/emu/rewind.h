@@ -0,0 +1,90 @@
+/***************************************************************************
+
+    rewind.h
+
+    In-memory rewind history built from periodic save states.
+
+    Copyright Bryan Ischo and the MAME Team.
+    Visit http://mamedev.org for licensing and usage restrictions.
+
+***************************************************************************/
+
+#pragma once
+
+#ifndef __EMU_H__
+#error Dont include this file directly; include emu.h instead.
+#endif
+
+#ifndef __REWIND_H__
+#define __REWIND_H__
+
+
+//**************************************************************************
+//  TYPE DEFINITIONS
+//**************************************************************************
+
+// ======================> rewind_manager
+
+// keeps a fixed-size ring of recent save states, stored as uncompressed
+// keyframes followed by deltas against the most recent keyframe
+class rewind_manager
+{
+	// a single captured state within the ring
+	struct capture
+	{
+		UINT32			m_offset;		// offset of the data within the ring buffer
+		UINT32			m_size;			// size of the data
+		UINT32			m_base_offset;	// offset of the keyframe this is a delta against
+		UINT32			m_base_size;	// size of that keyframe, or 0 if this is a keyframe
+		UINT64			m_frame;		// primary screen frame number at capture time
+	};
+
+public:
+	// construction/destruction
+	rewind_manager(running_machine &machine);
+
+	// getters
+	running_machine &machine() const { return m_machine; }
+	bool enabled() const { return m_enabled; }
+	int capture_count() const { return m_count; }
+	UINT64 oldest_frame() const { return (m_count == 0) ? 0 : m_index[m_first].m_frame; }
+	bool rewind_pending() const { return m_pending_frames != 0; }
+	save_error rewind_result() const { return m_rewind_result; }
+
+	// actions
+	void update();
+	void rewind(int frames);
+	void reset();
+
+private:
+	// internal helpers
+	bool ensure_allocated();
+	void perform_capture(UINT64 frame);
+	void perform_rewind(UINT64 frame);
+	UINT32 make_room(UINT32 size);
+	void append(UINT32 offset, UINT32 size, UINT32 base_offset, UINT32 base_size, UINT64 frame);
+	void evict_oldest();
+	capture &nth(int index) { return m_index[(m_first + index) % m_index.count()]; }
+
+	// internal state
+	running_machine &		m_machine;				// reference to our machine
+	bool					m_enabled;				// are we capturing at all?
+	UINT32					m_budget;				// total bytes available for captures
+	int						m_interval;				// frames between captures
+	dynamic_buffer			m_buffer;				// ring buffer holding the capture data
+	dynamic_buffer			m_scratch;				// scratch space for building deltas
+	dynamic_array<capture>	m_index;				// ring of captures, oldest first
+	int						m_first;				// index of the oldest capture
+	int						m_count;				// number of live captures
+	UINT32					m_head;					// offset just past the newest capture
+	bool					m_have_keyframe;		// do we have a keyframe to delta against?
+	UINT32					m_keyframe_offset;		// offset of the newest keyframe
+	UINT32					m_keyframe_size;		// size of the newest keyframe
+	UINT64					m_last_frame;			// frame of the last capture
+	bool					m_captured_any;			// have we captured since start/rewind?
+	int						m_pending_frames;		// frames to rewind at the next safe point
+	save_error				m_rewind_result;		// result of the last rewind
+};
+
+
+#endif	/* __REWIND_H__ */
@@ -16,6 +16,8 @@
 #include "harddisk.h"
 #include "config.h"
 #include "ui.h"
+#include "unzip.h"
+#include "un7z.h"
 
 
 #define LOG_LOAD 0
@@ -28,6 +30,9 @@
 
 #define TEMPBUFFER_MAX_SIZE		(1024 * 1024 * 1024)
 
+/* number of ROM files searched for in the background ahead of the one being loaded */
+#define ROM_PREFETCH_DEPTH		16
+
 
 
 /***************************************************************************
@@ -57,7 +62,19 @@ private:
 };
 
 
+/* a ROM file searched for ahead of its turn, in the background */
 typedef struct _romload_private rom_load_data;
+struct rom_prefetch
+{
+	rom_load_data *	romdata;			/* owning load data */
+	const rom_entry *romp;				/* ROM file entry */
+	astring			regiontag;			/* tag of the region being loaded, for load by name */
+	bool			needed;				/* is the file needed for the current BIOS? */
+	emu_file *		file;				/* the file, or NULL if missing or not needed */
+	osd_work_item *	item;				/* background search, or NULL if not queued */
+};
+
+
 struct _romload_private
 {
 	running_machine &machine() const { assert(m_machine != NULL); return *m_machine; }
@@ -76,6 +93,12 @@ struct _romload_private
 	emu_file *		file;				/* current file */
 	simple_list<open_chd> chd_list;		/* disks */
 
+	osd_work_queue *queue;				/* queue for searching for ROM files */
+	rom_prefetch	prefetch[ROM_PREFETCH_DEPTH];	/* ring of files opened ahead */
+	int				prefetchhead;		/* ring index of the next file to load */
+	int				prefetchcount;		/* number of files in the ring */
+	const rom_entry *prefetchrom;		/* next ROM file entry to open ahead, or NULL */
+
 	memory_region *	region;				/* info about current region */
 
 	astring			errorstring;		/* error string */
@@ -104,9 +127,9 @@ file_error common_process_file(emu_options &options, const char *location, const
 	return filerr;
 }
 
-file_error common_process_file(emu_options &options, const char *location, bool has_crc, UINT32 crc, const rom_entry *romp, emu_file **image_file)
+file_error common_process_file(emu_options &options, const char *location, bool has_crc, UINT32 crc, const rom_entry *romp, emu_file **image_file, UINT32 openflags)
 {
-	*image_file = global_alloc(emu_file(options.media_path(), OPEN_FLAG_READ));
+	*image_file = global_alloc(emu_file(options.media_path(), openflags));
 	file_error filerr;
 
 	if (has_crc)
@@ -127,6 +150,17 @@ file_error common_process_file(emu_options &options, const char *location, bool
     HARD DISK HANDLING
 ***************************************************************************/
 
+/*-------------------------------------------------
+    configure_disk_cache - size the hunk cache of
+    an opened disk image from the options
+-------------------------------------------------*/
+
+static void configure_disk_cache(emu_options &options, chd_file &chd)
+{
+	chd.configure_cache(MAX(options.chd_cache_size(), 0) * 1024 * 1024, options.chd_readahead());
+}
+
+
 /*-------------------------------------------------
     get_disk_handle - return a pointer to the
     CHD file associated with the given region
@@ -151,7 +185,10 @@ int set_disk_handle(running_machine &machine, const char *region, const char *fu
 	open_chd *chd = global_alloc(open_chd(region));
 	chd_error err = chd->orig_chd().open(fullpath);
 	if (err == CHDERR_NONE)
+	{
+		configure_disk_cache(machine.options(), chd->orig_chd());
 		machine.romload_data->chd_list.append(*chd);
+	}
 	else
 		global_free(chd);
 	return err;
@@ -562,17 +599,14 @@ static void region_post_process(rom_load_data *romdata, const char *rgntag, bool
 
 
 /*-------------------------------------------------
-    open_rom_file - open a ROM file, searching
-    up the parent and loading by checksum
+    find_rom_file - find and open a ROM file,
+    searching up the parent and loading by
+    checksum; safe to call from any thread
 -------------------------------------------------*/
 
-static int open_rom_file(rom_load_data *romdata, const char *regiontag, const rom_entry *romp)
+static file_error find_rom_file(running_machine &machine, const char *regiontag, const rom_entry *romp, emu_file **file)
 {
 	file_error filerr = FILERR_NOT_FOUND;
-	UINT32 romsize = rom_file_size(romp);
-
-	/* update status display */
-	display_loading_rom_message(romdata, ROM_GETNAME(romp));
 
 	/* extract CRC to use for searching */
 	UINT32 crc = 0;
@@ -580,12 +614,12 @@ static int open_rom_file(rom_load_data *romdata, const char *regiontag, const ro
 
 	/* attempt reading up the chain through the parents. It automatically also
      attempts any kind of load by checksum supported by the archives. */
-	romdata->file = NULL;
-	for (int drv = driver_list::find(romdata->machine().system()); romdata->file == NULL && drv != -1; drv = driver_list::clone(drv))
-		filerr = common_process_file(romdata->machine().options(), driver_list::driver(drv).name, has_crc, crc, romp, &romdata->file);
+	*file = NULL;
+	for (int drv = driver_list::find(machine.system()); *file == NULL && drv != -1; drv = driver_list::clone(drv))
+		filerr = common_process_file(machine.options(), driver_list::driver(drv).name, has_crc, crc, romp, file, OPEN_FLAG_READ | OPEN_FLAG_NO_PRELOAD);
 
 	/* if the region is load by name, load the ROM from there */
-	if (romdata->file == NULL && regiontag != NULL)
+	if (*file == NULL && regiontag != NULL)
 	{
 		// check if we are dealing with softwarelists. if so, locationtag
 		// is actually a concatenation of: listname + setname + parentname
@@ -632,30 +666,140 @@ static int open_rom_file(rom_load_data *romdata, const char *regiontag, const ro
 		// - if we are not using lists, we have regiontag only;
 		// - if we are using lists, we have: list/clonename, list/parentname, clonename, parentname
 		if (!is_list)
-			filerr = common_process_file(romdata->machine().options(), tag1.cstr(), has_crc, crc, romp, &romdata->file);
+			filerr = common_process_file(machine.options(), tag1.cstr(), has_crc, crc, romp, file, OPEN_FLAG_READ | OPEN_FLAG_NO_PRELOAD);
 		else
 		{
 			// try to load from list/setname
-			if ((romdata->file == NULL) && (tag2.cstr() != NULL))
-				filerr = common_process_file(romdata->machine().options(), tag2.cstr(), has_crc, crc, romp, &romdata->file);
+			if ((*file == NULL) && (tag2.cstr() != NULL))
+				filerr = common_process_file(machine.options(), tag2.cstr(), has_crc, crc, romp, file, OPEN_FLAG_READ | OPEN_FLAG_NO_PRELOAD);
 			// try to load from list/parentname
-			if ((romdata->file == NULL) && has_parent && (tag3.cstr() != NULL))
-				filerr = common_process_file(romdata->machine().options(), tag3.cstr(), has_crc, crc, romp, &romdata->file);
+			if ((*file == NULL) && has_parent && (tag3.cstr() != NULL))
+				filerr = common_process_file(machine.options(), tag3.cstr(), has_crc, crc, romp, file, OPEN_FLAG_READ | OPEN_FLAG_NO_PRELOAD);
 			// try to load from setname
-			if ((romdata->file == NULL) && (tag4.cstr() != NULL))
-				filerr = common_process_file(romdata->machine().options(), tag4.cstr(), has_crc, crc, romp, &romdata->file);
+			if ((*file == NULL) && (tag4.cstr() != NULL))
+				filerr = common_process_file(machine.options(), tag4.cstr(), has_crc, crc, romp, file, OPEN_FLAG_READ | OPEN_FLAG_NO_PRELOAD);
 			// try to load from parentname
-			if ((romdata->file == NULL) && has_parent && (tag5.cstr() != NULL))
-				filerr = common_process_file(romdata->machine().options(), tag5.cstr(), has_crc, crc, romp, &romdata->file);
+			if ((*file == NULL) && has_parent && (tag5.cstr() != NULL))
+				filerr = common_process_file(machine.options(), tag5.cstr(), has_crc, crc, romp, file, OPEN_FLAG_READ | OPEN_FLAG_NO_PRELOAD);
 		}
 	}
 
+	return filerr;
+}
+
+
+/*-------------------------------------------------
+    prefetch_rom_file - find and open a ROM file
+    on a work queue thread
+-------------------------------------------------*/
+
+static void *prefetch_rom_file(void *param, int threadid)
+{
+	rom_prefetch *prefetch = (rom_prefetch *)param;
+
+	/* only the search and the archive directory lookup happen here; reading and hashing are left to the loader */
+	const char *regiontag = (prefetch->regiontag.len() != 0) ? prefetch->regiontag.cstr() : NULL;
+	find_rom_file(prefetch->romdata->machine(), regiontag, prefetch->romp, &prefetch->file);
+	return NULL;
+}
+
+
+/*-------------------------------------------------
+    prefetch_rom_files - queue searches for a
+    region's ROM files ahead of their turn
+-------------------------------------------------*/
+
+static void prefetch_rom_files(rom_load_data *romdata, const char *regiontag)
+{
+	while (romdata->prefetchcount < ROM_PREFETCH_DEPTH && romdata->prefetchrom != NULL)
+	{
+		const rom_entry *romp = romdata->prefetchrom;
+		rom_prefetch &prefetch = romdata->prefetch[(romdata->prefetchhead + romdata->prefetchcount++) % ROM_PREFETCH_DEPTH];
+
+		/* only files that are a non-BIOS or match the current BIOS are opened */
+		prefetch.romdata = romdata;
+		prefetch.romp = romp;
+		prefetch.regiontag.cpy((regiontag != NULL) ? regiontag : "");
+		prefetch.needed = (ROM_GETBIOSFLAGS(romp) == 0 || ROM_GETBIOSFLAGS(romp) == romdata->machine().config().root_device().system_bios());
+		prefetch.file = NULL;
+		prefetch.item = NULL;
+
+		/* search for it in the background, if we can; software list locations are searched
+           when the file's turn comes, since they can raise errors */
+		if (prefetch.needed && romdata->queue != NULL && (regiontag == NULL || strchr(regiontag, '%') == NULL))
+			prefetch.item = osd_work_item_queue(romdata->queue, prefetch_rom_file, &prefetch, 0);
+		romdata->prefetchrom = rom_next_file(romp);
+	}
+}
+
+
+/*-------------------------------------------------
+    next_prefetched_rom_file - wait for the next
+    ROM file in order and return it, or NULL if
+    it is missing or not needed
+-------------------------------------------------*/
+
+static emu_file *next_prefetched_rom_file(rom_load_data *romdata, const char *regiontag)
+{
+	/* keep the ring topped up */
+	prefetch_rom_files(romdata, regiontag);
+	assert(romdata->prefetchcount > 0);
+
+	rom_prefetch &prefetch = romdata->prefetch[romdata->prefetchhead];
+	romdata->prefetchhead = (romdata->prefetchhead + 1) % ROM_PREFETCH_DEPTH;
+	romdata->prefetchcount--;
+	if (!prefetch.needed)
+		return NULL;
+
+	/* update status display now that this file is actually being loaded */
+	LOG(("Opening ROM file: %s\n", ROM_GETNAME(prefetch.romp)));
+	display_loading_rom_message(romdata, ROM_GETNAME(prefetch.romp));
+
+	/* wait for its background search, or search for it now if it wasn't queued */
+	if (prefetch.item != NULL)
+	{
+		if (!osd_work_item_wait(prefetch.item, 100 * osd_ticks_per_second()))
+			fatalerror("Timed out searching for ROM file %s\n", ROM_GETNAME(prefetch.romp));
+		osd_work_item_release(prefetch.item);
+		prefetch.item = NULL;
+	}
+	else
+		find_rom_file(romdata->machine(), regiontag, prefetch.romp, &prefetch.file);
+
 	/* update counters */
 	romdata->romsloaded++;
-	romdata->romsloadedsize += romsize;
+	romdata->romsloadedsize += rom_file_size(prefetch.romp);
+
+	emu_file *file = prefetch.file;
+	prefetch.file = NULL;
+	return file;
+}
+
+
+/*-------------------------------------------------
+    flush_prefetched_rom_files - wait for and
+    close any ROM files still in the ring
+-------------------------------------------------*/
+
+static void flush_prefetched_rom_files(rom_load_data *romdata)
+{
+	/* the searches write into the ring, so none may still be running when we leave */
+	if (romdata->queue != NULL && !osd_work_queue_wait(romdata->queue, 100 * osd_ticks_per_second()))
+		fatalerror("Timed out waiting for ROM file searches to finish\n");
 
-	/* return the result */
-	return (filerr == FILERR_NONE);
+	while (romdata->prefetchcount > 0)
+	{
+		rom_prefetch &prefetch = romdata->prefetch[romdata->prefetchhead];
+		romdata->prefetchhead = (romdata->prefetchhead + 1) % ROM_PREFETCH_DEPTH;
+		romdata->prefetchcount--;
+
+		if (prefetch.item != NULL)
+			osd_work_item_release(prefetch.item);
+		prefetch.item = NULL;
+		global_free(prefetch.file);
+		prefetch.file = NULL;
+	}
+	romdata->prefetchrom = NULL;
 }
 
 
@@ -683,7 +827,7 @@ static int rom_fread(rom_load_data *romdata, UINT8 *buffer, int length, const ro
     entry
 -------------------------------------------------*/
 
-static int read_rom_data(rom_load_data *romdata, const rom_entry *parent_region, const rom_entry *romp)
+static int read_rom_data(rom_load_data *romdata, const rom_entry *parent_region, const rom_entry *romp, bool whole)
 {
 	int datashift = ROM_GETBITSHIFT(romp);
 	int datamask = ((1 << ROM_GETBITWIDTH(romp)) - 1) << datashift;
@@ -711,9 +855,13 @@ static int read_rom_data(rom_load_data *romdata, const rom_entry *parent_region,
 	if (numbytes == 0)
 		fatalerror("Error in RomModule definition: %s has an invalid length\n", ROM_GETNAME(romp));
 
-	/* special case for simple loads */
+	/* special case for simple loads; a whole file can be read straight into the region */
 	if (datamask == 0xff && (groupsize == 1 || !reversed) && skip == 0)
+	{
+		if (whole && romdata->file != NULL)
+			return romdata->file->read_into(base, numbytes);
 		return rom_fread(romdata, base, numbytes, parent_region);
+	}
 
 	/* use a temporary buffer for complex loads */
 	tempbufsize = MIN(TEMPBUFFER_MAX_SIZE, numbytes);
@@ -863,6 +1011,9 @@ static void process_rom_entries(rom_load_data *romdata, const char *regiontag, c
 {
 	UINT32 lastflags = 0;
 
+	/* start searching for and opening this region's files ahead of their turn; they are still read and hashed in order on this thread */
+	romdata->prefetchrom = rom_first_file(parent_region);
+
 	/* loop until we hit the end of this region */
 	while (!ROMENTRY_ISREGIONEND(romp))
 	{
@@ -893,9 +1044,9 @@ static void process_rom_entries(rom_load_data *romdata, const char *regiontag, c
 			const rom_entry *baserom = romp;
 			int explength = 0;
 
-			/* open the file if it is a non-BIOS or matches the current BIOS */
-			LOG(("Opening ROM file: %s\n", ROM_GETNAME(romp)));
-			if (!irrelevantbios && !open_rom_file(romdata, regiontag, romp))
+			/* take the file, opened if it is a non-BIOS or matches the current BIOS */
+			romdata->file = next_prefetched_rom_file(romdata, regiontag);
+			if (!irrelevantbios && romdata->file == NULL)
 				handle_missing_file(romdata, romp);
 
 			/* loop until we run out of reloads */
@@ -913,11 +1064,13 @@ static void process_rom_entries(rom_load_data *romdata, const char *regiontag, c
 					else
 						modified_romp._flags = (modified_romp._flags & ~ROM_INHERITEDFLAGS) | lastflags;
 
+					/* the file is read whole by its only entry if nothing continues, ignores or reloads it */
+					bool whole = (baserom != NULL && explength == 0 && !ROMENTRY_ISCONTINUE(romp) && !ROMENTRY_ISIGNORE(romp) && !ROMENTRY_ISRELOAD(romp));
 					explength += ROM_GETLENGTH(&modified_romp);
 
 					/* attempt to read using the modified entry */
 					if (!ROMENTRY_ISIGNORE(&modified_romp) && !irrelevantbios)
-						/*readresult = */read_rom_data(romdata, parent_region, &modified_romp);
+						/*readresult = */read_rom_data(romdata, parent_region, &modified_romp, whole);
 				}
 				while (ROMENTRY_ISCONTINUE(romp) || ROMENTRY_ISIGNORE(romp));
 
@@ -1218,6 +1371,9 @@ static void process_disk_entries(rom_load_data *romdata, const char *regiontag,
 				}
 			}
 
+			/* cache the source, which does any decompressing; diffs are uncompressed */
+			configure_disk_cache(romdata->machine().options(), chd->orig_chd());
+
 			/* we're okay, add to the list of disks */
 			LOG(("Assigning to handle %d\n", DISK_GETINDEX(romp)));
 			romdata->machine().romload_data->chd_list.append(*chd);
@@ -1281,7 +1437,7 @@ void load_software_part_region(device_t *device, char *swlist, char *swname, rom
 
 	// attempt reading up the chain through the parents and create a locationtag astring in the format
 	// " swlist % clonename % parentname "
-	// open_rom_file contains the code to split the elements and to create paths to load from
+	// find_rom_file contains the code to split the elements and to create paths to load from
 
 	software_list *software_list_ptr = software_list_open(device->machine().options(), swlist, FALSE, NULL);
 	if (software_list_ptr)
@@ -1474,8 +1630,13 @@ void rom_init(running_machine &machine)
 	/* reset the disk list */
 	romdata->chd_list.reset();
 
-	/* process the ROM entries we were passed */
+	/* process the ROM entries we were passed, searching for files in the background */
+	zip_file_cache_init();
+	_7z_file_cache_init();
+	romdata->queue = osd_work_queue_alloc(WORK_QUEUE_FLAG_MULTI);
 	process_region_list(romdata);
+	osd_work_queue_free(romdata->queue);
+	romdata->queue = NULL;
 
 	/* display the results and exit */
 	display_rom_load_results(romdata);
@@ -1488,6 +1649,15 @@ void rom_init(running_machine &machine)
 
 static void rom_exit(running_machine &machine)
 {
+	rom_load_data *romdata = machine.romload_data;
+
+	/* if loading was cut short by an error, clean up after it */
+	flush_prefetched_rom_files(romdata);
+	if (romdata->queue != NULL)
+	{
+		osd_work_queue_free(romdata->queue);
+		romdata->queue = NULL;
+	}
 }
 
 
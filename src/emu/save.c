@@ -49,6 +49,18 @@
     Data is always written as native-endian.
     Data is converted from the endiannness it was written upon load.
 
+    In-memory save states use the same header; their data is deflated
+    unless the SS_UNCOMPRESSED flag is set, in which case it is the raw
+    concatenation of all registered entries.
+
+    Delta save states (SS_DELTA) are relative to an uncompressed in-memory
+    save state of the same machine.  Their data is a sequence of runs, in
+    increasing offset order, of the pages that differ from that base:
+
+    00..03  Offset of the run within the raw data
+    04..07  Length of the run
+    08..end Contents of the run
+
 ***************************************************************************/
 
 #include "emu.h"
@@ -76,9 +88,39 @@ const int HEADER_SIZE		= 32;
 // Available flags
 enum
 {
-	SS_MSB_FIRST = 0x02
+	SS_MSB_FIRST = 0x02,
+	SS_UNCOMPRESSED = 0x04,
+	SS_DELTA = 0x08
 };
 
+// granularity at which delta states compare against their base
+const UINT32 DELTA_PAGE_SIZE = 128;
+const UINT32 DELTA_RUN_HEADER_SIZE = 8;
+
+
+
+//**************************************************************************
+//  INLINE FUNCTIONS
+//**************************************************************************
+
+//-------------------------------------------------
+//  read_run_header/write_run_header - access a
+//  delta run header, which follows variable-sized
+//  run contents and so may be at any alignment
+//-------------------------------------------------
+
+static inline void read_run_header(const UINT8 *header, UINT32 &offset, UINT32 &length)
+{
+	memcpy(&offset, &header[0], sizeof(offset));
+	memcpy(&length, &header[4], sizeof(length));
+}
+
+static inline void write_run_header(UINT8 *header, UINT32 offset, UINT32 length)
+{
+	memcpy(&header[0], &offset, sizeof(offset));
+	memcpy(&header[4], &length, sizeof(length));
+}
+
 
 //**************************************************************************
 //  INITIALIZATION
@@ -304,12 +346,7 @@ save_error save_manager::write_file(emu_file &file)
 
 	// generate the header
 	UINT8 header[HEADER_SIZE];
-	memcpy(&header[0], emulator_info::get_state_magic_num(), 8);
-	header[8] = SAVE_VERSION;
-	header[9] = NATIVE_ENDIAN_VALUE_LE_BE(0, SS_MSB_FIRST);
-	strncpy((char *)&header[0x0a], machine().system().name, 0x1c - 0x0a);
-	UINT32 sig = signature();
-	*(UINT32 *)&header[0x1c] = LITTLE_ENDIANIZE_INT32(sig);
+	build_header(header, 0);
 
 	// write the header and turn on compression for the rest of the file
 	file.compress(FCOMPRESS_NONE);
@@ -333,6 +370,362 @@ save_error save_manager::write_file(emu_file &file)
 }
 
 
+//-------------------------------------------------
+//  binary_size - return the exact size of an
+//  uncompressed in-memory save state
+//-------------------------------------------------
+
+UINT32 save_manager::binary_size() const
+{
+	UINT32 totalsize = HEADER_SIZE;
+	for (state_entry *entry = m_entry_list.first(); entry != NULL; entry = entry->next())
+		totalsize += entry->m_typesize * entry->m_typecount;
+	return totalsize;
+}
+
+
+//-------------------------------------------------
+//  checksum - return a CRC of all registered
+//  state, as it would be saved right now
+//-------------------------------------------------
+
+UINT32 save_manager::checksum()
+{
+	// call the pre-save functions so the state is as a save would see it
+	for (state_callback *func = m_presave_list.first(); func != NULL; func = func->next())
+		func->m_func();
+
+	uLong crc = crc32(0, Z_NULL, 0);
+	for (state_entry *entry = m_entry_list.first(); entry != NULL; entry = entry->next())
+		crc = crc32(crc, (const Bytef *)entry->m_data, entry->m_typesize * entry->m_typecount);
+	return crc;
+}
+
+
+//-------------------------------------------------
+//  compressed_bound - return the largest size
+//  that a compressed in-memory save state can be
+//-------------------------------------------------
+
+UINT32 save_manager::compressed_bound() const
+{
+	return HEADER_SIZE + compressBound(binary_size() - HEADER_SIZE);
+}
+
+
+//-------------------------------------------------
+//  write_buffer - writes the data to a block of
+//  memory, optionally deflating it
+//-------------------------------------------------
+
+save_error save_manager::write_buffer(void *buf, UINT32 size, UINT32 &actual, bool compress)
+{
+	actual = 0;
+
+	// if we have illegal registrations, return an error
+	if (m_illegal_regs > 0)
+		return STATERR_ILLEGAL_REGISTRATIONS;
+
+	// generate the header
+	UINT8 *dest = (UINT8 *)buf;
+	if (size < HEADER_SIZE)
+		return STATERR_WRITE_ERROR;
+	build_header(dest, compress ? 0 : SS_UNCOMPRESSED);
+
+	// call the pre-save functions
+	for (state_callback *func = m_presave_list.first(); func != NULL; func = func->next())
+		func->m_func();
+
+	// uncompressed data is just copied
+	if (!compress)
+	{
+		UINT32 offset = HEADER_SIZE;
+		for (state_entry *entry = m_entry_list.first(); entry != NULL; entry = entry->next())
+		{
+			UINT32 totalsize = entry->m_typesize * entry->m_typecount;
+			if (size - offset < totalsize)
+				return STATERR_WRITE_ERROR;
+			memcpy(&dest[offset], entry->m_data, totalsize);
+			offset += totalsize;
+		}
+		actual = offset;
+		return STATERR_NONE;
+	}
+
+	// otherwise, deflate everything into the space after the header; favor
+	// speed since these are typically taken often
+	z_stream stream;
+	memset(&stream, 0, sizeof(stream));
+	if (deflateInit(&stream, Z_BEST_SPEED) != Z_OK)
+		return STATERR_WRITE_ERROR;
+	stream.next_out = &dest[HEADER_SIZE];
+	stream.avail_out = size - HEADER_SIZE;
+
+	for (state_entry *entry = m_entry_list.first(); entry != NULL; entry = entry->next())
+	{
+		stream.next_in = (Bytef *)entry->m_data;
+		stream.avail_in = entry->m_typesize * entry->m_typecount;
+		while (stream.avail_in != 0)
+			if (stream.avail_out == 0 || deflate(&stream, Z_NO_FLUSH) != Z_OK)
+			{
+				deflateEnd(&stream);
+				return STATERR_WRITE_ERROR;
+			}
+	}
+
+	// flush the remainder; if it doesn't all fit, the buffer was too small
+	int zerr = deflate(&stream, Z_FINISH);
+	actual = HEADER_SIZE + stream.total_out;
+	deflateEnd(&stream);
+	if (zerr != Z_STREAM_END)
+	{
+		actual = 0;
+		return STATERR_WRITE_ERROR;
+	}
+	return STATERR_NONE;
+}
+
+
+//-------------------------------------------------
+//  read_buffer - read the data from a block of
+//  memory written by write_buffer
+//-------------------------------------------------
+
+save_error save_manager::read_buffer(const void *buf, UINT32 size)
+{
+	// if we have illegal registrations, return an error
+	if (m_illegal_regs > 0)
+		return STATERR_ILLEGAL_REGISTRATIONS;
+
+	// verify the header and report an error if it doesn't match
+	const UINT8 *src = (const UINT8 *)buf;
+	if (size < HEADER_SIZE)
+		return STATERR_READ_ERROR;
+	if (validate_header(src, machine().system().name, signature(), NULL, "") != STATERR_NONE)
+		return STATERR_INVALID_HEADER;
+
+	// determine whether or not to flip the data when done
+	bool flip = NATIVE_ENDIAN_VALUE_LE_BE((src[9] & SS_MSB_FIRST) != 0, (src[9] & SS_MSB_FIRST) == 0);
+
+	// nothing may be touched until the whole state is known to be there, so that a
+	// truncated or corrupt buffer leaves the machine as it was
+	UINT32 datasize = binary_size() - HEADER_SIZE;
+	const UINT8 *data = &src[HEADER_SIZE];
+	if (src[9] & SS_UNCOMPRESSED)
+	{
+		if (size - HEADER_SIZE != datasize)
+			return STATERR_READ_ERROR;
+	}
+
+	// compressed data is inflated into scratch space first, and must fill it exactly
+	else
+	{
+		m_inflate_buffer.resize(datasize);
+		z_stream stream;
+		memset(&stream, 0, sizeof(stream));
+		if (inflateInit(&stream) != Z_OK)
+			return STATERR_READ_ERROR;
+		stream.next_in = (Bytef *)&src[HEADER_SIZE];
+		stream.avail_in = size - HEADER_SIZE;
+		stream.next_out = (Bytef *)(UINT8 *)m_inflate_buffer;
+		stream.avail_out = datasize;
+		int zerr = inflate(&stream, Z_FINISH);
+		UINT32 total = stream.total_out;
+		inflateEnd(&stream);
+		if (zerr != Z_STREAM_END || total != datasize)
+			return STATERR_READ_ERROR;
+		data = m_inflate_buffer;
+	}
+
+	// now copy it into each entry
+	for (state_entry *entry = m_entry_list.first(); entry != NULL; entry = entry->next())
+	{
+		UINT32 totalsize = entry->m_typesize * entry->m_typecount;
+		memcpy(entry->m_data, data, totalsize);
+		data += totalsize;
+	}
+
+	// handle flipping
+	if (flip)
+		for (state_entry *entry = m_entry_list.first(); entry != NULL; entry = entry->next())
+			entry->flip_data();
+
+	// call the post-load functions
+	for (state_callback *func = m_postload_list.first(); func != NULL; func = func->next())
+		func->m_func();
+
+	return STATERR_NONE;
+}
+
+
+//-------------------------------------------------
+//  delta_bound - return the largest size that a
+//  delta save state can be
+//-------------------------------------------------
+
+UINT32 save_manager::delta_bound() const
+{
+	// worst case, every page of every entry starts its own run
+	UINT32 runs = (binary_size() - HEADER_SIZE) / DELTA_PAGE_SIZE + m_entry_list.count();
+	return binary_size() + runs * DELTA_RUN_HEADER_SIZE;
+}
+
+
+//-------------------------------------------------
+//  write_delta - writes only the pages of data
+//  that differ from an uncompressed in-memory
+//  save state to a block of memory
+//-------------------------------------------------
+
+save_error save_manager::write_delta(const void *base, UINT32 basesize, void *buf, UINT32 size, UINT32 &actual)
+{
+	actual = 0;
+
+	// if we have illegal registrations, return an error
+	if (m_illegal_regs > 0)
+		return STATERR_ILLEGAL_REGISTRATIONS;
+
+	// make sure the base is one of ours
+	const UINT8 *basedata = (const UINT8 *)base;
+	save_error err = validate_delta_base(basedata, basesize);
+	if (err != STATERR_NONE)
+		return err;
+	basedata += HEADER_SIZE;
+
+	// generate the header
+	UINT8 *dest = (UINT8 *)buf;
+	if (size < HEADER_SIZE)
+		return STATERR_WRITE_ERROR;
+	build_header(dest, SS_DELTA);
+
+	// call the pre-save functions
+	for (state_callback *func = m_presave_list.first(); func != NULL; func = func->next())
+		func->m_func();
+
+	// compare each entry page by page, extending the current run for as
+	// long as dirty pages are contiguous, even across entries
+	UINT32 destoffs = HEADER_SIZE;
+	UINT8 *run = NULL;
+	UINT32 runoffs = 0, runlength = 0;
+	UINT32 dataoffs = 0;
+	for (state_entry *entry = m_entry_list.first(); entry != NULL; entry = entry->next())
+	{
+		const UINT8 *data = (const UINT8 *)entry->m_data;
+		UINT32 totalsize = entry->m_typesize * entry->m_typecount;
+		for (UINT32 pageoffs = 0; pageoffs < totalsize; pageoffs += DELTA_PAGE_SIZE)
+		{
+			UINT32 chunk = MIN(DELTA_PAGE_SIZE, totalsize - pageoffs);
+			if (memcmp(&data[pageoffs], &basedata[dataoffs + pageoffs], chunk) == 0)
+			{
+				run = NULL;
+				continue;
+			}
+
+			// start a new run if this page doesn't continue the last one
+			if (run == NULL || runoffs + runlength != dataoffs + pageoffs)
+			{
+				if (size - destoffs < DELTA_RUN_HEADER_SIZE)
+					return STATERR_WRITE_ERROR;
+				run = &dest[destoffs];
+				runoffs = dataoffs + pageoffs;
+				runlength = 0;
+				destoffs += DELTA_RUN_HEADER_SIZE;
+			}
+			if (size - destoffs < chunk)
+				return STATERR_WRITE_ERROR;
+			memcpy(&dest[destoffs], &data[pageoffs], chunk);
+			destoffs += chunk;
+			runlength += chunk;
+			write_run_header(run, runoffs, runlength);
+		}
+		dataoffs += totalsize;
+	}
+
+	actual = destoffs;
+	return STATERR_NONE;
+}
+
+
+//-------------------------------------------------
+//  read_delta - restore the state from an
+//  uncompressed in-memory save state plus a
+//  delta written against it
+//-------------------------------------------------
+
+save_error save_manager::read_delta(const void *base, UINT32 basesize, const void *buf, UINT32 size)
+{
+	// if we have illegal registrations, return an error
+	if (m_illegal_regs > 0)
+		return STATERR_ILLEGAL_REGISTRATIONS;
+
+	// make sure the base is one of ours
+	const UINT8 *basedata = (const UINT8 *)base;
+	save_error err = validate_delta_base(basedata, basesize);
+	if (err != STATERR_NONE)
+		return err;
+	basedata += HEADER_SIZE;
+
+	// verify the delta header; deltas never leave the process that made
+	// them, so they are always native-endian
+	const UINT8 *src = (const UINT8 *)buf;
+	if (size < HEADER_SIZE)
+		return STATERR_READ_ERROR;
+	if (validate_header(src, machine().system().name, signature(), NULL, "") != STATERR_NONE)
+		return STATERR_INVALID_HEADER;
+	if (src[9] != (NATIVE_ENDIAN_VALUE_LE_BE(0, SS_MSB_FIRST) | SS_DELTA))
+		return STATERR_INVALID_HEADER;
+
+	// verify the runs before touching any state: each must lie within the
+	// delta and within the data, and they must not overlap or go backwards
+	UINT32 datasize = basesize - HEADER_SIZE;
+	UINT32 prevend = 0;
+	for (UINT32 srcoffs = HEADER_SIZE; srcoffs < size; )
+	{
+		if (size - srcoffs < DELTA_RUN_HEADER_SIZE)
+			return STATERR_READ_ERROR;
+		UINT32 runoffs, runlength;
+		read_run_header(&src[srcoffs], runoffs, runlength);
+		srcoffs += DELTA_RUN_HEADER_SIZE;
+		if (size - srcoffs < runlength || runoffs < prevend || runoffs > datasize || runlength > datasize - runoffs)
+			return STATERR_READ_ERROR;
+		srcoffs += runlength;
+		prevend = runoffs + runlength;
+	}
+
+	// restore each entry from the base, then patch in any runs that overlap it
+	UINT32 srcoffs = HEADER_SIZE;
+	UINT32 dataoffs = 0;
+	for (state_entry *entry = m_entry_list.first(); entry != NULL; entry = entry->next())
+	{
+		UINT8 *data = (UINT8 *)entry->m_data;
+		UINT32 totalsize = entry->m_typesize * entry->m_typecount;
+		memcpy(data, &basedata[dataoffs], totalsize);
+
+		while (srcoffs < size)
+		{
+			UINT32 runoffs, runlength;
+			read_run_header(&src[srcoffs], runoffs, runlength);
+			UINT32 runstart = MAX(runoffs, dataoffs);
+			UINT32 runend = MIN(runoffs + runlength, dataoffs + totalsize);
+			if (runstart < runend)
+				memcpy(&data[runstart - dataoffs], &src[srcoffs + DELTA_RUN_HEADER_SIZE + runstart - runoffs], runend - runstart);
+
+			// move on to the next run only once this one is used up
+			if (runoffs + runlength > dataoffs + totalsize)
+				break;
+			srcoffs += DELTA_RUN_HEADER_SIZE + runlength;
+		}
+		dataoffs += totalsize;
+	}
+
+	// call the post-load functions
+	for (state_callback *func = m_postload_list.first(); func != NULL; func = func->next())
+		func->m_func();
+
+	return STATERR_NONE;
+}
+
+
 //-------------------------------------------------
 //  signature - compute the signature, which
 //  is a CRC over the structure of the data
@@ -369,6 +762,40 @@ void save_manager::dump_registry() const
 }
 
 
+//-------------------------------------------------
+//  build_header - fill in a save state header
+//  for the current machine
+//-------------------------------------------------
+
+void save_manager::build_header(UINT8 *header, UINT8 flags) const
+{
+	memcpy(&header[0], emulator_info::get_state_magic_num(), 8);
+	header[8] = SAVE_VERSION;
+	header[9] = NATIVE_ENDIAN_VALUE_LE_BE(0, SS_MSB_FIRST) | flags;
+	strncpy((char *)&header[0x0a], machine().system().name, 0x1c - 0x0a);
+	UINT32 sig = signature();
+	*(UINT32 *)&header[0x1c] = LITTLE_ENDIANIZE_INT32(sig);
+}
+
+
+//-------------------------------------------------
+//  validate_delta_base - make sure that a delta
+//  base is a complete uncompressed in-memory
+//  save state of this machine
+//-------------------------------------------------
+
+save_error save_manager::validate_delta_base(const UINT8 *base, UINT32 basesize) const
+{
+	if (basesize != binary_size())
+		return STATERR_INVALID_HEADER;
+	if (validate_header(base, machine().system().name, signature(), NULL, "") != STATERR_NONE)
+		return STATERR_INVALID_HEADER;
+	if (base[9] != (NATIVE_ENDIAN_VALUE_LE_BE(0, SS_MSB_FIRST) | SS_UNCOMPRESSED))
+		return STATERR_INVALID_HEADER;
+	return STATERR_NONE;
+}
+
+
 //-------------------------------------------------
 //  validate_header - validate the data in the
 //  header
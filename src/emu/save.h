@@ -58,7 +58,10 @@ enum save_error
 	STATERR_ILLEGAL_REGISTRATIONS,
 	STATERR_INVALID_HEADER,
 	STATERR_READ_ERROR,
-	STATERR_WRITE_ERROR
+	STATERR_WRITE_ERROR,
+	STATERR_NOT_REQUESTED,			// no in-memory save or load has been scheduled yet
+	STATERR_PENDING,				// a scheduled in-memory save or load has not happened yet
+	STATERR_CANCELLED				// a scheduled in-memory save or load was abandoned
 };
 
 
@@ -188,10 +191,26 @@ public:
 	save_error write_file(emu_file &file);
 	save_error read_file(emu_file &file);
 
+	// memory processing
+	UINT32 binary_size() const;
+	UINT32 compressed_bound() const;
+	save_error write_buffer(void *buf, UINT32 size, UINT32 &actual, bool compress);
+	save_error read_buffer(const void *buf, UINT32 size);
+
+	// checksum of the state that would be saved right now
+	UINT32 checksum();
+
+	// delta processing against an uncompressed in-memory save state
+	UINT32 delta_bound() const;
+	save_error write_delta(const void *base, UINT32 basesize, void *buf, UINT32 size, UINT32 &actual);
+	save_error read_delta(const void *base, UINT32 basesize, const void *buf, UINT32 size);
+
 private:
 	// internal helpers
 	UINT32 signature() const;
 	void dump_registry() const;
+	void build_header(UINT8 *header, UINT8 flags) const;
+	save_error validate_delta_base(const UINT8 *base, UINT32 basesize) const;
 	static save_error validate_header(const UINT8 *header, const char *gamename, UINT32 signature, void (CLIB_DECL *errormsg)(const char *fmt, ...), const char *error_prefix);
 
 	// state callback item
@@ -238,6 +257,7 @@ private:
 	simple_list<state_entry> m_entry_list;			// list of reigstered entries
 	simple_list<state_callback> m_presave_list;		// list of pre-save functions
 	simple_list<state_callback> m_postload_list;	// list of post-load functions
+	dynamic_buffer			m_inflate_buffer;		// scratch space for checking compressed buffers
 };
 
 
@@ -38,6 +38,7 @@
 ***************************************************************************/
 
 #include "emu.h"
+#include "emuopts.h"
 #include "debugger.h"
 
 
@@ -65,6 +66,19 @@ enum
 
 
 
+//**************************************************************************
+//  GLOBAL VARIABLES
+//**************************************************************************
+
+// the device each thread is executing while devices execute in parallel
+#ifdef _MSC_VER
+static __declspec(thread) device_execute_interface *s_parallel_device;
+#else
+static __thread device_execute_interface *s_parallel_device;
+#endif
+
+
+
 //**************************************************************************
 //  EMU TIMER
 //**************************************************************************
@@ -77,6 +91,7 @@ emu_timer::emu_timer()
 	: m_machine(NULL),
 	  m_next(NULL),
 	  m_prev(NULL),
+	  m_heap_index(-1),
 	  m_param(0),
 	  m_ptr(NULL),
 	  m_enabled(false),
@@ -110,6 +125,7 @@ emu_timer &emu_timer::init(running_machine &machine, timer_expired_delegate call
 	m_machine = &machine;
 	m_next = NULL;
 	m_prev = NULL;
+	m_heap_index = -1;
 	m_callback = callback;
 	m_param = 0;
 	m_ptr = ptr;
@@ -142,6 +158,7 @@ emu_timer &emu_timer::init(device_t &device, device_timer_id id, void *ptr, bool
 	m_machine = &device.machine();
 	m_next = NULL;
 	m_prev = NULL;
+	m_heap_index = -1;
 	m_callback = timer_expired_delegate();
 	m_param = 0;
 	m_ptr = ptr;
@@ -183,16 +200,18 @@ emu_timer &emu_timer::release()
 bool emu_timer::enable(bool enable)
 {
 	// reschedule only if the state has changed
+	device_scheduler &scheduler = machine().scheduler();
+	scheduler.parallel_lock();
 	bool old = m_enabled;
 	if (old != enable)
 	{
 		// set the enable flag
 		m_enabled = enable;
 
-		// remove the timer and insert back into the list
-		machine().scheduler().timer_list_remove(*this);
-		machine().scheduler().timer_list_insert(*this);
+		// move the timer to its new place in the order
+		scheduler.timer_list_reschedule(*this);
 	}
+	scheduler.parallel_unlock();
 	return old;
 }
 
@@ -207,6 +226,7 @@ void emu_timer::adjust(attotime start_delay, INT32 param, attotime period)
 {
 	// if this is the callback timer, mark it modified
 	device_scheduler &scheduler = machine().scheduler();
+	scheduler.parallel_lock();
 	if (scheduler.m_callback_timer == this)
 		scheduler.m_callback_timer_modified = true;
 
@@ -223,13 +243,13 @@ void emu_timer::adjust(attotime start_delay, INT32 param, attotime period)
 	m_expire = m_start + start_delay;
 	m_period = period;
 
-	// remove and re-insert the timer in its new order
-	scheduler.timer_list_remove(*this);
-	scheduler.timer_list_insert(*this);
+	// move the timer to its new place in the order
+	scheduler.timer_list_reschedule(*this);
 
-	// if this was inserted as the head, abort the current timeslice and resync
-	if (this == scheduler.first_timer())
+	// if this is now the next to fire, abort the current timeslice and resync
+	if (this == &scheduler.next_timer())
 		scheduler.abort_timeslice();
+	scheduler.parallel_unlock();
 }
 
 
@@ -307,10 +327,8 @@ void emu_timer::schedule_next_period()
 	m_start = m_expire;
 	m_expire += m_period;
 
-	// remove and re-insert us
-	device_scheduler &scheduler = machine().scheduler();
-	scheduler.timer_list_remove(*this);
-	scheduler.timer_list_insert(*this);
+	// move us to our new place in the order
+	machine().scheduler().timer_list_reschedule(*this);
 }
 
 
@@ -345,17 +363,36 @@ device_scheduler::device_scheduler(running_machine &machine) :
 	m_basetime(attotime::zero),
 //  m_cothread(co_active()),
 	m_timer_list(NULL),
+	m_timer_sequence(0),
 	m_timer_allocator(machine.respool()),
 	m_callback_timer(NULL),
 	m_callback_timer_modified(false),
 	m_callback_timer_expire_time(attotime::zero),
+	m_timeslices(0),
+	m_timers_fired(0),
 	m_quantum_list(machine.respool()),
 	m_quantum_allocator(machine.respool()),
-	m_quantum_minimum(ATTOSECONDS_IN_NSEC(1) / 1000)
+	m_quantum_minimum(ATTOSECONDS_IN_NSEC(1) / 1000),
+	m_parallel_queue(NULL),
+	m_parallel_lock(NULL),
+	m_parallel_active(false)
 {
 	// append a single never-expiring timer so there is always one in the list
-	m_timer_list = &m_timer_allocator.alloc()->init(machine, timer_expired_delegate(), NULL, true);
-	m_timer_list->adjust(attotime::never);
+	m_timer_allocator.alloc()->init(machine, timer_expired_delegate(), NULL, true).adjust(attotime::never);
+
+	// if requested, add a population of do-nothing periodic timers at assorted rates
+	for (int index = 0; index < machine.options().bench_timers(); index++)
+	{
+		attotime period = attotime::from_hz(997 * (index + 1));
+		timer_alloc(timer_expired_delegate(FUNC(device_scheduler::benchmark_timer), this))->adjust(period, index, period);
+	}
+
+	// if the driver allows it and we've been asked to, set up for executing devices in parallel
+	if (machine.config().m_parallel_execution && machine.options().parallel_execution())
+	{
+		m_parallel_queue = osd_work_queue_alloc(WORK_QUEUE_FLAG_MULTI | WORK_QUEUE_FLAG_HIGH_FREQ);
+		m_parallel_lock = osd_lock_alloc();
+	}
 
 	// register global states
 	machine.save().save_item(NAME(m_basetime));
@@ -373,6 +410,12 @@ device_scheduler::~device_scheduler()
 	// remove all timers
 	while (m_timer_list != NULL)
 		m_timer_allocator.reclaim(m_timer_list->release());
+
+	// free the parallel execution state
+	if (m_parallel_queue != NULL)
+		osd_work_queue_free(m_parallel_queue);
+	if (m_parallel_lock != NULL)
+		osd_lock_free(m_parallel_lock);
 }
 
 
@@ -386,8 +429,11 @@ attotime device_scheduler::time() const
 	if (m_callback_timer != NULL)
 		return m_callback_timer_expire_time;
 
-	// if we're executing as a particular CPU, use its local time as a base
+	// if we're executing as a particular CPU, use its local time as a base;
+	// when executing in parallel, that is the CPU this thread is running
 	// otherwise, return the global base time
+	if (m_parallel_active && s_parallel_device != NULL)
+		return s_parallel_device->local_time();
 	return (m_executing_device != NULL) ? m_executing_device->local_time() : m_basetime;
 }
 
@@ -430,17 +476,18 @@ void device_scheduler::timeslice()
 	execute_timers();
 
 	// loop until we hit the next timer
-	while (m_basetime < m_timer_list->m_expire)
+	while (m_basetime < next_timer().m_expire)
 	{
 		// by default, assume our target is the end of the next quantum
 		attotime target = m_basetime + attotime(0, m_quantum_list.first()->m_actual);
 
 		// however, if the next timer is going to fire before then, override
-		if (m_timer_list->m_expire < target)
-			target = m_timer_list->m_expire;
+		if (next_timer().m_expire < target)
+			target = next_timer().m_expire;
 
 		LOG(("------------------\n"));
 		LOG(("cpu_timeslice: target = %s\n", target.as_string()));
+		m_timeslices++;
 
 		// apply pending suspension changes
 		UINT32 suspendchanged = 0;
@@ -456,8 +503,12 @@ void device_scheduler::timeslice()
 		if (suspendchanged != 0)
 			rebuild_execute_list();
 
-		// loop over non-suspended CPUs
-		for (device_execute_interface *exec = m_execute_list; exec != NULL; exec = exec->m_nextexec)
+		// if we can, execute all the CPUs at once
+		if (m_parallel_queue != NULL && !call_debugger)
+			execute_parallel(target);
+
+		// otherwise, loop over non-suspended CPUs
+		else for (device_execute_interface *exec = m_execute_list; exec != NULL; exec = exec->m_nextexec)
 		{
 			// only process if our target is later than the CPU's current time (coarse check)
 			if (target.seconds >= exec->m_localtime.seconds)
@@ -484,6 +535,7 @@ void device_scheduler::timeslice()
 						// via the call to cpu_execute
 						exec->m_cycles_stolen = 0;
 						m_executing_device = exec;
+						exec->m_executing = true;
 						*exec->m_icountptr = exec->m_cycles_running;
 						if (!call_debugger)
 							exec->run();
@@ -493,6 +545,7 @@ void device_scheduler::timeslice()
 							exec->run();
 							debugger_stop_cpu_hook(&exec->device());
 						}
+						exec->m_executing = false;
 
 						// adjust for any cycles we took back
 						assert(ran >= *exec->m_icountptr);
@@ -527,6 +580,120 @@ void device_scheduler::timeslice()
 }
 
 
+//-------------------------------------------------
+//  execute_parallel - execute all CPUs up to the
+//  target at once, each on its own thread, then
+//  account for them in order as timeslice does
+//
+//  While they execute, there is no currently
+//  executing device, but time() called from a
+//  CPU's thread is that CPU's local time, as it
+//  would be serially. Timer changes are
+//  serialized, but the order of any that the CPUs
+//  make is up to the threads; drivers that
+//  declare MCFG_PARALLEL_EXECUTION promise not to
+//  depend on it, and running with
+//  -state_checksums both ways tests the promise.
+//  The FILO profiler isn't thread safe, so CPUs
+//  run on other threads aren't profiled by it.
+//-------------------------------------------------
+
+void device_scheduler::execute_parallel(attotime &target)
+{
+	// work out how long each CPU runs, just as the serial loop does
+	m_parallel_list.resize(0);
+	for (device_execute_interface *exec = m_execute_list; exec != NULL; exec = exec->m_nextexec)
+		if (target.seconds >= exec->m_localtime.seconds)
+		{
+			attoseconds_t delta = target.attoseconds - exec->m_localtime.attoseconds;
+			if (delta < 0 && target.seconds > exec->m_localtime.seconds)
+				delta += ATTOSECONDS_PER_SECOND;
+			if (delta >= exec->m_attoseconds_per_cycle)
+			{
+				exec->m_cycles_running = divu_64x32((UINT64)delta >> exec->m_divshift, exec->m_divisor);
+				m_parallel_list.append(exec);
+			}
+		}
+
+	// queue all but the first and run that one on this thread
+	int count = m_parallel_list.count();
+	if (count == 0)
+		return;
+	m_parallel_active = true;
+	osd_work_item *item = (count > 1) ? osd_work_item_queue_multiple(m_parallel_queue, parallel_execute_callback, count - 1, &m_parallel_list[1], sizeof(m_parallel_list[0]), 0) : NULL;
+	execute_one(*m_parallel_list[0]);
+
+	// if the others couldn't be queued, run them here too
+	if (item == NULL)
+		for (int index = 1; index < count; index++)
+			execute_one(*m_parallel_list[index]);
+
+	// the CPUs can't be accounted for, nor can anything else run, while any are still executing;
+	// some OSDs hand back only the last item of a set, so also wait for the queue to drain
+	else
+	{
+		if (!osd_work_item_wait(item, osd_ticks_per_second() * 100) || !osd_work_queue_wait(m_parallel_queue, osd_ticks_per_second() * 100))
+			fatalerror("Timed out waiting for CPUs executing in parallel\n");
+		osd_work_item_release(item);
+	}
+	m_parallel_active = false;
+
+	// now account for the cycles of each, in order
+	for (int index = 0; index < count; index++)
+	{
+		device_execute_interface *exec = m_parallel_list[index];
+		int ran = exec->m_cycles_running;
+		if (exec->m_suspend == 0)
+		{
+			assert(ran >= *exec->m_icountptr);
+			ran -= *exec->m_icountptr;
+			assert(ran >= exec->m_cycles_stolen);
+			ran -= exec->m_cycles_stolen;
+		}
+		exec->m_totalcycles += ran;
+		exec->m_localtime += attotime(0, exec->m_attoseconds_per_cycle * ran);
+
+		// if the new local CPU time is less than our target, move the target up, but not before the base
+		if (exec->m_localtime < target)
+			target = max(exec->m_localtime, m_basetime);
+	}
+}
+
+
+//-------------------------------------------------
+//  parallel_execute_callback - work queue callback
+//  to execute a single CPU for execute_parallel
+//-------------------------------------------------
+
+void *device_scheduler::parallel_execute_callback(void *param, int threadid)
+{
+	g_profiler_parallel_thread = true;
+	execute_one(**reinterpret_cast<device_execute_interface **>(param));
+	return NULL;
+}
+
+
+//-------------------------------------------------
+//  execute_one - execute a single CPU on the
+//  current thread for execute_parallel
+//-------------------------------------------------
+
+void device_scheduler::execute_one(device_execute_interface &exec)
+{
+	// suspended CPUs just have their time accounted for
+	if (exec.m_suspend == 0)
+	{
+		s_parallel_device = &exec;
+		exec.m_cycles_stolen = 0;
+		exec.m_executing = true;
+		*exec.m_icountptr = exec.m_cycles_running;
+		exec.run();
+		exec.m_executing = false;
+		s_parallel_device = NULL;
+	}
+}
+
+
 //-------------------------------------------------
 //  abort_timeslice - abort execution for the
 //  current timeslice
@@ -534,7 +701,10 @@ void device_scheduler::timeslice()
 
 void device_scheduler::abort_timeslice()
 {
-	if (m_executing_device != NULL)
+	// when executing in parallel, abort the CPU this thread is running
+	if (m_parallel_active && s_parallel_device != NULL)
+		s_parallel_device->abort_timeslice();
+	else if (m_executing_device != NULL)
 		m_executing_device->abort_timeslice();
 }
 
@@ -545,6 +715,8 @@ void device_scheduler::abort_timeslice()
 
 void device_scheduler::trigger(int trigid, attotime after)
 {
+	parallel_lock();
+
 	// ensure we have a list of executing devices
 	if (m_execute_list == NULL)
 		rebuild_execute_list();
@@ -557,6 +729,8 @@ void device_scheduler::trigger(int trigid, attotime after)
 	else
 		for (device_execute_interface *exec = m_execute_list; exec != NULL; exec = exec->m_nextexec)
 			exec->trigger(trigid);
+
+	parallel_unlock();
 }
 
 
@@ -570,7 +744,9 @@ void device_scheduler::boost_interleave(attotime timeslice_time, attotime boost_
 	// ignore timeslices > 1 second
 	if (timeslice_time.seconds > 0)
 		return;
+	parallel_lock();
 	add_scheduling_quantum(timeslice_time, boost_duration);
+	parallel_unlock();
 }
 
 
@@ -581,7 +757,10 @@ void device_scheduler::boost_interleave(attotime timeslice_time, attotime boost_
 
 emu_timer *device_scheduler::timer_alloc(timer_expired_delegate callback, void *ptr)
 {
-	return &m_timer_allocator.alloc()->init(machine(), callback, ptr, false);
+	parallel_lock();
+	emu_timer *timer = &m_timer_allocator.alloc()->init(machine(), callback, ptr, false);
+	parallel_unlock();
+	return timer;
 }
 
 
@@ -593,7 +772,9 @@ emu_timer *device_scheduler::timer_alloc(timer_expired_delegate callback, void *
 
 void device_scheduler::timer_set(attotime duration, timer_expired_delegate callback, int param, void *ptr)
 {
+	parallel_lock();
 	m_timer_allocator.alloc()->init(machine(), callback, ptr, true).adjust(duration, param);
+	parallel_unlock();
 }
 
 
@@ -605,7 +786,9 @@ void device_scheduler::timer_set(attotime duration, timer_expired_delegate callb
 
 void device_scheduler::timer_pulse(attotime period, timer_expired_delegate callback, int param, void *ptr)
 {
+	parallel_lock();
 	m_timer_allocator.alloc()->init(machine(), callback, ptr, false).adjust(period, param, period);
+	parallel_unlock();
 }
 
 
@@ -616,7 +799,10 @@ void device_scheduler::timer_pulse(attotime period, timer_expired_delegate callb
 
 emu_timer *device_scheduler::timer_alloc(device_t &device, device_timer_id id, void *ptr)
 {
-	return &m_timer_allocator.alloc()->init(device, id, ptr, false);
+	parallel_lock();
+	emu_timer *timer = &m_timer_allocator.alloc()->init(device, id, ptr, false);
+	parallel_unlock();
+	return timer;
 }
 
 
@@ -628,7 +814,9 @@ emu_timer *device_scheduler::timer_alloc(device_t &device, device_timer_id id, v
 
 void device_scheduler::timer_set(attotime duration, device_t &device, device_timer_id id, int param, void *ptr)
 {
+	parallel_lock();
 	m_timer_allocator.alloc()->init(device, id, ptr, true).adjust(duration, param);
+	parallel_unlock();
 }
 
 
@@ -655,6 +843,16 @@ void device_scheduler::timed_trigger(void *ptr, INT32 param)
 }
 
 
+//-------------------------------------------------
+//  benchmark_timer - callback for the timers
+//  added by the bench_timers option; does nothing
+//-------------------------------------------------
+
+void device_scheduler::benchmark_timer(void *ptr, INT32 param)
+{
+}
+
+
 //-------------------------------------------------
 //  presave - before creating a save state
 //-------------------------------------------------
@@ -673,11 +871,12 @@ void device_scheduler::presave()
 
 void device_scheduler::postload()
 {
-	// remove all timers and make a private list of permanent ones
-	simple_list<emu_timer> private_list;
-	while (m_timer_list != NULL)
+	// remove all timers in their pre-load order and make a private list of permanent ones;
+	// the heap entries still hold the pre-load sort keys, so this is the order they were in
+	dynamic_array<emu_timer *> private_list;
+	while (m_timer_heap.count() != 0)
 	{
-		emu_timer &timer = *m_timer_list;
+		emu_timer &timer = next_timer();
 
 		// temporary timers go away entirely (except our special never-expiring one)
 		if (timer.m_temporary && timer.expire() != attotime::never)
@@ -685,13 +884,12 @@ void device_scheduler::postload()
 
 		// permanent ones get added to our private list
 		else
-			private_list.append(timer_list_remove(timer));
+			private_list.append(&timer_list_remove(timer));
 	}
 
 	// now re-insert them; this effectively re-sorts them by time
-	emu_timer *timer;
-	while ((timer = private_list.detach_head()) != NULL)
-		timer_list_insert(*timer);
+	for (int index = 0; index < private_list.count(); index++)
+		timer_list_insert(*private_list[index]);
 
 	// report the timer state after a log
 	logerror("After resetting/reordering timers:\n");
@@ -813,51 +1011,38 @@ void device_scheduler::rebuild_execute_list()
 
 
 //-------------------------------------------------
-//  timer_list_insert - insert a new timer into
-//  the list at the appropriate location
+//  timer_list_insert - add a new timer to the
+//  list and insert it into the heap at the
+//  appropriate location
 //-------------------------------------------------
 
 emu_timer &device_scheduler::timer_list_insert(emu_timer &timer)
 {
-	// disabled timers sort to the end
-	attotime expire = timer.m_enabled ? timer.m_expire : attotime::never;
-
-	// loop over the timer list
-	emu_timer *prevtimer = NULL;
-	for (emu_timer *curtimer = m_timer_list; curtimer != NULL; prevtimer = curtimer, curtimer = curtimer->next())
-	{
-		// if the current list entry expires after us, we should be inserted before it
-		if (curtimer->m_expire > expire)
-		{
-			// link the new guy in before the current list entry
-			timer.m_prev = curtimer->m_prev;
-			timer.m_next = curtimer;
-
-			if (curtimer->m_prev != NULL)
-				curtimer->m_prev->m_next = &timer;
-			else
-				m_timer_list = &timer;
-
-			curtimer->m_prev = &timer;
-			return timer;
-		}
-	}
-
-	// need to insert after the last one
-	if (prevtimer != NULL)
-		prevtimer->m_next = &timer;
-	else
-		m_timer_list = &timer;
-
-	timer.m_prev = prevtimer;
-	timer.m_next = NULL;
+	// link it in at the head of the list
+	timer.m_prev = NULL;
+	timer.m_next = m_timer_list;
+	if (m_timer_list != NULL)
+		m_timer_list->m_prev = &timer;
+	m_timer_list = &timer;
+
+	// add an entry at the end of the heap; disabled timers sort to the end, and
+	// timers that expire at the same time sort in the order they were inserted
+	timer_heap_entry entry;
+	entry.m_expire = timer.m_enabled ? timer.m_expire : attotime::never;
+	entry.m_sequence = m_timer_sequence++;
+	entry.m_timer = &timer;
+	m_timer_heap.append(entry);
+
+	// then move it into place
+	timer.m_heap_index = m_timer_heap.count() - 1;
+	timer_heap_update(timer.m_heap_index);
 	return timer;
 }
 
 
 //-------------------------------------------------
 //  timer_list_remove - remove a timer from the
-//  linked list
+//  list and the heap
 //-------------------------------------------------
 
 emu_timer &device_scheduler::timer_list_remove(emu_timer &timer)
@@ -871,10 +1056,98 @@ emu_timer &device_scheduler::timer_list_remove(emu_timer &timer)
 	if (timer.m_next != NULL)
 		timer.m_next->m_prev = timer.m_prev;
 
+	// fill its heap slot with the last entry, and move that into place
+	int index = timer.m_heap_index;
+	int last = m_timer_heap.count() - 1;
+	if (index != last)
+		timer_heap_set(index, m_timer_heap[last]);
+	m_timer_heap.resize(last, true);
+	if (index != last)
+		timer_heap_update(index);
+
+	timer.m_heap_index = -1;
 	return timer;
 }
 
 
+//-------------------------------------------------
+//  timer_list_reschedule - move a timer to its
+//  place in the heap after its expiration time
+//  or enable state has changed; this orders it
+//  exactly as removing and re-inserting would
+//-------------------------------------------------
+
+void device_scheduler::timer_list_reschedule(emu_timer &timer)
+{
+	timer_heap_entry &entry = m_timer_heap[timer.m_heap_index];
+	entry.m_expire = timer.m_enabled ? timer.m_expire : attotime::never;
+	entry.m_sequence = m_timer_sequence++;
+	timer_heap_update(timer.m_heap_index);
+}
+
+
+//-------------------------------------------------
+//  timer_heap_set - store an entry in the heap
+//  and tell its timer where it is
+//-------------------------------------------------
+
+void device_scheduler::timer_heap_set(int index, const timer_heap_entry &entry)
+{
+	m_timer_heap[index] = entry;
+	entry.m_timer->m_heap_index = index;
+}
+
+
+//-------------------------------------------------
+//  timer_heap_update - sift the entry at the
+//  given index up or down to its place
+//-------------------------------------------------
+
+void device_scheduler::timer_heap_update(int index)
+{
+	timer_heap_entry entry = m_timer_heap[index];
+
+	// if it sorts before its parent, move it up
+	if (index > 0 && entry < m_timer_heap[(index - 1) / 4])
+	{
+		do
+		{
+			int parent = (index - 1) / 4;
+			if (!(entry < m_timer_heap[parent]))
+				break;
+			timer_heap_set(index, m_timer_heap[parent]);
+			index = parent;
+		} while (index > 0);
+	}
+
+	// otherwise, move it down until none of its children sort before it
+	else
+	{
+		int count = m_timer_heap.count();
+		while (true)
+		{
+			int first = index * 4 + 1;
+			if (first >= count)
+				break;
+
+			// find the earliest of up to 4 children
+			int best = first;
+			int last = MIN(first + 4, count);
+			for (int child = first + 1; child < last; child++)
+				if (m_timer_heap[child] < m_timer_heap[best])
+					best = child;
+
+			if (!(m_timer_heap[best] < entry))
+				break;
+			timer_heap_set(index, m_timer_heap[best]);
+			index = best;
+		}
+	}
+
+	timer_heap_set(index, entry);
+}
+
+
 //-------------------------------------------------
 //  execute_timers - execute timers and update
 //  scheduling quanta
@@ -886,13 +1159,13 @@ void device_scheduler::execute_timers()
 	while (m_basetime >= m_quantum_list.first()->m_expire)
 		m_quantum_allocator.reclaim(m_quantum_list.detach_head());
 
-	LOG(("timer_set_global_time: new=%s head->expire=%s\n", m_basetime.as_string(), m_timer_list->m_expire.as_string()));
+	LOG(("timer_set_global_time: new=%s head->expire=%s\n", m_basetime.as_string(), next_timer().m_expire.as_string()));
 
 	// now process any timers that are overdue
-	while (m_timer_list->m_expire <= m_basetime)
+	while (next_timer().m_expire <= m_basetime)
 	{
 		// if this is a one-shot timer, disable it now
-		emu_timer &timer = *m_timer_list;
+		emu_timer &timer = next_timer();
 		bool was_enabled = timer.m_enabled;
 		if (timer.m_period == attotime::zero || timer.m_period == attotime::never)
 			timer.m_enabled = false;
@@ -906,6 +1179,7 @@ void device_scheduler::execute_timers()
 		if (was_enabled)
 		{
 			g_profiler.start(PROFILER_TIMER_CALLBACK);
+			m_timers_fired++;
 
 			if (timer.m_device != NULL)
 				timer.m_device->timer_expired(timer, timer.m_id, timer.m_param, timer.m_ptr);
@@ -126,8 +126,9 @@ private:
 
 	// internal state
 	running_machine *	m_machine;		// reference to the owning machine
-	emu_timer *			m_next;			// next timer in order in the list
-	emu_timer *			m_prev;			// previous timer in order in the list
+	emu_timer *			m_next;			// next timer in the list of all timers
+	emu_timer *			m_prev;			// previous timer in the list of all timers
+	int					m_heap_index;	// index of our entry in the scheduler's timer heap
 	timer_expired_delegate m_callback;	// callback function
 	INT32				m_param;		// integer parameter
 	void *				m_ptr;			// pointer parameter
@@ -159,6 +160,8 @@ public:
 	emu_timer *first_timer() const { return m_timer_list; }
 	device_execute_interface *currently_executing() const { return m_executing_device; }
 	bool can_save() const;
+	UINT64 timeslices() const { return m_timeslices; }
+	UINT64 timers_fired() const { return m_timers_fired; }
 
 	// execution
 	void timeslice();
@@ -196,6 +199,11 @@ private:
 	void postload();
 
 	// scheduling helpers
+	void execute_parallel(attotime &target);
+	static void *parallel_execute_callback(void *param, int threadid);
+	static void execute_one(device_execute_interface &exec);
+	void parallel_lock() { if (m_parallel_active) osd_lock_acquire(m_parallel_lock); }
+	void parallel_unlock() { if (m_parallel_active) osd_lock_release(m_parallel_lock); }
 	void compute_perfect_interleave();
 	void rebuild_execute_list();
 	void add_scheduling_quantum(attotime quantum, attotime duration);
@@ -203,7 +211,24 @@ private:
 	// timer helpers
 	emu_timer &timer_list_insert(emu_timer &timer);
 	emu_timer &timer_list_remove(emu_timer &timer);
+	void timer_list_reschedule(emu_timer &timer);
+	emu_timer &next_timer() const { return *m_timer_heap[0].m_timer; }
 	void execute_timers();
+	void benchmark_timer(void *ptr, INT32 param);
+
+	// timer heap entries; the sort key is copied in so that sifting never touches the timers
+	struct timer_heap_entry
+	{
+		bool operator<(const timer_heap_entry &rhs) const { return (m_expire < rhs.m_expire) || (m_expire == rhs.m_expire && m_sequence < rhs.m_sequence); }
+
+		attotime				m_expire;					// expiration time, or never if disabled
+		UINT64					m_sequence;					// order of insertion, to break ties
+		emu_timer *				m_timer;					// the timer itself
+	};
+
+	// timer heap helpers
+	void timer_heap_set(int index, const timer_heap_entry &entry);
+	void timer_heap_update(int index);
 
 	// internal state
 	running_machine &			m_machine;					// reference to our machine
@@ -212,8 +237,10 @@ private:
 	attotime					m_basetime;					// global basetime; everything moves forward from here
 //  cothread                    m_cothread;                 // core scheduler thread
 
-	// list of active timers
-	emu_timer *					m_timer_list;				// head of the active list
+	// list of all timers, and a 4-ary min-heap of them in the order they will fire
+	emu_timer *					m_timer_list;				// head of the list, in no particular order
+	dynamic_array<timer_heap_entry> m_timer_heap;			// heap of timers by expiration time
+	UINT64						m_timer_sequence;			// sequence number of the next heap entry
 	fixed_allocator<emu_timer>	m_timer_allocator;			// allocator for timers
 
 	// other internal states
@@ -221,6 +248,10 @@ private:
 	bool						m_callback_timer_modified;	// true if the current callback timer was modified
 	attotime					m_callback_timer_expire_time; // the original expiration time
 
+	// statistics
+	UINT64						m_timeslices;				// number of timeslices executed
+	UINT64						m_timers_fired;				// number of timer callbacks called
+
 	// scheduling quanta
 	class quantum_slot
 	{
@@ -237,6 +268,12 @@ private:
 	simple_list<quantum_slot>	m_quantum_list;				// list of active quanta
 	fixed_allocator<quantum_slot> m_quantum_allocator;		// allocator for quanta
 	attoseconds_t				m_quantum_minimum;			// duration of minimum quantum
+
+	// parallel execution
+	osd_work_queue *			m_parallel_queue;			// queue for executing devices in parallel, or NULL if not
+	osd_lock *					m_parallel_lock;			// lock serializing timer changes made while in parallel
+	volatile bool				m_parallel_active;			// true while devices are executing in parallel
+	dynamic_array<device_execute_interface *> m_parallel_list;	// devices executing in the current pass
 };
 
 
@@ -90,6 +90,7 @@ screen_device::screen_device(const machine_config &mconfig, const char *tag, dev
 	  m_curtexture(0),
 	  m_changed(true),
 	  m_last_partial_scan(0),
+	  m_dirty_rows_valid(false),
 	  m_frame_period(DEFAULT_FRAME_PERIOD.as_attoseconds()),
 	  m_scantime(1),
 	  m_pixeltime(1),
@@ -521,6 +522,10 @@ void screen_device::realloc_screen_bitmaps()
 	// re-set up textures
 	m_texture[0]->set_bitmap(m_bitmap[0], m_visarea, m_bitmap[0].texformat());
 	m_texture[1]->set_bitmap(m_bitmap[1], m_visarea, m_bitmap[1].texformat());
+
+	// the previous frame is gone, so the next one is dirty everywhere
+	m_dirty_rows.resize(effheight);
+	m_dirty_rows_valid = false;
 }
 
 
@@ -765,6 +770,47 @@ void screen_device::register_vblank_callback(vblank_state_delegate vblank_callba
 }
 
 
+//-------------------------------------------------
+//  register_frame_callback - registers a callback
+//  made each time a new frame is completed
+//-------------------------------------------------
+
+void screen_device::register_frame_callback(screen_frame_delegate frame_callback)
+{
+	// validate arguments
+	assert(!frame_callback.isnull());
+
+	// check if we already have this callback registered
+	frame_callback_item *item;
+	for (item = m_frame_callback_list.first(); item != NULL; item = item->next())
+		if (item->m_callback == frame_callback)
+			break;
+
+	// if not found, register; its first frame has nothing reported to compare against
+	if (item == NULL)
+	{
+		m_frame_callback_list.append(*global_alloc(frame_callback_item(frame_callback)));
+		m_dirty_rows_valid = false;
+	}
+}
+
+
+//-------------------------------------------------
+//  unregister_frame_callback - removes a callback
+//  previously added with register_frame_callback
+//-------------------------------------------------
+
+void screen_device::unregister_frame_callback(screen_frame_delegate frame_callback)
+{
+	for (frame_callback_item *item = m_frame_callback_list.first(); item != NULL; item = item->next())
+		if (item->m_callback == frame_callback)
+		{
+			m_frame_callback_list.remove(*item);
+			break;
+		}
+}
+
+
 //-------------------------------------------------
 //  register_screen_bitmap - registers a bitmap
 //  that should track the screen size
@@ -865,6 +911,14 @@ bool screen_device::update_quads()
 				m_texture[m_curbitmap]->set_bitmap(m_bitmap[m_curbitmap], m_visarea, m_bitmap[m_curbitmap].texformat());
 				m_curtexture = m_curbitmap;
 				m_curbitmap = 1 - m_curbitmap;
+
+				// let anyone interested see the new frame
+				if (m_frame_callback_list.first() != NULL)
+				{
+					compute_dirty_rows();
+					for (frame_callback_item *item = m_frame_callback_list.first(); item != NULL; item = item->next())
+						item->m_callback(*this);
+				}
 			}
 
 			// create an empty container with a single quad
@@ -880,6 +934,26 @@ bool screen_device::update_quads()
 }
 
 
+//-------------------------------------------------
+//  compute_dirty_rows - flag the visible rows of
+//  the frame just completed that differ from the
+//  frame before it
+//-------------------------------------------------
+
+void screen_device::compute_dirty_rows()
+{
+	// the previous frame now lives in the bitmap about to be drawn into
+	bitmap_t &curframe = m_bitmap[m_curtexture];
+	bitmap_t &prevframe = m_bitmap[m_curbitmap];
+	UINT32 rowbytes = (m_visarea.max_x + 1 - m_visarea.min_x) * curframe.bpp() / 8;
+
+	memset(m_dirty_rows, 0, m_dirty_rows.count());
+	for (INT32 y = m_visarea.min_y; y <= m_visarea.max_y && y < (INT32)m_dirty_rows.count(); y++)
+		m_dirty_rows[y] = !m_dirty_rows_valid || memcmp(curframe.raw_pixptr(y, m_visarea.min_x), prevframe.raw_pixptr(y, m_visarea.min_x), rowbytes) != 0;
+	m_dirty_rows_valid = true;
+}
+
+
 //-------------------------------------------------
 //  update_burnin - update the burnin bitmap
 //-------------------------------------------------
@@ -150,6 +150,7 @@ private:
 // ======================> other delegate types
 
 typedef delegate<void (screen_device &, bool)> vblank_state_delegate;
+typedef delegate<void (screen_device &)> screen_frame_delegate;
 
 typedef device_delegate<UINT32 (screen_device &, bitmap_ind16 &, const rectangle &)> screen_update_ind16_delegate;
 typedef device_delegate<UINT32 (screen_device &, bitmap_rgb32 &, const rectangle &)> screen_update_rgb32_delegate;
@@ -226,9 +227,15 @@ public:
 
 	// additional helpers
 	void register_vblank_callback(vblank_state_delegate vblank_callback);
+	void register_frame_callback(screen_frame_delegate frame_callback);
+	void unregister_frame_callback(screen_frame_delegate frame_callback);
 	void register_screen_bitmap(bitmap_t &bitmap);
 	int vblank_port_read();
 
+	// most recently completed frame, valid during frame callbacks
+	screen_bitmap &frame_bitmap() { return m_bitmap[m_curtexture]; }
+	const UINT8 *frame_dirty_rows() const { return m_dirty_rows; }
+
 	// internal to the video system
 	bool update_quads();
 	void update_burnin();
@@ -260,6 +267,7 @@ private:
 	void vblank_begin();
 	void vblank_end();
 	void finalize_burnin();
+	void compute_dirty_rows();
 	void load_effect_overlay(const char *filename);
 
 	// inline configuration data
@@ -291,6 +299,8 @@ private:
 	bool				m_changed;					// has this bitmap changed?
 	INT32				m_last_partial_scan;		// scanline of last partial update
 	bitmap_argb32		m_screen_overlay_bitmap;	// screen overlay bitmap
+	dynamic_buffer		m_dirty_rows;				// per-row flags: changed since the previous frame?
+	bool				m_dirty_rows_valid;			// does the other bitmap hold the previous frame?
 
 	// screen timing
 	attoseconds_t		m_frame_period;				// attoseconds per frame
@@ -320,6 +330,20 @@ private:
 	};
 	simple_list<callback_item> m_callback_list;		// list of VBLANK callbacks
 
+	// frame callbacks
+	class frame_callback_item
+	{
+	public:
+		frame_callback_item(screen_frame_delegate callback)
+			: m_next(NULL),
+			  m_callback(callback) { }
+		frame_callback_item *next() const { return m_next; }
+
+		frame_callback_item *		m_next;
+		screen_frame_delegate		m_callback;
+	};
+	simple_list<frame_callback_item> m_frame_callback_list; // list of frame callbacks
+
 	// auto-sizing bitmaps
 	class auto_bitmap_item
 	{
@@ -800,6 +800,8 @@ sound_manager::sound_manager(running_machine &machine)
 	  m_finalmix(machine.sample_rate()),
 	  m_leftmix(machine.sample_rate()),
 	  m_rightmix(machine.sample_rate()),
+	  m_audio_format(AUDIO_FORMAT_INT16),
+	  m_float_channels(2),
 	  m_muted(0),
 	  m_attenuation(0),
 	  m_nosound_mode(!machine.options().sound()),
@@ -825,6 +827,22 @@ sound_manager::sound_manager(running_machine &machine)
 	if (wavfile[0] != 0)
 		m_wavfile = wav_open(wavfile, machine.sample_rate(), 2);
 
+	// determine the format of audio to hand to the OSD
+	const char *format = machine.options().audio_format();
+	if (strcmp(format, "float") == 0)
+		m_audio_format = AUDIO_FORMAT_FLOAT;
+	else if (strcmp(format, "float_speakers") == 0)
+	{
+		speaker_device_iterator iter(machine.root_device());
+		m_audio_format = AUDIO_FORMAT_FLOAT_SPEAKERS;
+		m_float_channels = iter.count();
+		m_speakermix.resize(m_float_channels);
+	}
+	else if (strcmp(format, "int16") != 0)
+		mame_printf_warning("Unknown audio_format '%s', using int16\n", format);
+	if (m_audio_format != AUDIO_FORMAT_INT16)
+		m_floatmix.resize(machine.sample_rate() * MAX(m_float_channels, 2) / 2);
+
 	// register callbacks
 	config_register(machine, "mixer", config_saveload_delegate(FUNC(sound_manager::config_load), this), config_saveload_delegate(FUNC(sound_manager::config_save), this));
 	machine.add_notifier(MACHINE_NOTIFY_PAUSE, machine_notify_delegate(FUNC(sound_manager::pause), this));
@@ -1029,14 +1047,22 @@ void sound_manager::update(void *ptr, int param)
 
 	// force all the speaker streams to generate the proper number of samples
 	int samples_this_update = 0;
+	int speakernum = 0;
+	bool suppress = ((m_muted & MUTE_REASON_SYSTEM) != 0);
 	speaker_device_iterator iter(machine().root_device());
 	for (speaker_device *speaker = iter.first(); speaker != NULL; speaker = iter.next())
-		speaker->mix(m_leftmix, m_rightmix, samples_this_update, (m_muted & MUTE_REASON_SYSTEM));
+	{
+		const stream_sample_t *speakermix = speaker->mix(m_leftmix, m_rightmix, samples_this_update, suppress);
+		if (m_audio_format == AUDIO_FORMAT_FLOAT_SPEAKERS)
+			m_speakermix[speakernum++] = suppress ? NULL : speakermix;
+	}
 
 	// now downmix the final result
 	UINT32 finalmix_step = machine().video().speed_factor();
 	UINT32 finalmix_offset = 0;
 	INT16 *finalmix = m_finalmix;
+	float *floatmix = m_floatmix;
+	UINT32 floatmix_offset = 0;
 	int sample;
 	for (sample = m_finalmix_leftover; sample < samples_this_update * 1000; sample += finalmix_step)
 	{
@@ -1057,14 +1083,26 @@ void sound_manager::update(void *ptr, int param)
 		else if (samp > 32767)
 			samp = 32767;
 		finalmix[finalmix_offset++] = samp;
+
+		// floating-point output skips the clamping
+		if (m_audio_format == AUDIO_FORMAT_FLOAT)
+		{
+			floatmix[floatmix_offset++] = m_leftmix[sampindex] * (1.0f / 32768.0f);
+			floatmix[floatmix_offset++] = m_rightmix[sampindex] * (1.0f / 32768.0f);
+		}
+		else if (m_audio_format == AUDIO_FORMAT_FLOAT_SPEAKERS)
+			for (int channel = 0; channel < m_float_channels; channel++)
+				floatmix[floatmix_offset++] = (m_speakermix[channel] == NULL) ? 0.0f : m_speakermix[channel][sampindex] * (1.0f / 32768.0f);
 	}
 	m_finalmix_leftover = sample - samples_this_update * 1000;
 
 	// play the result
 	if (finalmix_offset > 0)
 	{
-		if (!m_nosound_mode)
+		if (!m_nosound_mode && m_audio_format == AUDIO_FORMAT_INT16)
 			machine().osd().update_audio_stream(finalmix, finalmix_offset / 2);
+		else if (!m_nosound_mode)
+			machine().osd().update_audio_stream_float(floatmix, m_float_channels, finalmix_offset / 2);
 		machine().video().add_sound_to_recording(finalmix, finalmix_offset / 2);
 		if (m_wavfile != NULL)
 			wav_add_data_16(m_wavfile, finalmix, finalmix_offset);
@@ -212,6 +212,11 @@ class sound_manager
 	// stream updates
 	static const attotime STREAMS_UPDATE_ATTOTIME;
 
+	// formats of audio passed to the OSD
+	static const int AUDIO_FORMAT_INT16 = 0;
+	static const int AUDIO_FORMAT_FLOAT = 1;
+	static const int AUDIO_FORMAT_FLOAT_SPEAKERS = 2;
+
 public:
 	static const int STREAMS_UPDATE_FREQUENCY = 50;
 
@@ -258,6 +263,10 @@ private:
 	dynamic_array<INT16> m_finalmix;
 	dynamic_array<INT32> m_leftmix;
 	dynamic_array<INT32> m_rightmix;
+	int					m_audio_format;			// format of audio passed to the OSD
+	int					m_float_channels;		// channels of floating-point audio
+	dynamic_array<float> m_floatmix;			// floating-point audio for the OSD
+	dynamic_array<const stream_sample_t *> m_speakermix;	// each speaker's samples this update
 
 	UINT8				m_muted;
 	int 				m_attenuation;
@@ -117,14 +117,15 @@ void speaker_device::static_set_position(device_t &device, double x, double y, d
 
 
 //-------------------------------------------------
-//  mix - mix in samples from the speaker's stream
+//  mix - mix in samples from the speaker's stream,
+//  returning the stream's samples for this update
 //-------------------------------------------------
 
-void speaker_device::mix(INT32 *leftmix, INT32 *rightmix, int &samples_this_update, bool suppress)
+const stream_sample_t *speaker_device::mix(INT32 *leftmix, INT32 *rightmix, int &samples_this_update, bool suppress)
 {
 	// skip if no stream
 	if (m_mixer_stream == NULL)
-		return;
+		return NULL;
 
 	// update the stream, getting the start/end pointers around the operation
 	int numsamples;
@@ -176,6 +177,7 @@ void speaker_device::mix(INT32 *leftmix, INT32 *rightmix, int &samples_this_upda
 			for (int sample = 0; sample < samples_this_update; sample++)
 				rightmix[sample] += stream_buf[sample];
 	}
+	return stream_buf;
 }
 
 
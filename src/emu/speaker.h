@@ -94,7 +94,7 @@ public:
 	static void static_set_position(device_t &device, double x, double y, double z);
 
 	// internally for use by the sound system
-	void mix(INT32 *leftmix, INT32 *rightmix, int &samples_this_update, bool suppress);
+	const stream_sample_t *mix(INT32 *leftmix, INT32 *rightmix, int &samples_this_update, bool suppress);
 
 protected:
 	// device-level overrides
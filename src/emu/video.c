@@ -116,6 +116,7 @@ video_manager::video_manager(running_machine &machine)
 	  m_skipping_this_frame(false),
 	  m_average_oversleep(0),
 	  m_snap_target(NULL),
+	  m_snap_queue(NULL),
 	  m_snap_native(true),
 	  m_snap_width(0),
 	  m_snap_height(0),
@@ -157,6 +158,9 @@ video_manager::video_manager(running_machine &machine)
 		m_snap_target->set_screen_overlay_enabled(false);
 	}
 
+	// snapshots and movie frames can be large, so render them on all the processors
+	m_snap_queue = osd_work_queue_alloc(WORK_QUEUE_FLAG_MULTI);
+
 	// extract snap resolution if present
 	if (sscanf(machine.options().snap_size(), "%dx%d", &m_snap_width, &m_snap_height) != 2)
 		m_snap_width = m_snap_height = 0;
@@ -533,6 +537,9 @@ void video_manager::exit()
 	// free the snapshot target
 	machine().render().target_free(m_snap_target);
 	m_snap_bitmap.reset();
+	if (m_snap_queue != NULL)
+		osd_work_queue_free(m_snap_queue);
+	m_snap_queue = NULL;
 
 	// print a final result if we have at least 2 seconds' worth of data
 	if (m_overall_emutime.seconds >= 1)
@@ -1068,7 +1075,7 @@ void video_manager::create_snapshot_bitmap(screen_device *screen)
 	// render the screen there
 	render_primitive_list &primlist = m_snap_target->get_primitives();
 	primlist.acquire_lock();
-	software_renderer<UINT32, 0,0,0, 16,8,0, false, true>::draw_primitives(primlist, &m_snap_bitmap.pix32(0), width, height, m_snap_bitmap.rowpixels());
+	software_renderer<UINT32, 0,0,0, 16,8,0, false, true>::draw_primitives(primlist, &m_snap_bitmap.pix32(0), width, height, m_snap_bitmap.rowpixels(), m_snap_queue);
 	primlist.release_lock();
 }
 
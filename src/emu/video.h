@@ -182,6 +182,7 @@ private:
 	// snapshot stuff
 	render_target *		m_snap_target;				// screen shapshot target
 	bitmap_rgb32		m_snap_bitmap;				// screen snapshot bitmap
+	osd_work_queue *	m_snap_queue;				// queue for rendering snapshot bands in parallel
 	bool				m_snap_native;				// are we using native per-screen layouts?
 	INT32				m_snap_width;				// width of snapshots (0 == auto)
 	INT32				m_snap_height;				// height of snapshots (0 == auto)
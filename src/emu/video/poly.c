@@ -9,6 +9,10 @@
 #include "emu.h"
 #include "poly.h"
 
+#if (defined(__SSE2__) && defined(PTR64))
+#include <emmintrin.h>
+#endif
+
 
 /***************************************************************************
     DEBUGGING
@@ -33,6 +37,7 @@
 #define CACHE_LINE_SIZE					64			/* this is a general guess */
 #define TOTAL_BUCKETS					(512 / SCANLINES_PER_BUCKET)
 #define UNITS_PER_POLY					(100 / SCANLINES_PER_BUCKET)
+#define UNITS_PER_BATCH					64
 
 
 
@@ -152,6 +157,7 @@ struct _poly_manager
 	/* triangle work units */
 	work_unit **		unit;					/* array of work unit pointers */
 	UINT32				unit_next;				/* index of next unit to allocate */
+	UINT32				unit_queued;			/* index of first unit not yet queued */
 	UINT32				unit_count;				/* number of work units available */
 	size_t				unit_size;				/* size of each work unit, in bytes */
 
@@ -189,6 +195,9 @@ struct _poly_manager
 	UINT32				polygon_max;			/* maximum polygons used */
 	UINT32				extra_waits;			/* number of times we waited for an extra data */
 	UINT32				extra_max;				/* maximum extra data used */
+	UINT32				waits;					/* number of calls to poly_wait */
+	osd_ticks_t			wait_ticks;				/* total time spent waiting */
+	osd_ticks_t			setup_ticks;			/* total time spent setting up polygons */
 	UINT32				conflicts[WORK_MAX_THREADS]; /* number of conflicts found, per thread */
 	UINT32				resolved[WORK_MAX_THREADS];	/* number of conflicts resolved, per thread */
 #endif
@@ -223,6 +232,37 @@ INLINE INT32 round_coordinate(float value)
 }
 
 
+#if (defined(__SSE2__) && defined(PTR64))
+
+/*-------------------------------------------------
+    round_coordinate_sse2 - round four coordinates
+    at once, exactly as round_coordinate does
+-------------------------------------------------*/
+
+INLINE __m128i round_coordinate_sse2(__m128 value)
+{
+	/* truncate, then step down one where that rounded up to get floor */
+	__m128i result = _mm_cvttps_epi32(value);
+	result = _mm_add_epi32(result, _mm_castps_si128(_mm_cmpgt_ps(_mm_cvtepi32_ps(result), value)));
+
+	/* compare masks are -1, so subtracting them rounds up */
+	return _mm_sub_epi32(result, _mm_castps_si128(_mm_cmpgt_ps(_mm_sub_ps(value, _mm_cvtepi32_ps(result)), _mm_set1_ps(0.5f))));
+}
+
+
+/*-------------------------------------------------
+    select_sse2 - pick each lane from a where the
+    mask is set and from b where it isn't
+-------------------------------------------------*/
+
+INLINE __m128i select_sse2(__m128i mask, __m128i a, __m128i b)
+{
+	return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+#endif
+
+
 /*-------------------------------------------------
     convert_tri_extent_to_poly_extent - convert
     a simple tri_extent to a full poly_extent
@@ -306,6 +346,151 @@ INLINE polygon_info *allocate_polygon(poly_manager *poly, int miny, int maxy)
 }
 
 
+/*-------------------------------------------------
+    allocate_unit - allocate a new work unit and
+    chain it behind the last unit in its bucket
+-------------------------------------------------*/
+
+INLINE work_unit *allocate_unit(poly_manager *poly, polygon_info *polygon, INT32 scanline, int count)
+{
+	UINT32 bucketnum = ((UINT32)scanline / SCANLINES_PER_BUCKET) % TOTAL_BUCKETS;
+	UINT32 unit_index = poly->unit_next++;
+	work_unit *unit = poly->unit[unit_index];
+
+	/* fill in the work unit basics */
+	unit->shared.polygon = polygon;
+	unit->shared.count_next = count;
+	unit->shared.scanline = scanline;
+	unit->shared.previtem = poly->unit_bucket[bucketnum];
+	poly->unit_bucket[bucketnum] = unit_index;
+	return unit;
+}
+
+
+/*-------------------------------------------------
+    queue_units - hand the work units allocated
+    since the last call to the work queue, once
+    enough have built up to be worth a batch
+-------------------------------------------------*/
+
+INLINE void queue_units(poly_manager *poly, int force)
+{
+	UINT32 count = poly->unit_next - poly->unit_queued;
+
+	/* units only ever depend on earlier ones, so any split into batches is safe */
+	if (poly->queue != NULL && count > 0 && (force || count >= UNITS_PER_BATCH))
+	{
+		osd_work_item_queue_multiple(poly->queue, poly_item_callback, count, poly->unit[poly->unit_queued], poly->unit_size, WORK_ITEM_FLAG_AUTO_RELEASE);
+		poly->unit_queued = poly->unit_next;
+	}
+}
+
+
+/*-------------------------------------------------
+    compute_tri_extents - compute the clipped
+    extents of one bucket's worth of scanlines
+    of a triangle, returning the pixel count
+-------------------------------------------------*/
+
+INLINE INT32 compute_tri_extents(poly_manager *poly, const rectangle &cliprect, const poly_vertex *v1, const poly_vertex *v2, float dxdy_v1v2, float dxdy_v1v3, float dxdy_v2v3, INT32 scanline, int count, tri_extent *extent)
+{
+	INT32 pixels = 0;
+	int extnum = 0;
+
+#if (defined(__SSE2__) && defined(PTR64))
+	/* do four scanlines at a time, with the same operations as the loop below */
+	if (count >= 4)
+	{
+		__m128 v1x = _mm_set1_ps(v1->x), v1y = _mm_set1_ps(v1->y);
+		__m128 v2x = _mm_set1_ps(v2->x), v2y = _mm_set1_ps(v2->y);
+		__m128 slope12 = _mm_set1_ps(dxdy_v1v2), slope13 = _mm_set1_ps(dxdy_v1v3), slope23 = _mm_set1_ps(dxdy_v2v3);
+		__m128i minx = _mm_set1_epi32(cliprect.min_x);
+		__m128i maxx = _mm_set1_epi32(cliprect.max_x + 1);
+		__m128i rightedge = _mm_set1_epi32((poly->flags & POLYFLAG_INCLUDE_RIGHT_EDGE) ? 1 : 0);
+		__m128i total = _mm_setzero_si128();
+
+		for ( ; extnum + 4 <= count; extnum += 4)
+		{
+			__m128 fully = _mm_add_ps(_mm_cvtepi32_ps(_mm_add_epi32(_mm_set1_epi32(scanline + extnum), _mm_set_epi32(3, 2, 1, 0))), _mm_set1_ps(0.5f));
+			__m128 startx = _mm_add_ps(v1x, _mm_mul_ps(_mm_sub_ps(fully, v1y), slope13));
+			__m128 upper = _mm_cmplt_ps(fully, v2y);
+			__m128 stopx = _mm_or_ps(_mm_and_ps(upper, _mm_add_ps(v1x, _mm_mul_ps(_mm_sub_ps(fully, v1y), slope12))),
+									 _mm_andnot_ps(upper, _mm_add_ps(v2x, _mm_mul_ps(_mm_sub_ps(fully, v2y), slope23))));
+			__m128i istartx = round_coordinate_sse2(startx);
+			__m128i istopx = round_coordinate_sse2(stopx);
+			__m128i swap = _mm_cmpgt_epi32(istartx, istopx);
+			__m128i lower = select_sse2(swap, istopx, istartx);
+			__m128i valid;
+
+			/* force start < stop, include the right edge and clip */
+			istopx = _mm_add_epi32(select_sse2(swap, istartx, istopx), rightedge);
+			istartx = select_sse2(_mm_cmpgt_epi32(minx, lower), minx, lower);
+			istopx = select_sse2(_mm_cmpgt_epi32(istopx, maxx), maxx, istopx);
+
+			/* empty extents become 0,0 */
+			valid = _mm_cmpgt_epi32(istopx, istartx);
+			istartx = _mm_and_si128(istartx, valid);
+			istopx = _mm_and_si128(istopx, valid);
+			total = _mm_add_epi32(total, _mm_sub_epi32(istopx, istartx));
+
+			/* interleave the starts and stops into four tri_extents */
+			_mm_storeu_si128((__m128i *)&extent[extnum], _mm_unpacklo_epi16(_mm_packs_epi32(istartx, istartx), _mm_packs_epi32(istopx, istopx)));
+		}
+
+		/* sum the pixel counts across lanes */
+		total = _mm_add_epi32(total, _mm_shuffle_epi32(total, _MM_SHUFFLE(1, 0, 3, 2)));
+		total = _mm_add_epi32(total, _mm_shuffle_epi32(total, _MM_SHUFFLE(2, 3, 0, 1)));
+		pixels += _mm_cvtsi128_si32(total);
+	}
+#endif
+
+	/* iterate over remaining extents */
+	for ( ; extnum < count; extnum++)
+	{
+		float fully = (float)(scanline + extnum) + 0.5f;
+		float startx = v1->x + (fully - v1->y) * dxdy_v1v3;
+		float stopx;
+		INT32 istartx, istopx;
+
+		/* compute the ending X based on which part of the triangle we're in */
+		if (fully < v2->y)
+			stopx = v1->x + (fully - v1->y) * dxdy_v1v2;
+		else
+			stopx = v2->x + (fully - v2->y) * dxdy_v2v3;
+
+		/* clamp to full pixels */
+		istartx = round_coordinate(startx);
+		istopx = round_coordinate(stopx);
+
+		/* force start < stop */
+		if (istartx > istopx)
+		{
+			INT32 temp = istartx;
+			istartx = istopx;
+			istopx = temp;
+		}
+
+		/* include the right edge if requested */
+		if (poly->flags & POLYFLAG_INCLUDE_RIGHT_EDGE)
+			istopx++;
+
+		/* apply left/right clipping */
+		if (istartx < cliprect.min_x)
+			istartx = cliprect.min_x;
+		if (istopx > cliprect.max_x)
+			istopx = cliprect.max_x + 1;
+
+		/* set the extent and update the total pixel count */
+		if (istartx >= istopx)
+			istartx = istopx = 0;
+		extent[extnum].startx = istartx;
+		extent[extnum].stopx = istopx;
+		pixels += istopx - istartx;
+	}
+	return pixels;
+}
+
+
 
 /***************************************************************************
     INITIALIZATION/TEARDOWN
@@ -340,7 +525,9 @@ poly_manager *poly_alloc(running_machine &machine, int max_polys, size_t extra_d
 	poly->unit_size = (flags & POLYFLAG_ALLOW_QUADS) ? sizeof(quad_work_unit) : sizeof(tri_work_unit);
 	poly->unit_count = MIN(poly->polygon_count * UNITS_PER_POLY, 65535);
 	poly->unit_next = 0;
+	poly->unit_queued = 0;
 	poly->unit = (work_unit **)allocate_array(machine, &poly->unit_size, poly->unit_count);
+	memset(poly->unit_bucket, 0xff, sizeof(poly->unit_bucket));
 
 	/* create the work queue */
 	if (!(flags & POLYFLAG_NO_WORK_QUEUE))
@@ -376,6 +563,8 @@ void poly_free(poly_manager *poly)
 	printf("Units:      %5d used, %5d allocated, %5d waits, %4d bytes each, %7d total\n", poly->unit_max, poly->unit_count, poly->unit_waits, poly->unit_size, poly->unit_count * poly->unit_size);
 	printf("Polygons:   %5d used, %5d allocated, %5d waits, %4d bytes each, %7d total\n", poly->polygon_max, poly->polygon_count, poly->polygon_waits, poly->polygon_size, poly->polygon_count * poly->polygon_size);
 	printf("Extra data: %5d used, %5d allocated, %5d waits, %4d bytes each, %7d total\n", poly->extra_max, poly->extra_count, poly->extra_waits, poly->extra_size, poly->extra_count * poly->extra_size);
+	printf("Setup:      %12.0f ticks, %10.1f per polygon\n", (double)poly->setup_ticks, (double)poly->setup_ticks / (double)MAX(poly->triangles + poly->quads, 1));
+	printf("Waits:      %12.0f ticks, %10.1f per wait, %5d waits\n", (double)poly->wait_ticks, (double)poly->wait_ticks / (double)MAX(poly->waits, 1), poly->waits);
 }
 #endif
 
@@ -400,9 +589,12 @@ void poly_wait(poly_manager *poly, const char *debug_reason)
 	osd_ticks_t time;
 
 	/* remember the start time if we're logging */
-	if (LOG_WAITS)
+	if (LOG_WAITS || KEEP_STATISTICS)
 		time = get_profile_ticks();
 
+	/* anything still held back for batching needs to go now */
+	queue_units(poly, TRUE);
+
 	/* wait for all pending work items to complete */
 	if (poly->queue != NULL)
 		osd_work_queue_wait(poly->queue, osd_ticks_per_second() * 100);
@@ -416,15 +608,19 @@ void poly_wait(poly_manager *poly, const char *debug_reason)
 	}
 
 	/* log any long waits */
-	if (LOG_WAITS)
+	if (LOG_WAITS || KEEP_STATISTICS)
 	{
 		time = get_profile_ticks() - time;
-		if (time > LOG_WAIT_THRESHOLD)
+#if KEEP_STATISTICS
+		poly->waits++;
+		poly->wait_ticks += time;
+#endif
+		if (LOG_WAITS && time > LOG_WAIT_THRESHOLD)
 			logerror("Poly:Waited %d cycles for %s\n", (int)time, debug_reason);
 	}
 
 	/* reset the state */
-	poly->polygon_next = poly->unit_next = 0;
+	poly->polygon_next = poly->unit_next = poly->unit_queued = 0;
 	memset(poly->unit_bucket, 0xff, sizeof(poly->unit_bucket));
 
 	/* we need to preserve the last extra data that was supplied */
@@ -477,7 +673,9 @@ UINT32 poly_render_triangle(poly_manager *poly, void *dest, const rectangle &cli
 	INT32 v1yclip, v3yclip;
 	INT32 v1y, v3y, v1x;
 	INT32 pixels = 0;
-	UINT32 startunit;
+#if KEEP_STATISTICS
+	osd_ticks_t starttime = get_profile_ticks();
+#endif
 
 	/* first sort by Y */
 	if (v2->y < v1->y)
@@ -533,67 +731,18 @@ UINT32 poly_render_triangle(poly_manager *poly, void *dest, const rectangle &cli
 	dxdy_v2v3 = (v3->y == v2->y) ? 0.0f : (v3->x - v2->x) / (v3->y - v2->y);
 
 	/* compute the X extents for each scanline */
-	startunit = poly->unit_next;
 	for (curscan = v1yclip; curscan < v3yclip; curscan += scaninc)
 	{
-		UINT32 bucketnum = ((UINT32)curscan / SCANLINES_PER_BUCKET) % TOTAL_BUCKETS;
-		UINT32 unit_index = poly->unit_next++;
-		tri_work_unit *unit = &poly->unit[unit_index]->tri;
-		int extnum;
+		tri_extent *extent;
+		int count;
 
 		/* determine how much to advance to hit the next bucket */
 		scaninc = SCANLINES_PER_BUCKET - (UINT32)curscan % SCANLINES_PER_BUCKET;
+		count = MIN(v3yclip - curscan, scaninc);
 
-		/* fill in the work unit basics */
-		unit->shared.polygon = polygon;
-		unit->shared.count_next = MIN(v3yclip - curscan, scaninc);
-		unit->shared.scanline = curscan;
-		unit->shared.previtem = poly->unit_bucket[bucketnum];
-		poly->unit_bucket[bucketnum] = unit_index;
-
-		/* iterate over extents */
-		for (extnum = 0; extnum < unit->shared.count_next; extnum++)
-		{
-			float fully = (float)(curscan + extnum) + 0.5f;
-			float startx = v1->x + (fully - v1->y) * dxdy_v1v3;
-			float stopx;
-			INT32 istartx, istopx;
-
-			/* compute the ending X based on which part of the triangle we're in */
-			if (fully < v2->y)
-				stopx = v1->x + (fully - v1->y) * dxdy_v1v2;
-			else
-				stopx = v2->x + (fully - v2->y) * dxdy_v2v3;
-
-			/* clamp to full pixels */
-			istartx = round_coordinate(startx);
-			istopx = round_coordinate(stopx);
-
-			/* force start < stop */
-			if (istartx > istopx)
-			{
-				INT32 temp = istartx;
-				istartx = istopx;
-				istopx = temp;
-			}
-
-			/* include the right edge if requested */
-			if (poly->flags & POLYFLAG_INCLUDE_RIGHT_EDGE)
-				istopx++;
-
-			/* apply left/right clipping */
-			if (istartx < cliprect.min_x)
-				istartx = cliprect.min_x;
-			if (istopx > cliprect.max_x)
-				istopx = cliprect.max_x + 1;
-
-			/* set the extent and update the total pixel count */
-			if (istartx >= istopx)
-				istartx = istopx = 0;
-			unit->extent[extnum].startx = istartx;
-			unit->extent[extnum].stopx = istopx;
-			pixels += istopx - istartx;
-		}
+		/* compute the extents straight into a unit for the whole bucket */
+		extent = allocate_unit(poly, polygon, curscan, count)->tri.extent;
+		pixels += compute_tri_extents(poly, cliprect, v1, v2, dxdy_v1v2, dxdy_v1v3, dxdy_v2v3, curscan, count, extent);
 	}
 #if KEEP_STATISTICS
 	poly->unit_max = MAX(poly->unit_max, poly->unit_next);
@@ -635,9 +784,11 @@ UINT32 poly_render_triangle(poly_manager *poly, void *dest, const rectangle &cli
 		}
 	}
 
-	/* enqueue the work items */
-	if (poly->queue != NULL)
-		osd_work_item_queue_multiple(poly->queue, poly_item_callback, poly->unit_next - startunit, poly->unit[startunit], poly->unit_size, WORK_ITEM_FLAG_AUTO_RELEASE);
+	/* enqueue the work items once there are enough for a batch */
+	queue_units(poly, FALSE);
+#if KEEP_STATISTICS
+	poly->setup_ticks += get_profile_ticks() - starttime;
+#endif
 
 	/* return the total number of pixels in the triangle */
 	poly->triangles++;
@@ -674,7 +825,9 @@ UINT32 poly_render_triangle_custom(poly_manager *poly, void *dest, const rectang
 	polygon_info *polygon;
 	INT32 v1yclip, v3yclip;
 	INT32 pixels = 0;
-	UINT32 startunit;
+#if KEEP_STATISTICS
+	osd_ticks_t starttime = get_profile_ticks();
+#endif
 
 	/* clip coordinates */
 	v1yclip = MAX(startscanline, cliprect.min_y);
@@ -694,26 +847,20 @@ UINT32 poly_render_triangle_custom(poly_manager *poly, void *dest, const rectang
 	polygon->numverts = 3;
 
 	/* compute the X extents for each scanline */
-	startunit = poly->unit_next;
 	for (curscan = v1yclip; curscan < v3yclip; curscan += scaninc)
 	{
-		UINT32 bucketnum = ((UINT32)curscan / SCANLINES_PER_BUCKET) % TOTAL_BUCKETS;
-		UINT32 unit_index = poly->unit_next++;
-		tri_work_unit *unit = &poly->unit[unit_index]->tri;
-		int extnum;
+		tri_extent *unitextent;
+		int extnum, count;
 
 		/* determine how much to advance to hit the next bucket */
 		scaninc = SCANLINES_PER_BUCKET - (UINT32)curscan % SCANLINES_PER_BUCKET;
+		count = MIN(v3yclip - curscan, scaninc);
 
-		/* fill in the work unit basics */
-		unit->shared.polygon = polygon;
-		unit->shared.count_next = MIN(v3yclip - curscan, scaninc);
-		unit->shared.scanline = curscan;
-		unit->shared.previtem = poly->unit_bucket[bucketnum];
-		poly->unit_bucket[bucketnum] = unit_index;
+		/* the extents go straight into a unit for the whole bucket */
+		unitextent = allocate_unit(poly, polygon, curscan, count)->tri.extent;
 
 		/* iterate over extents */
-		for (extnum = 0; extnum < unit->shared.count_next; extnum++)
+		for (extnum = 0; extnum < count; extnum++)
 		{
 			const poly_extent *extent = &extents[(curscan + extnum) - startscanline];
 			INT32 istartx = extent->startx, istopx = extent->stopx;
@@ -733,8 +880,8 @@ UINT32 poly_render_triangle_custom(poly_manager *poly, void *dest, const rectang
 				istopx = cliprect.max_x + 1;
 
 			/* set the extent and update the total pixel count */
-			unit->extent[extnum].startx = istartx;
-			unit->extent[extnum].stopx = istopx;
+			unitextent[extnum].startx = istartx;
+			unitextent[extnum].stopx = istopx;
 			if (istartx < istopx)
 				pixels += istopx - istartx;
 		}
@@ -743,9 +890,11 @@ UINT32 poly_render_triangle_custom(poly_manager *poly, void *dest, const rectang
 	poly->unit_max = MAX(poly->unit_max, poly->unit_next);
 #endif
 
-	/* enqueue the work items */
-	if (poly->queue != NULL)
-		osd_work_item_queue_multiple(poly->queue, poly_item_callback, poly->unit_next - startunit, poly->unit[startunit], poly->unit_size, WORK_ITEM_FLAG_AUTO_RELEASE);
+	/* enqueue the work items once there are enough for a batch */
+	queue_units(poly, FALSE);
+#if KEEP_STATISTICS
+	poly->setup_ticks += get_profile_ticks() - starttime;
+#endif
 
 	/* return the total number of pixels in the object */
 	poly->triangles++;
@@ -776,7 +925,9 @@ UINT32 poly_render_quad(poly_manager *poly, void *dest, const rectangle &cliprec
 	INT32 curscan, scaninc;
 	polygon_info *polygon;
 	INT32 pixels = 0;
-	UINT32 startunit;
+#if KEEP_STATISTICS
+	osd_ticks_t starttime = get_profile_ticks();
+#endif
 
 	assert(poly->flags & POLYFLAG_ALLOW_QUADS);
 
@@ -885,26 +1036,20 @@ UINT32 poly_render_quad(poly_manager *poly, void *dest, const rectangle &cliprec
 	}
 
 	/* compute the X extents for each scanline */
-	startunit = poly->unit_next;
 	for (curscan = minyclip; curscan < maxyclip; curscan += scaninc)
 	{
-		UINT32 bucketnum = ((UINT32)curscan / SCANLINES_PER_BUCKET) % TOTAL_BUCKETS;
-		UINT32 unit_index = poly->unit_next++;
-		quad_work_unit *unit = &poly->unit[unit_index]->quad;
-		int extnum;
+		poly_extent *unitextent;
+		int extnum, count;
 
 		/* determine how much to advance to hit the next bucket */
 		scaninc = SCANLINES_PER_BUCKET - (UINT32)curscan % SCANLINES_PER_BUCKET;
+		count = MIN(maxyclip - curscan, scaninc);
 
-		/* fill in the work unit basics */
-		unit->shared.polygon = polygon;
-		unit->shared.count_next = MIN(maxyclip - curscan, scaninc);
-		unit->shared.scanline = curscan;
-		unit->shared.previtem = poly->unit_bucket[bucketnum];
-		poly->unit_bucket[bucketnum] = unit_index;
+		/* the extents go straight into a unit for the whole bucket */
+		unitextent = allocate_unit(poly, polygon, curscan, count)->quad.extent;
 
 		/* iterate over extents */
-		for (extnum = 0; extnum < unit->shared.count_next; extnum++)
+		for (extnum = 0; extnum < count; extnum++)
 		{
 			float fully = (float)(curscan + extnum) + 0.5f;
 			float startx, stopx;
@@ -937,8 +1082,8 @@ UINT32 poly_render_quad(poly_manager *poly, void *dest, const rectangle &cliprec
 					float rparam = redge->v1->p[paramnum] + rdy * redge->dpdy[paramnum];
 					float dpdx = (rparam - lparam) * oox;
 
-					unit->extent[extnum].param[paramnum].start = lparam;// - ((float)istartx + 0.5f) * dpdx;
-					unit->extent[extnum].param[paramnum].dpdx = dpdx;
+					unitextent[extnum].param[paramnum].start = lparam;// - ((float)istartx + 0.5f) * dpdx;
+					unitextent[extnum].param[paramnum].dpdx = dpdx;
 				}
 			}
 
@@ -950,7 +1095,7 @@ UINT32 poly_render_quad(poly_manager *poly, void *dest, const rectangle &cliprec
 			if (istartx < cliprect.min_x)
 			{
 				for (paramnum = 0; paramnum < paramcount; paramnum++)
-					unit->extent[extnum].param[paramnum].start += (cliprect.min_x - istartx) * unit->extent[extnum].param[paramnum].dpdx;
+					unitextent[extnum].param[paramnum].start += (cliprect.min_x - istartx) * unitextent[extnum].param[paramnum].dpdx;
 				istartx = cliprect.min_x;
 			}
 			if (istopx > cliprect.max_x)
@@ -959,8 +1104,8 @@ UINT32 poly_render_quad(poly_manager *poly, void *dest, const rectangle &cliprec
 			/* set the extent and update the total pixel count */
 			if (istartx >= istopx)
 				istartx = istopx = 0;
-			unit->extent[extnum].startx = istartx;
-			unit->extent[extnum].stopx = istopx;
+			unitextent[extnum].startx = istartx;
+			unitextent[extnum].stopx = istopx;
 			pixels += istopx - istartx;
 		}
 	}
@@ -968,9 +1113,11 @@ UINT32 poly_render_quad(poly_manager *poly, void *dest, const rectangle &cliprec
 	poly->unit_max = MAX(poly->unit_max, poly->unit_next);
 #endif
 
-	/* enqueue the work items */
-	if (poly->queue != NULL)
-		osd_work_item_queue_multiple(poly->queue, poly_item_callback, poly->unit_next - startunit, poly->unit[startunit], poly->unit_size, WORK_ITEM_FLAG_AUTO_RELEASE);
+	/* enqueue the work items once there are enough for a batch */
+	queue_units(poly, FALSE);
+#if KEEP_STATISTICS
+	poly->setup_ticks += get_profile_ticks() - starttime;
+#endif
 
 	/* return the total number of pixels in the triangle */
 	poly->quads++;
@@ -1017,7 +1164,9 @@ UINT32 poly_render_polygon(poly_manager *poly, void *dest, const rectangle &clip
 	INT32 curscan, scaninc;
 	polygon_info *polygon;
 	INT32 pixels = 0;
-	UINT32 startunit;
+#if KEEP_STATISTICS
+	osd_ticks_t starttime = get_profile_ticks();
+#endif
 	int vertnum;
 
 	assert(poly->flags & POLYFLAG_ALLOW_QUADS);
@@ -1117,26 +1266,20 @@ UINT32 poly_render_polygon(poly_manager *poly, void *dest, const rectangle &clip
 	}
 
 	/* compute the X extents for each scanline */
-	startunit = poly->unit_next;
 	for (curscan = minyclip; curscan < maxyclip; curscan += scaninc)
 	{
-		UINT32 bucketnum = ((UINT32)curscan / SCANLINES_PER_BUCKET) % TOTAL_BUCKETS;
-		UINT32 unit_index = poly->unit_next++;
-		quad_work_unit *unit = &poly->unit[unit_index]->quad;
-		int extnum;
+		poly_extent *unitextent;
+		int extnum, count;
 
 		/* determine how much to advance to hit the next bucket */
 		scaninc = SCANLINES_PER_BUCKET - (UINT32)curscan % SCANLINES_PER_BUCKET;
+		count = MIN(maxyclip - curscan, scaninc);
 
-		/* fill in the work unit basics */
-		unit->shared.polygon = polygon;
-		unit->shared.count_next = MIN(maxyclip - curscan, scaninc);
-		unit->shared.scanline = curscan;
-		unit->shared.previtem = poly->unit_bucket[bucketnum];
-		poly->unit_bucket[bucketnum] = unit_index;
+		/* the extents go straight into a unit for the whole bucket */
+		unitextent = allocate_unit(poly, polygon, curscan, count)->quad.extent;
 
 		/* iterate over extents */
-		for (extnum = 0; extnum < unit->shared.count_next; extnum++)
+		for (extnum = 0; extnum < count; extnum++)
 		{
 			float fully = (float)(curscan + extnum) + 0.5f;
 			float startx, stopx;
@@ -1169,8 +1312,8 @@ UINT32 poly_render_polygon(poly_manager *poly, void *dest, const rectangle &clip
 					float rparam = redge->v1->p[paramnum] + rdy * redge->dpdy[paramnum];
 					float dpdx = (rparam - lparam) * oox;
 
-					unit->extent[extnum].param[paramnum].start = lparam;// - ((float)istartx + 0.5f) * dpdx;
-					unit->extent[extnum].param[paramnum].dpdx = dpdx;
+					unitextent[extnum].param[paramnum].start = lparam;// - ((float)istartx + 0.5f) * dpdx;
+					unitextent[extnum].param[paramnum].dpdx = dpdx;
 				}
 			}
 
@@ -1182,7 +1325,7 @@ UINT32 poly_render_polygon(poly_manager *poly, void *dest, const rectangle &clip
 			if (istartx < cliprect.min_x)
 			{
 				for (paramnum = 0; paramnum < paramcount; paramnum++)
-					unit->extent[extnum].param[paramnum].start += (cliprect.min_x - istartx) * unit->extent[extnum].param[paramnum].dpdx;
+					unitextent[extnum].param[paramnum].start += (cliprect.min_x - istartx) * unitextent[extnum].param[paramnum].dpdx;
 				istartx = cliprect.min_x;
 			}
 			if (istopx > cliprect.max_x)
@@ -1191,8 +1334,8 @@ UINT32 poly_render_polygon(poly_manager *poly, void *dest, const rectangle &clip
 			/* set the extent and update the total pixel count */
 			if (istartx >= istopx)
 				istartx = istopx = 0;
-			unit->extent[extnum].startx = istartx;
-			unit->extent[extnum].stopx = istopx;
+			unitextent[extnum].startx = istartx;
+			unitextent[extnum].stopx = istopx;
 			pixels += istopx - istartx;
 		}
 	}
@@ -1200,9 +1343,11 @@ UINT32 poly_render_polygon(poly_manager *poly, void *dest, const rectangle &clip
 	poly->unit_max = MAX(poly->unit_max, poly->unit_next);
 #endif
 
-	/* enqueue the work items */
-	if (poly->queue != NULL)
-		osd_work_item_queue_multiple(poly->queue, poly_item_callback, poly->unit_next - startunit, poly->unit[startunit], poly->unit_size, WORK_ITEM_FLAG_AUTO_RELEASE);
+	/* enqueue the work items once there are enough for a batch */
+	queue_units(poly, FALSE);
+#if KEEP_STATISTICS
+	poly->setup_ticks += get_profile_ticks() - starttime;
+#endif
 
 	/* return the total number of pixels in the triangle */
 	poly->quads++;
@@ -66,6 +66,10 @@ static const UINT32 METADATA_HEADER_SIZE = 16;			// metadata header size
 static const UINT8 V34_MAP_ENTRY_FLAG_TYPE_MASK	= 0x0f;		// what type of hunk
 static const UINT8 V34_MAP_ENTRY_FLAG_NO_CRC = 0x10;		// no CRC is present
 
+static const UINT32 CACHE_EMPTY = ~0;					// empty slot or list end in the hunk cache
+static const UINT32 READAHEAD_TRIGGER = 2;				// sequential hunk reads before reading ahead
+static const UINT32 READAHEAD_MAX_HUNKS = 16;			// most hunks to read ahead at once
+
 
 
 // V3-V4 entry types
@@ -122,6 +126,20 @@ struct chd_file::metadata_entry
 };
 
 
+// ======================> cache_lock
+
+// holds the cache lock for its lifetime, including when errors are thrown
+class chd_file::cache_lock
+{
+public:
+	cache_lock(chd_file &chd) : m_lock(chd.m_cachelock) { osd_lock_acquire(m_lock); }
+	~cache_lock() { osd_lock_release(m_lock); }
+
+private:
+	osd_lock *				m_lock;			// the lock we hold
+};
+
+
 // ======================> metadata_hash
 
 struct chd_file::metadata_hash
@@ -201,7 +219,8 @@ inline void chd_file::file_read(UINT64 offset, void *dest, UINT32 length)
 	if (m_file == NULL)
 		throw CHDERR_NOT_OPEN;
 
-	// seek and read
+	// seek and read, keeping out any read-ahead
+	cache_lock lock(*this);
 	core_fseek(m_file, offset, SEEK_SET);
 	UINT32 count = core_fread(m_file, dest, length);
 	if (count != length)
@@ -220,7 +239,8 @@ inline void chd_file::file_write(UINT64 offset, const void *source, UINT32 lengt
 	if (m_file == NULL)
 		throw CHDERR_NOT_OPEN;
 
-	// seek and write
+	// seek and write, keeping out any read-ahead
+	cache_lock lock(*this);
 	core_fseek(m_file, offset, SEEK_SET);
 	UINT32 count = core_fwrite(m_file, source, length);
 	if (count != length)
@@ -240,7 +260,8 @@ inline UINT64 chd_file::file_append(const void *source, UINT32 length, UINT32 al
 	if (m_file == NULL)
 		throw CHDERR_NOT_OPEN;
 
-	// seek to the end and align if necessary
+	// seek to the end and align if necessary, keeping out any read-ahead
+	cache_lock lock(*this);
 	core_fseek(m_file, 0, SEEK_END);
 	if (alignment != 0)
 	{
@@ -297,7 +318,10 @@ inline UINT8 chd_file::bits_for_value(UINT64 value)
 
 chd_file::chd_file()
 	: m_file(NULL),
-      m_owns_file(false)
+      m_owns_file(false),
+	  m_cachelock(osd_lock_alloc()),
+	  m_readaheadqueue(NULL),
+	  m_readaheaditem(NULL)
 {
 	// reset state
 	memset(m_decompressor, 0, sizeof(m_decompressor));
@@ -313,6 +337,7 @@ chd_file::~chd_file()
 {
 	// close any open files
 	close();
+	osd_lock_free(m_cachelock);
 }
 
 
@@ -657,10 +682,10 @@ chd_error chd_file::open(const char *filename, bool writeable, chd_file *parent)
 	if (m_file != NULL)
 		return CHDERR_ALREADY_OPEN;
 
-	// open the file
-	UINT32 openflags = writeable ? (OPEN_FLAG_READ | OPEN_FLAG_WRITE) : OPEN_FLAG_READ;
+	// open the file; read-only files are mapped where possible, so that their
+	// pages are shared with anyone else reading the same file
 	core_file *file = NULL;
-	file_error filerr = core_fopen(filename, openflags, &file);
+	file_error filerr = writeable ? core_fopen(filename, OPEN_FLAG_READ | OPEN_FLAG_WRITE, &file) : core_fopen_mapped(filename, OPEN_FLAG_READ, &file);
 	if (filerr != FILERR_NONE)
 		return CHDERR_FILE_NOT_FOUND;
 
@@ -703,6 +728,9 @@ chd_error chd_file::open(core_file &file, bool writeable, chd_file *parent)
 
 void chd_file::close()
 {
+	// stop reading ahead before anything goes away
+	readahead_stop();
+
 	// reset file characteristics
 	if (m_owns_file && m_file != NULL)
 		core_fclose(m_file);
@@ -745,7 +773,20 @@ void chd_file::close()
 
 	// reset caching
 	m_cache.reset();
-	m_cachehunk = ~0;
+	m_cacheslots = 1;
+	m_cachehunk.reset();
+	m_cacheprev.reset();
+	m_cachenext.reset();
+	m_cachechain.reset();
+	m_cachebucket.reset();
+	m_cachemru = m_cachelru = CACHE_EMPTY;
+	m_cachehits = m_cachemisses = 0;
+
+	// reset read-ahead
+	m_lasthunk = CACHE_EMPTY;
+	m_sequential = 0;
+	m_readaheadfirst = m_readaheadlast = 0;
+	m_readaheadhunks = 0;
 }
 
 
@@ -754,6 +795,24 @@ void chd_file::close()
 //-------------------------------------------------
 
 chd_error chd_file::read_hunk(UINT32 hunknum, void *buffer)
+{
+	// with a multi-hunk cache, whole hunks go through it too; hunks decompressed
+	// into codec-configured buffers (NULL) never do, and neither do hunks stored
+	// uncompressed in a mapped file, which are copied out and checked directly
+	if (buffer != NULL && m_cacheslots > 1 && mapped_hunk(hunknum) == NULL)
+		return read_cached(hunknum, 0, buffer, m_hunkbytes);
+
+	cache_lock lock(*this);
+	return decompress_hunk(hunknum, buffer);
+}
+
+
+//-------------------------------------------------
+//  decompress_hunk - read and decompress a single
+//  hunk from the CHD file, bypassing the cache
+//-------------------------------------------------
+
+chd_error chd_file::decompress_hunk(UINT32 hunknum, void *buffer)
 {
 	// wrap this for clean reporting
 	try
@@ -805,7 +864,7 @@ chd_error chd_file::read_hunk(UINT32 hunknum, void *buffer)
 						return CHDERR_NONE;
 
 					case V34_MAP_ENTRY_TYPE_SELF_HUNK:
-						return read_hunk(blockoffs, dest);
+						return decompress_hunk(blockoffs, dest);
 
 					case V34_MAP_ENTRY_TYPE_PARENT_HUNK:
 						if (m_parent_missing)
@@ -858,7 +917,7 @@ chd_error chd_file::read_hunk(UINT32 hunknum, void *buffer)
 						return CHDERR_NONE;
 
 					case COMPRESSION_SELF:
-						return read_hunk(blockoffs, dest);
+						return decompress_hunk(blockoffs, dest);
 
 					case COMPRESSION_PARENT:
 						if (m_parent_missing)
@@ -889,6 +948,8 @@ chd_error chd_file::write_hunk(UINT32 hunknum, const void *buffer)
 	// wrap this for clean reporting
 	try
 	{
+		cache_lock lock(*this);
+
 		// punt if no file
 		if (m_file == NULL)
 			throw CHDERR_NOT_OPEN;
@@ -932,15 +993,16 @@ chd_error chd_file::write_hunk(UINT32 hunknum, const void *buffer)
 			// write the map entry back
 			be_write(rawmap, rawentry, 4);
 			file_write(m_mapoffset + hunknum * 4, rawmap, 4);
-
-			// update the cached hunk if we just wrote it
-			if (hunknum == m_cachehunk && buffer != m_cache)
-				memcpy(m_cache, buffer, m_hunkbytes);
 		}
 
 		// otherwise, just overwrite
 		else
 			file_write(UINT64(rawentry) * UINT64(m_hunkbytes), buffer, m_hunkbytes);
+
+		// update the cached hunk if we just wrote it
+		UINT32 slot = cache_find(hunknum);
+		if (slot != CACHE_EMPTY && buffer != &m_cache[slot * m_hunkbytes])
+			memcpy(&m_cache[slot * m_hunkbytes], buffer, m_hunkbytes);
 		return CHDERR_NONE;
 	}
 
@@ -991,23 +1053,12 @@ chd_error chd_file::read_bytes(UINT64 offset, void *buffer, UINT32 bytes)
 		UINT32 startoffs = (curhunk == first_hunk) ? (offset % m_hunkbytes) : 0;
 		UINT32 endoffs = (curhunk == last_hunk) ? ((offset + bytes - 1) % m_hunkbytes) : (m_hunkbytes - 1);
 
-		// if it's a full block, just read directly from disk unless it's the cached hunk
-		chd_error err = CHDERR_NONE;
-		if (startoffs == 0 && endoffs == m_hunkbytes - 1 && curhunk != m_cachehunk)
+		// if it's a full block, read the whole hunk; otherwise, read from the cache
+		chd_error err;
+		if (startoffs == 0 && endoffs == m_hunkbytes - 1)
 			err = read_hunk(curhunk, dest);
-
-		// otherwise, read from the cache
 		else
-		{
-			if (curhunk != m_cachehunk)
-			{
-				err = read_hunk(curhunk, m_cache);
-				if (err != CHDERR_NONE)
-					return err;
-				m_cachehunk = curhunk;
-			}
-			memcpy(dest, &m_cache[startoffs], endoffs + 1 - startoffs);
-		}
+			err = read_cached(curhunk, startoffs, dest, endoffs + 1 - startoffs);
 
 		// handle errors and advance
 		if (err != CHDERR_NONE)
@@ -1035,23 +1086,21 @@ chd_error chd_file::write_bytes(UINT64 offset, const void *buffer, UINT32 bytes)
 		UINT32 startoffs = (curhunk == first_hunk) ? (offset % m_hunkbytes) : 0;
 		UINT32 endoffs = (curhunk == last_hunk) ? ((offset + bytes - 1) % m_hunkbytes) : (m_hunkbytes - 1);
 
-		// if it's a full block, just write directly to disk unless it's the cached hunk
-		chd_error err = CHDERR_NONE;
-		if (startoffs == 0 && endoffs == m_hunkbytes - 1 && curhunk != m_cachehunk)
+		// if it's a full block, just write directly to disk, which updates any cached copy
+		chd_error err;
+		if (startoffs == 0 && endoffs == m_hunkbytes - 1)
 			err = write_hunk(curhunk, source);
 
-		// otherwise, write from the cache
+		// otherwise, modify the cached copy and write that
 		else
 		{
-			if (curhunk != m_cachehunk)
-			{
-				err = read_hunk(curhunk, m_cache);
-				if (err != CHDERR_NONE)
-					return err;
-				m_cachehunk = curhunk;
-			}
-			memcpy(&m_cache[startoffs], source, endoffs + 1 - startoffs);
-			err = write_hunk(curhunk, m_cache);
+			cache_lock lock(*this);
+			UINT8 *hunk;
+			err = cache_fetch(curhunk, hunk);
+			if (err != CHDERR_NONE)
+				return err;
+			memcpy(&hunk[startoffs], source, endoffs + 1 - startoffs);
+			err = write_hunk(curhunk, hunk);
 		}
 
 		// handle errors and advance
@@ -1374,6 +1423,38 @@ chd_error chd_file::codec_configure(chd_codec_type codec, int param, void *confi
 }
 
 
+//-------------------------------------------------
+//  configure_cache - size the cache of
+//  decompressed hunks, and optionally read ahead
+//  into it on a worker thread when reads are
+//  sequential
+//-------------------------------------------------
+
+void chd_file::configure_cache(UINT32 cachebytes, bool readahead)
+{
+	// nothing to do until we're open
+	if (m_file == NULL || m_hunkbytes == 0)
+		return;
+
+	// stop any read-ahead, then rebuild the cache at its new size
+	readahead_stop();
+	{
+		cache_lock lock(*this);
+		m_cacheslots = MAX(cachebytes / m_hunkbytes, 1);
+		cache_reset();
+	}
+
+	// A/V codecs decompress into buffers configured by the caller, so can't be read ahead
+	for (int codecnum = 0; codecnum < ARRAY_LENGTH(m_compression); codecnum++)
+		if (m_compression[codecnum] == CHD_CODEC_AVHUFF)
+			readahead = false;
+
+	// reading ahead needs room to keep what it reads until it's used
+	if (readahead && m_cacheslots >= 4 * READAHEAD_TRIGGER)
+		m_readaheadqueue = osd_work_queue_alloc(WORK_QUEUE_FLAG_IO);
+}
+
+
 //-------------------------------------------------
 //  error_string - return an error string for
 //  the given CHD error
@@ -2104,9 +2185,9 @@ void chd_file::create_open_common()
 	else
 		file_read(m_mapoffset, m_rawmap, m_rawmap.count());
 
-	// allocate the temporary compressed buffer and a buffer for caching
+	// allocate the temporary compressed buffer and a single-hunk cache
 	m_compressed.resize(m_hunkbytes);
-	m_cache.resize(m_hunkbytes);
+	cache_reset();
 }
 
 
@@ -2320,6 +2401,310 @@ int CLIB_DECL chd_file::metadata_hash_compare(const void *elem1, const void *ele
 }
 
 
+//-------------------------------------------------
+//  read_cached - read part of a hunk through the
+//  cache, and read ahead if reads are sequential
+//-------------------------------------------------
+
+chd_error chd_file::read_cached(UINT32 hunknum, UINT32 offset, void *dest, UINT32 bytes)
+{
+	// hunks stored uncompressed in a mapped file are copied straight out of the
+	// mapping instead of taking up a cache slot; partial reads like this skip
+	// the hunk CRC, which whole-hunk reads still check
+	const UINT8 *mapped = mapped_hunk(hunknum);
+	if (mapped != NULL)
+	{
+		memcpy(dest, &mapped[offset], bytes);
+		return CHDERR_NONE;
+	}
+
+	chd_error err;
+	{
+		cache_lock lock(*this);
+		UINT8 *hunk;
+		err = cache_fetch(hunknum, hunk);
+		if (err == CHDERR_NONE)
+			memcpy(dest, &hunk[offset], bytes);
+	}
+	readahead_check(hunknum);
+	return err;
+}
+
+
+//-------------------------------------------------
+//  mapped_hunk - return a pointer to a hunk
+//  stored uncompressed in a mapped file, or NULL
+//-------------------------------------------------
+
+const UINT8 *chd_file::mapped_hunk(UINT32 hunknum)
+{
+	// only mapped files, and only hunks that exist
+	const UINT8 *base = (m_file != NULL) ? reinterpret_cast<const UINT8 *>(core_fmapped(m_file)) : NULL;
+	if (base == NULL || hunknum >= m_hunkcount)
+		return NULL;
+
+	// find where the hunk lives, if it is stored verbatim in this file
+	UINT64 blockoffs;
+	UINT8 *rawmap;
+	switch (m_version)
+	{
+		case 3:
+		case 4:
+			rawmap = m_rawmap + 16 * hunknum;
+			if ((rawmap[15] & V34_MAP_ENTRY_FLAG_TYPE_MASK) != V34_MAP_ENTRY_TYPE_UNCOMPRESSED)
+				return NULL;
+			blockoffs = be_read(&rawmap[0], 8);
+			break;
+
+		case 5:
+			rawmap = m_rawmap + m_mapentrybytes * hunknum;
+			if (!compressed())
+				blockoffs = UINT64(be_read(rawmap, 4)) * UINT64(m_hunkbytes);
+			else if (rawmap[0] == COMPRESSION_NONE)
+				blockoffs = be_read(&rawmap[4], 6);
+			else
+				return NULL;
+
+			// an offset of 0 means the hunk comes from the parent or is all zeros
+			if (blockoffs == 0)
+				return NULL;
+			break;
+
+		default:
+			return NULL;
+	}
+
+	// don't trust a map entry that points past the end of the file
+	if (blockoffs + m_hunkbytes > core_fsize(m_file))
+		return NULL;
+	return base + blockoffs;
+}
+
+
+//-------------------------------------------------
+//  cache_reset - empty the cache and size it to
+//  hold m_cacheslots hunks
+//-------------------------------------------------
+
+void chd_file::cache_reset()
+{
+	// allocate the hunks and the slot lists
+	m_cache.resize(m_cacheslots * m_hunkbytes);
+	m_cachehunk.resize(m_cacheslots);
+	m_cacheprev.resize(m_cacheslots);
+	m_cachenext.resize(m_cacheslots);
+	m_cachechain.resize(m_cacheslots);
+
+	// use a power of two buckets, at least one per slot
+	UINT32 buckets = 1;
+	while (buckets < m_cacheslots)
+		buckets <<= 1;
+	m_cachebucket.resize(buckets);
+	for (UINT32 bucket = 0; bucket < buckets; bucket++)
+		m_cachebucket[bucket] = CACHE_EMPTY;
+
+	// empty every slot, and chain them in order from most to least recently used
+	for (UINT32 slot = 0; slot < m_cacheslots; slot++)
+	{
+		m_cachehunk[slot] = CACHE_EMPTY;
+		m_cachechain[slot] = CACHE_EMPTY;
+		m_cacheprev[slot] = (slot == 0) ? CACHE_EMPTY : slot - 1;
+		m_cachenext[slot] = (slot == m_cacheslots - 1) ? CACHE_EMPTY : slot + 1;
+	}
+	m_cachemru = 0;
+	m_cachelru = m_cacheslots - 1;
+	m_cachehits = m_cachemisses = 0;
+}
+
+
+//-------------------------------------------------
+//  cache_find - return the cache slot holding a
+//  hunk, or CACHE_EMPTY
+//-------------------------------------------------
+
+UINT32 chd_file::cache_find(UINT32 hunknum)
+{
+	if (m_cachebucket.count() == 0)
+		return CACHE_EMPTY;
+
+	UINT32 slot;
+	for (slot = m_cachebucket[hunknum & (m_cachebucket.count() - 1)]; slot != CACHE_EMPTY; slot = m_cachechain[slot])
+		if (m_cachehunk[slot] == hunknum)
+			break;
+	return slot;
+}
+
+
+//-------------------------------------------------
+//  cache_touch - make a cache slot the most
+//  recently used
+//-------------------------------------------------
+
+void chd_file::cache_touch(UINT32 slot)
+{
+	if (slot == m_cachemru)
+		return;
+
+	// unlink from where we are; we can't be the head, so have a previous slot
+	m_cachenext[m_cacheprev[slot]] = m_cachenext[slot];
+	if (m_cachenext[slot] != CACHE_EMPTY)
+		m_cacheprev[m_cachenext[slot]] = m_cacheprev[slot];
+	else
+		m_cachelru = m_cacheprev[slot];
+
+	// relink at the head
+	m_cacheprev[slot] = CACHE_EMPTY;
+	m_cachenext[slot] = m_cachemru;
+	m_cacheprev[m_cachemru] = slot;
+	m_cachemru = slot;
+}
+
+
+//-------------------------------------------------
+//  cache_fetch - return a hunk from the cache,
+//  decompressing it into the cache on a miss;
+//  called with the cache lock held
+//-------------------------------------------------
+
+chd_error chd_file::cache_fetch(UINT32 hunknum, UINT8 *&hunk)
+{
+	UINT32 slot = cache_find(hunknum);
+	if (slot != CACHE_EMPTY)
+	{
+		m_cachehits++;
+		cache_touch(slot);
+		hunk = &m_cache[slot * m_hunkbytes];
+		return CHDERR_NONE;
+	}
+
+	m_cachemisses++;
+	return cache_fill(hunknum, hunk);
+}
+
+
+//-------------------------------------------------
+//  cache_fill - decompress a hunk into the least
+//  recently used cache slot; called with the
+//  cache lock held
+//-------------------------------------------------
+
+chd_error chd_file::cache_fill(UINT32 hunknum, UINT8 *&hunk)
+{
+	// evict whatever is in the least recently used slot
+	UINT32 slot = m_cachelru;
+	if (m_cachehunk[slot] != CACHE_EMPTY)
+	{
+		UINT32 *link = &m_cachebucket[m_cachehunk[slot] & (m_cachebucket.count() - 1)];
+		while (*link != slot)
+			link = &m_cachechain[*link];
+		*link = m_cachechain[slot];
+		m_cachehunk[slot] = CACHE_EMPTY;
+	}
+
+	// decompress into it; on failure, it stays empty
+	hunk = &m_cache[slot * m_hunkbytes];
+	chd_error err = decompress_hunk(hunknum, hunk);
+	if (err != CHDERR_NONE)
+		return err;
+
+	// hash it and make it the most recently used
+	UINT32 &bucket = m_cachebucket[hunknum & (m_cachebucket.count() - 1)];
+	m_cachehunk[slot] = hunknum;
+	m_cachechain[slot] = bucket;
+	bucket = slot;
+	cache_touch(slot);
+	return CHDERR_NONE;
+}
+
+
+//-------------------------------------------------
+//  readahead_check - note a hunk read, and start
+//  reading ahead of it if reads are sequential
+//-------------------------------------------------
+
+void chd_file::readahead_check(UINT32 hunknum)
+{
+	// count consecutive sequential reads; rereading the same hunk doesn't break a run
+	if (hunknum == m_lasthunk + 1)
+		m_sequential++;
+	else if (hunknum != m_lasthunk)
+		m_sequential = 0;
+	m_lasthunk = hunknum;
+
+	if (m_readaheadqueue == NULL || m_sequential < READAHEAD_TRIGGER)
+		return;
+
+	// let any read-ahead in flight finish first
+	if (m_readaheaditem != NULL)
+	{
+		if (!osd_work_item_wait(m_readaheaditem, 0))
+			return;
+		osd_work_item_release(m_readaheaditem);
+		m_readaheaditem = NULL;
+	}
+
+	// read ahead of this hunk, skipping what the last read-ahead already covered
+	UINT32 first = hunknum + 1;
+	if (first < m_readaheadlast && first >= m_readaheadfirst)
+		first = m_readaheadlast;
+	UINT32 last = MIN(hunknum + 1 + MIN(READAHEAD_MAX_HUNKS, m_cacheslots / 4), m_hunkcount);
+	if (first >= last)
+		return;
+
+	m_readaheadfirst = first;
+	m_readaheadlast = last;
+	m_readaheaditem = osd_work_item_queue(m_readaheadqueue, readahead_static, this, 0);
+}
+
+
+//-------------------------------------------------
+//  readahead_stop - wait for any read-ahead in
+//  flight and stop reading ahead
+//-------------------------------------------------
+
+void chd_file::readahead_stop()
+{
+	if (m_readaheaditem != NULL)
+	{
+		// the read-ahead uses this chd_file, so it must have finished before anything is torn down
+		while (!osd_work_item_wait(m_readaheaditem, 100 * osd_ticks_per_second()))
+			;
+		osd_work_item_release(m_readaheaditem);
+		m_readaheaditem = NULL;
+	}
+	if (m_readaheadqueue != NULL)
+	{
+		osd_work_queue_free(m_readaheadqueue);
+		m_readaheadqueue = NULL;
+	}
+}
+
+
+//-------------------------------------------------
+//  readahead - decompress the hunks of the
+//  read-ahead in flight into the cache; runs on
+//  the read-ahead queue
+//-------------------------------------------------
+
+void *chd_file::readahead_static(void *param, int threadid)
+{
+	reinterpret_cast<chd_file *>(param)->readahead();
+	return NULL;
+}
+
+void chd_file::readahead()
+{
+	for (UINT32 hunknum = m_readaheadfirst; hunknum < m_readaheadlast; hunknum++)
+	{
+		// take the lock per hunk so that reads can get in between
+		cache_lock lock(*this);
+		UINT8 *hunk;
+		if (mapped_hunk(hunknum) == NULL && cache_find(hunknum) == CACHE_EMPTY && cache_fill(hunknum, hunk) == CHDERR_NONE)
+			m_readaheadhunks++;
+	}
+}
+
+
 
 //**************************************************************************
 //  CHD COMPRESSOR
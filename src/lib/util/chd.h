@@ -391,12 +391,20 @@ public:
 	// codec interfaces
 	chd_error codec_configure(chd_codec_type codec, int param, void *config);
 
+	// cache management; configure after opening
+	void configure_cache(UINT32 cachebytes, bool readahead = false);
+	UINT32 cache_hunks() const { return m_cacheslots; }
+	UINT64 cache_hits() const { return m_cachehits; }
+	UINT64 cache_misses() const { return m_cachemisses; }
+	UINT64 readahead_hunks() const { return m_readaheadhunks; }
+
 	// static helpers
 	static const char *error_string(chd_error err);
 
 private:
 	struct metadata_entry;
 	struct metadata_hash;
+	class cache_lock;
 
 	// inline helpers
 	UINT64 be_read(const UINT8 *base, int numbytes);
@@ -422,6 +430,18 @@ private:
 	void hunk_write_compressed(UINT32 hunknum, INT8 compression, const UINT8 *compressed, UINT32 complength, crc16_t crc16);
 	void hunk_copy_from_self(UINT32 hunknum, UINT32 otherhunk);
 	void hunk_copy_from_parent(UINT32 hunknum, UINT64 parentunit);
+	chd_error decompress_hunk(UINT32 hunknum, void *buffer);
+	chd_error read_cached(UINT32 hunknum, UINT32 offset, void *dest, UINT32 bytes);
+	const UINT8 *mapped_hunk(UINT32 hunknum);
+	void cache_reset();
+	UINT32 cache_find(UINT32 hunknum);
+	void cache_touch(UINT32 slot);
+	chd_error cache_fetch(UINT32 hunknum, UINT8 *&hunk);
+	chd_error cache_fill(UINT32 hunknum, UINT8 *&hunk);
+	void readahead_check(UINT32 hunknum);
+	void readahead_stop();
+	static void *readahead_static(void *param, int threadid);
+	void readahead();
 	bool metadata_find(chd_metadata_tag metatag, INT32 metaindex, metadata_entry &metaentry, bool resume = false);
 	void metadata_set_previous_next(UINT64 prevoffset, UINT64 nextoffset);
 	void metadata_update_hash();
@@ -462,8 +482,27 @@ private:
 	dynamic_buffer			m_compressed;		// temporary buffer for compressed data
 
 	// caching
-	dynamic_buffer			m_cache;			// single-hunk cache for partial reads/writes
-	UINT32					m_cachehunk;		// which hunk is in the cache?
+	osd_lock *				m_cachelock;		// guards the cache, the file and the decompressors
+	dynamic_buffer			m_cache;			// cache of decompressed hunks, for partial reads/writes and reuse
+	UINT32					m_cacheslots;		// number of hunks the cache holds
+	dynamic_array<UINT32>	m_cachehunk;		// which hunk is in each slot, or ~0
+	dynamic_array<UINT32>	m_cacheprev;		// previous (more recently used) slot, or ~0
+	dynamic_array<UINT32>	m_cachenext;		// next (less recently used) slot, or ~0
+	dynamic_array<UINT32>	m_cachechain;		// next slot in the same hash bucket, or ~0
+	dynamic_array<UINT32>	m_cachebucket;		// first slot in each hash bucket, or ~0
+	UINT32					m_cachemru;			// most recently used slot
+	UINT32					m_cachelru;			// least recently used slot
+	UINT64					m_cachehits;		// hunk reads satisfied from the cache
+	UINT64					m_cachemisses;		// hunk reads that had to decompress
+
+	// read-ahead
+	osd_work_queue *		m_readaheadqueue;	// queue for reading ahead, or NULL if not reading ahead
+	osd_work_item *			m_readaheaditem;	// read-ahead in flight, or NULL
+	UINT32					m_lasthunk;			// most recent hunk read through the cache
+	UINT32					m_sequential;		// number of consecutive sequential hunk reads
+	UINT32					m_readaheadfirst;	// first hunk of the read-ahead in flight
+	UINT32					m_readaheadlast;	// hunk after the last of the read-ahead in flight
+	UINT64					m_readaheadhunks;	// hunks decompressed by reading ahead
 };
 
 
@@ -99,6 +99,7 @@ struct _core_file
 	zlib_data *		zdata;						/* compression data */
 	UINT32			openflags;					/* flags we were opened with */
 	UINT8			data_allocated;				/* was the data allocated by us? */
+	UINT8			data_mapped;				/* is the data a mapping of the file? */
 	UINT8 *			data;						/* file data, if RAM-based */
 	UINT64			offset;						/* current file offset */
 	UINT64			length;						/* total file length */
@@ -119,6 +120,7 @@ struct _core_file
 
 /* misc helpers */
 static UINT32 safe_buffer_copy(const void *source, UINT32 sourceoffs, UINT32 sourcelen, void *dest, UINT32 destoffs, UINT32 destlen);
+static int map_file(core_file *file);
 static file_error osd_or_zlib_read(core_file *file, void *buffer, UINT64 offset, UINT32 length, UINT32 *actual);
 static file_error osd_or_zlib_write(core_file *file, const void *buffer, UINT64 offset, UINT32 length, UINT32 *actual);
 
@@ -174,6 +176,33 @@ file_error core_fopen(const char *filename, UINT32 openflags, core_file **file)
 }
 
 
+/*-------------------------------------------------
+    core_fopen_mapped - open a file read-only,
+    mapping all of it into memory if the OSD
+    layer can, and return an error code
+-------------------------------------------------*/
+
+file_error core_fopen_mapped(const char *filename, UINT32 openflags, core_file **file)
+{
+	file_error filerr;
+
+	/* can only do this for read access */
+	if ((openflags & OPEN_FLAG_WRITE) != 0)
+		return FILERR_INVALID_ACCESS;
+	if ((openflags & OPEN_FLAG_CREATE) != 0)
+		return FILERR_INVALID_ACCESS;
+
+	/* open the file normally */
+	filerr = core_fopen(filename, openflags, file);
+	if (filerr != FILERR_NONE)
+		return filerr;
+
+	/* map it; if we can't, it just stays an ordinary file */
+	map_file(*file);
+	return FILERR_NONE;
+}
+
+
 /*-------------------------------------------------
     core_fopen_ram_internal - open a RAM-based buffer
     for file-like access, possibly copying the data,
@@ -244,6 +273,8 @@ void core_fclose(core_file *file)
 		core_fcompress(file, FCOMPRESS_NONE);
 	if (file->file != NULL)
 		osd_close(file->file);
+	if (file->data != NULL && file->data_mapped)
+		osd_unmap(file->data, file->length);
 	if (file->data != NULL && file->data_allocated)
 		free(file->data);
 	free(file);
@@ -472,9 +503,12 @@ UINT32 core_fread(core_file *file, void *buffer, UINT32 length)
 		}
 	}
 
-	/* handle RAM-based files */
-	else
-		bytes_read += safe_buffer_copy(file->data, (UINT32)file->offset, file->length, buffer, bytes_read, length);
+	/* handle RAM-based and mapped files, which may be larger than 4GB */
+	else if (file->offset < file->length)
+	{
+		bytes_read = (UINT32)MIN(file->length - file->offset, (UINT64)length);
+		memcpy(buffer, file->data + file->offset, bytes_read);
+	}
 
 	/* return the number of bytes read */
 	file->offset += bytes_read;
@@ -714,6 +748,17 @@ const void *core_fbuffer(core_file *file)
 }
 
 
+/*-------------------------------------------------
+    core_fmapped - return a pointer to the file
+    data if it is mapped, without loading it
+-------------------------------------------------*/
+
+const void *core_fmapped(core_file *file)
+{
+	return file->data_mapped ? file->data : NULL;
+}
+
+
 /*-------------------------------------------------
     core_fload - open a file with the specified
     filename, read it into memory, and return a
@@ -979,6 +1024,33 @@ static UINT32 safe_buffer_copy(const void *source, UINT32 sourceoffs, UINT32 sou
 }
 
 
+/*-------------------------------------------------
+    map_file - replace a plain read-only file
+    with a mapping of all of its data; returns
+    TRUE if the file is now mapped
+-------------------------------------------------*/
+
+static int map_file(core_file *file)
+{
+	const void *data;
+
+	/* only whole, uncompressed files that nobody can write to */
+	if (file->file == NULL || file->zdata != NULL || file->length == 0)
+		return FALSE;
+	if ((file->openflags & (OPEN_FLAG_WRITE | OPEN_FLAG_CREATE)) != 0)
+		return FALSE;
+	if (osd_map(file->file, 0, file->length, &data) != FILERR_NONE)
+		return FALSE;
+
+	/* the mapping outlives the file, which we no longer need */
+	file->data = (UINT8 *)data;
+	file->data_mapped = TRUE;
+	osd_close(file->file);
+	file->file = NULL;
+	return TRUE;
+}
+
+
 /*-------------------------------------------------
     osd_or_zlib_read - wrapper for osd_read that
     handles zlib-compressed data
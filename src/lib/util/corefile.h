@@ -80,6 +80,9 @@ typedef struct _core_file core_file;
 /* open a file with the specified filename */
 file_error core_fopen(const char *filename, UINT32 openflags, core_file **file);
 
+/* open a file read-only, mapping its data into memory where the OSD layer supports it */
+file_error core_fopen_mapped(const char *filename, UINT32 openflags, core_file **file);
+
 /* open a RAM-based "file" using the given data and length (read-only) */
 file_error core_fopen_ram(const void *data, size_t length, UINT32 openflags, core_file **file);
 
@@ -128,6 +131,9 @@ char *core_fgets(char *s, int n, core_file *file);
 /* this function may cause the full file data to be read */
 const void *core_fbuffer(core_file *file);
 
+/* get a pointer to the file data if the file is mapped, or NULL; this never loads anything */
+const void *core_fmapped(core_file *file);
+
 /* open a file with the specified filename, read it into memory, and return a pointer */
 file_error core_fload(const char *filename, void **data, UINT32 *length);
 file_error core_fload(const char *filename, dynamic_buffer &data);
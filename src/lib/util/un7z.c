@@ -197,6 +197,23 @@ void FileOutStream_CreateVTable(CFileOutStream *p)
 
 static _7z_file *_7z_cache[_7Z_CACHE_SIZE];
 
+/* guards the cache once _7z_file_cache_init has been called, so files may be
+   opened and closed from any thread */
+static osd_lock *_7z_cache_lock;
+
+
+INLINE void _7z_cache_acquire(void)
+{
+	if (_7z_cache_lock != NULL)
+		osd_lock_acquire(_7z_cache_lock);
+}
+
+INLINE void _7z_cache_release(void)
+{
+	if (_7z_cache_lock != NULL)
+		osd_lock_release(_7z_cache_lock);
+}
+
 /***************************************************************************
     FUNCTION PROTOTYPES
 ***************************************************************************/
@@ -320,6 +337,7 @@ _7z_error _7z_file_open(const char *filename, _7z_file **_7z)
 	*_7z = NULL;
 
 	/* see if we are in the cache, and reopen if so */
+	_7z_cache_acquire();
 	for (cachenum = 0; cachenum < ARRAY_LENGTH(_7z_cache); cachenum++)
 	{
 		_7z_file *cached = _7z_cache[cachenum];
@@ -329,9 +347,11 @@ _7z_error _7z_file_open(const char *filename, _7z_file **_7z)
 		{
 			*_7z = cached;
 			_7z_cache[cachenum] = NULL;
+			_7z_cache_release();
 			return _7ZERR_NONE;
 		}
 	}
+	_7z_cache_release();
 
 	/* allocate memory for the _7z_file structure */
 	new_7z = (_7z_file *)malloc(sizeof(*new_7z));
@@ -415,6 +435,7 @@ void _7z_file_close(_7z_file *_7z)
 	_7z->archiveStream.file._7z_osdfile = NULL;
 
 	/* find the first NULL entry in the cache */
+	_7z_cache_acquire();
 	for (cachenum = 0; cachenum < ARRAY_LENGTH(_7z_cache); cachenum++)
 		if (_7z_cache[cachenum] == NULL)
 			break;
@@ -427,6 +448,20 @@ void _7z_file_close(_7z_file *_7z)
 	if (cachenum != 0)
 		memmove(&_7z_cache[1], &_7z_cache[0], cachenum * sizeof(_7z_cache[0]));
 	_7z_cache[0] = _7z;
+	_7z_cache_release();
+}
+
+
+/*-------------------------------------------------
+    _7z_file_cache_init - prepare the cache to
+    be used from more than one thread; must be
+    called before any other threads use it
+-------------------------------------------------*/
+
+void _7z_file_cache_init(void)
+{
+	if (_7z_cache_lock == NULL)
+		_7z_cache_lock = osd_lock_alloc();
 }
 
 
@@ -440,12 +475,22 @@ void _7z_file_cache_clear(void)
 	int cachenum;
 
 	/* clear call cache entries */
+	_7z_cache_acquire();
 	for (cachenum = 0; cachenum < ARRAY_LENGTH(_7z_cache); cachenum++)
 		if (_7z_cache[cachenum] != NULL)
 		{
 			free__7z_file(_7z_cache[cachenum]);
 			_7z_cache[cachenum] = NULL;
 		}
+	_7z_cache_release();
+
+	/* no other threads may be using the cache now, so free its lock too;
+	   _7z_file_cache_init allocates it again */
+	if (_7z_cache_lock != NULL)
+	{
+		osd_lock_free(_7z_cache_lock);
+		_7z_cache_lock = NULL;
+	}
 }
 
 
@@ -158,6 +158,9 @@ _7z_error _7z_file_open(const char *filename, _7z_file **_7z);
 /* close a _7Z file (may actually be left open due to caching) */
 void _7z_file_close(_7z_file *_7z);
 
+/* prepare the cache for use from more than one thread */
+void _7z_file_cache_init(void);
+
 /* clear out all open _7Z files from the cache */
 void _7z_file_cache_clear(void);
 
@@ -38,6 +38,7 @@
 ***************************************************************************/
 
 #include "osdcore.h"
+#include "corestr.h"
 #include "unzip.h"
 
 #include <ctype.h>
@@ -50,8 +51,8 @@
     CONSTANTS
 ***************************************************************************/
 
-/* number of open files to cache */
-#define ZIP_CACHE_SIZE	8
+/* number of open files to cache; large sets are spread over a parent and several BIOS and device ZIPs */
+#define ZIP_CACHE_SIZE	32
 
 /* offsets in end of central directory structure */
 #define ZIPESIG			0x00
@@ -116,6 +117,11 @@ INLINE UINT32 read_dword(UINT8 *buf)
 	return (buf[3] << 24) | (buf[2] << 16) | (buf[1] << 8) | buf[0];
 }
 
+INLINE UINT32 crc_bucket(zip_file *zip, UINT32 crc)
+{
+	return (crc ^ (crc >> 16)) & zip->bucketmask;
+}
+
 
 
 /***************************************************************************
@@ -124,6 +130,23 @@ INLINE UINT32 read_dword(UINT8 *buf)
 
 static zip_file *zip_cache[ZIP_CACHE_SIZE];
 
+/* guards the cache once zip_file_cache_init has been called, so files may be
+   opened and closed from any thread */
+static osd_lock *zip_cache_lock;
+
+
+INLINE void zip_cache_acquire(void)
+{
+	if (zip_cache_lock != NULL)
+		osd_lock_acquire(zip_cache_lock);
+}
+
+INLINE void zip_cache_release(void)
+{
+	if (zip_cache_lock != NULL)
+		osd_lock_release(zip_cache_lock);
+}
+
 
 
 /***************************************************************************
@@ -135,6 +158,9 @@ static void free_zip_file(zip_file *zip);
 
 /* ZIP file parsing */
 static zip_error read_ecd(zip_file *zip);
+static zip_error build_index(zip_file *zip);
+static UINT32 hash_filename(const char *name, UINT32 length);
+static int filename_matches(const zip_file_header *header, const char *filename);
 static zip_error get_compressed_data_offset(zip_file *zip, UINT64 *offset);
 
 /* decompression interfaces */
@@ -164,6 +190,7 @@ zip_error zip_file_open(const char *filename, zip_file **zip)
 	*zip = NULL;
 
 	/* see if we are in the cache, and reopen if so */
+	zip_cache_acquire();
 	for (cachenum = 0; cachenum < ARRAY_LENGTH(zip_cache); cachenum++)
 	{
 		zip_file *cached = zip_cache[cachenum];
@@ -173,9 +200,11 @@ zip_error zip_file_open(const char *filename, zip_file **zip)
 		{
 			*zip = cached;
 			zip_cache[cachenum] = NULL;
+			zip_cache_release();
 			return ZIPERR_NONE;
 		}
 	}
+	zip_cache_release();
 
 	/* allocate memory for the zip_file structure */
 	newzip = (zip_file *)malloc(sizeof(*newzip));
@@ -219,6 +248,11 @@ zip_error zip_file_open(const char *filename, zip_file **zip)
 		goto error;
 	}
 
+	/* index the central directory, so lookups needn't walk it */
+	ziperr = build_index(newzip);
+	if (ziperr != ZIPERR_NONE)
+		goto error;
+
 	/* make a copy of the filename for caching purposes */
 	string = (char *)malloc(strlen(filename) + 1);
 	if (string == NULL)
@@ -252,6 +286,7 @@ void zip_file_close(zip_file *zip)
 	zip->file = NULL;
 
 	/* find the first NULL entry in the cache */
+	zip_cache_acquire();
 	for (cachenum = 0; cachenum < ARRAY_LENGTH(zip_cache); cachenum++)
 		if (zip_cache[cachenum] == NULL)
 			break;
@@ -264,6 +299,20 @@ void zip_file_close(zip_file *zip)
 	if (cachenum != 0)
 		memmove(&zip_cache[1], &zip_cache[0], cachenum * sizeof(zip_cache[0]));
 	zip_cache[0] = zip;
+	zip_cache_release();
+}
+
+
+/*-------------------------------------------------
+    zip_file_cache_init - prepare the cache to
+    be used from more than one thread; must be
+    called before any other threads use it
+-------------------------------------------------*/
+
+void zip_file_cache_init(void)
+{
+	if (zip_cache_lock == NULL)
+		zip_cache_lock = osd_lock_alloc();
 }
 
 
@@ -277,12 +326,22 @@ void zip_file_cache_clear(void)
 	int cachenum;
 
 	/* clear call cache entries */
+	zip_cache_acquire();
 	for (cachenum = 0; cachenum < ARRAY_LENGTH(zip_cache); cachenum++)
 		if (zip_cache[cachenum] != NULL)
 		{
 			free_zip_file(zip_cache[cachenum]);
 			zip_cache[cachenum] = NULL;
 		}
+	zip_cache_release();
+
+	/* no other threads may be using the cache now, so free its lock too;
+	   zip_file_cache_init allocates it again */
+	if (zip_cache_lock != NULL)
+	{
+		osd_lock_free(zip_cache_lock);
+		zip_cache_lock = NULL;
+	}
 }
 
 
@@ -361,6 +420,61 @@ const zip_file_header *zip_file_next_file(zip_file *zip)
 }
 
 
+/*-------------------------------------------------
+    zip_file_find - find the first file in the
+    ZIP, in directory order, whose name and/or
+    CRC match, and make it the current file
+-------------------------------------------------*/
+
+const zip_file_header *zip_file_find(zip_file *zip, const char *filename, UINT32 crc, int flags)
+{
+	const char *basename;
+	INT32 entrynum;
+	UINT32 hash = 0;
+
+	/* names are looked up by their final part; the rest is compared below */
+	if (flags & ZIP_FIND_NAME)
+	{
+		basename = strrchr(filename, '/');
+		basename = (basename != NULL) ? basename + 1 : filename;
+		hash = hash_filename(basename, strlen(basename));
+		entrynum = zip->namebuckets[hash & zip->bucketmask];
+	}
+	else if (flags & ZIP_FIND_CRC)
+		entrynum = zip->crcbuckets[crc_bucket(zip, crc)];
+	else
+		return NULL;
+
+	/* walk the bucket, whose entries are in directory order */
+	while (entrynum != -1)
+	{
+		const zip_index_entry *entry = &zip->index[entrynum];
+
+		if ((!(flags & ZIP_FIND_NAME) || entry->namehash == hash) && (!(flags & ZIP_FIND_CRC) || entry->crc == crc))
+		{
+			const zip_file_header *header;
+
+			/* make this the current file */
+			zip->cd_pos = entry->cd_pos;
+			header = zip_file_next_file(zip);
+			if (header == NULL)
+				return NULL;
+
+			/* confirm the name, or that it isn't a directory */
+			if (flags & ZIP_FIND_NAME)
+			{
+				if (filename_matches(header, filename))
+					return header;
+			}
+			else if (header->filename_length == 0 || header->filename[header->filename_length - 1] != '/')
+				return header;
+		}
+		entrynum = (flags & ZIP_FIND_NAME) ? entry->namenext : entry->crcnext;
+	}
+	return NULL;
+}
+
+
 /*-------------------------------------------------
     zip_file_decompress - decompress a file
     from a ZIP into the target buffer
@@ -425,6 +539,12 @@ static void free_zip_file(zip_file *zip)
 			free(zip->ecd.raw);
 		if (zip->cd != NULL)
 			free(zip->cd);
+		if (zip->index != NULL)
+			free(zip->index);
+		if (zip->namebuckets != NULL)
+			free(zip->namebuckets);
+		if (zip->crcbuckets != NULL)
+			free(zip->crcbuckets);
 		free(zip);
 	}
 }
@@ -508,6 +628,104 @@ static zip_error read_ecd(zip_file *zip)
 }
 
 
+/*-------------------------------------------------
+    build_index - index the central directory by
+    name and by CRC
+-------------------------------------------------*/
+
+static zip_error build_index(zip_file *zip)
+{
+	UINT32 cd_pos, buckets, entrynum;
+
+	/* allocate for as many entries as the ECD claims; we stop early if the directory is short */
+	zip->index = (zip_index_entry *)malloc(MAX(zip->ecd.cd_total_entries, 1) * sizeof(zip->index[0]));
+	if (zip->index == NULL)
+		return ZIPERR_OUT_OF_MEMORY;
+
+	/* walk the directory, recording each entry */
+	zip->entries = 0;
+	for (cd_pos = 0; zip->entries < zip->ecd.cd_total_entries && cd_pos + ZIPCFN <= zip->ecd.cd_size; )
+	{
+		UINT8 *raw = zip->cd + cd_pos;
+		UINT32 namelength = read_word(raw + ZIPCFNL);
+		UINT32 rawlength = ZIPCFN + namelength + read_word(raw + ZIPCXTL) + read_word(raw + ZIPCCML);
+		const char *name = (const char *)raw + ZIPCFN;
+		UINT32 base;
+		zip_index_entry *entry;
+
+		if (cd_pos + rawlength > zip->ecd.cd_size)
+			break;
+
+		/* hash the final part of the filename */
+		for (base = namelength; base > 0 && name[base - 1] != '/'; base--) ;
+
+		entry = &zip->index[zip->entries++];
+		entry->cd_pos = cd_pos;
+		entry->crc = read_dword(raw + ZIPCCRC);
+		entry->namehash = hash_filename(name + base, namelength - base);
+		cd_pos += rawlength;
+	}
+
+	/* size the hash tables at a power of two at least the number of entries */
+	for (buckets = 16; buckets < zip->entries; buckets <<= 1) ;
+	zip->bucketmask = buckets - 1;
+	zip->namebuckets = (INT32 *)malloc(buckets * sizeof(zip->namebuckets[0]));
+	zip->crcbuckets = (INT32 *)malloc(buckets * sizeof(zip->crcbuckets[0]));
+	if (zip->namebuckets == NULL || zip->crcbuckets == NULL)
+		return ZIPERR_OUT_OF_MEMORY;
+	memset(zip->namebuckets, 0xff, buckets * sizeof(zip->namebuckets[0]));
+	memset(zip->crcbuckets, 0xff, buckets * sizeof(zip->crcbuckets[0]));
+
+	/* chain the entries in backwards, so each bucket ends up in directory order */
+	for (entrynum = zip->entries; entrynum > 0; entrynum--)
+	{
+		zip_index_entry *entry = &zip->index[entrynum - 1];
+		INT32 *namehead = &zip->namebuckets[entry->namehash & zip->bucketmask];
+		INT32 *crchead = &zip->crcbuckets[crc_bucket(zip, entry->crc)];
+
+		entry->namenext = *namehead;
+		*namehead = entrynum - 1;
+		entry->crcnext = *crchead;
+		*crchead = entrynum - 1;
+	}
+	return ZIPERR_NONE;
+}
+
+
+/*-------------------------------------------------
+    hash_filename - hash part of a filename,
+    ignoring case
+-------------------------------------------------*/
+
+static UINT32 hash_filename(const char *name, UINT32 length)
+{
+	UINT32 hash = 2166136261U;
+
+	/* FNV-1a */
+	while (length-- > 0)
+		hash = (hash ^ (UINT8)tolower((UINT8)*name++)) * 16777619U;
+	return hash;
+}
+
+
+/*-------------------------------------------------
+    filename_matches - compare the filename of
+    a header to an expected filename, ignoring
+    case and any leading directories
+-------------------------------------------------*/
+
+static int filename_matches(const zip_file_header *header, const char *filename)
+{
+	UINT32 length = strlen(filename);
+	const char *zipfile;
+
+	if (length > header->filename_length)
+		return FALSE;
+	zipfile = header->filename + header->filename_length - length;
+	return (core_stricmp(filename, zipfile) == 0 && (zipfile == header->filename || zipfile[-1] == '/'));
+}
+
+
 /*-------------------------------------------------
     get_compressed_data_offset - return the
     offset of the compressed data
@@ -51,6 +51,10 @@
 
 #define ZIP_DECOMPRESS_BUFSIZE	16384
 
+/* flags for zip_file_find */
+#define ZIP_FIND_NAME			0x01	/* filename must match, ignoring case and leading directories */
+#define ZIP_FIND_CRC			0x02	/* CRC must match; without ZIP_FIND_NAME, directories never match */
+
 /* Error types */
 enum _zip_error
 {
@@ -120,6 +124,18 @@ struct _zip_ecd
 };
 
 
+/* an entry in the index of a ZIP's central directory */
+typedef struct _zip_index_entry zip_index_entry;
+struct _zip_index_entry
+{
+	UINT32			cd_pos;					/* offset of the entry's header in the central directory */
+	UINT32			crc;					/* crc-32 */
+	UINT32			namehash;				/* hash of the final part of the filename, ignoring case */
+	INT32			namenext;				/* next entry in the same name bucket, or -1 */
+	INT32			crcnext;				/* next entry in the same CRC bucket, or -1 */
+};
+
+
 /* describes an open ZIP file */
 typedef struct _zip_file zip_file;
 struct _zip_file
@@ -134,6 +150,12 @@ struct _zip_file
 	UINT32			cd_pos;					/* position in central directory */
 	zip_file_header	header;					/* current file header */
 
+	UINT32			entries;				/* number of entries in the index */
+	zip_index_entry *index;					/* index of the central directory, in directory order */
+	UINT32			bucketmask;				/* number of hash buckets, minus one */
+	INT32 *			namebuckets;			/* first entry in each name hash bucket, or -1 */
+	INT32 *			crcbuckets;				/* first entry in each CRC hash bucket, or -1 */
+
 	UINT8			buffer[ZIP_DECOMPRESS_BUFSIZE];	/* buffer for decompression */
 };
 
@@ -152,6 +174,9 @@ zip_error zip_file_open(const char *filename, zip_file **zip);
 /* close a ZIP file (may actually be left open due to caching) */
 void zip_file_close(zip_file *zip);
 
+/* prepare the cache for use from more than one thread */
+void zip_file_cache_init(void);
+
 /* clear out all open ZIP files from the cache */
 void zip_file_cache_clear(void);
 
@@ -164,6 +189,9 @@ const zip_file_header *zip_file_first_file(zip_file *zip);
 /* find the next file in the ZIP */
 const zip_file_header *zip_file_next_file(zip_file *zip);
 
+/* find the first file in directory order matching a name and/or CRC, using the index */
+const zip_file_header *zip_file_find(zip_file *zip, const char *filename, UINT32 crc, int flags);
+
 /* decompress the most recently found file in the ZIP */
 zip_error zip_file_decompress(zip_file *zip, void *buffer, UINT32 length);
 
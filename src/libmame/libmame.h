@@ -28,6 +28,7 @@ extern "C" {
  * 1. Functions for querying the set of games supported by this version of
  *    LibMame, and many descriptive details about each game:
  *    - LibMame_Get_Version_String
+ *    - LibMame_Prepare_Game_Info
  *    - LibMame_Get_Game_Count
  *    - LibMame_Get_Game_Number
  *    - LibMame_Get_Game_Matches
@@ -59,12 +60,19 @@ extern "C" {
  *    - LibMame_Get_Game_Hdd
  *    - LibMame_Get_Game_SourceFileName
  *
- * 2. A function for running a MAME game (only one MAME game may be run
- *    concurrently within the same process due to limitations in the MAME
- *    engine).  MAME will emulate the game and will interact with the rest
- *    of the system (for displaying frames of the game, playing sound, and
- *    getting controller input) via callbacks.
+ * 2. A function for running a MAME game (each call runs one game on the
+ *    calling thread; only one game may be running at a time, see the note
+ *    at the end of this section).  MAME will emulate the game and will
+ *    interact with the rest of the system (for displaying frames of the
+ *    game, playing sound, and getting controller input) via callbacks.
+ *    Alternatively, a game can be started and then stepped one frame at a
+ *    time by the caller, with no throttling, which allows deterministic
+ *    frame-by-frame execution for things like run-ahead and lockstep
+ *    netplay.
  *    - LibMame_RunGame
+ *    - LibMame_StartGame
+ *    - LibMame_RunningGame_RunFrame
+ *    - LibMame_FinishGame
  *
  * 3. Functions for manipulating a running MAME game, including pausing,
  *    resetting, and manipulating configuration values of various kinds.
@@ -74,6 +82,22 @@ extern "C" {
  *    - LibMame_RunningGame_Schedule_Soft_Reset
  *    - LibMame_RunningGame_SaveState
  *    - LibMame_RunningGame_LoadState
+ *    - LibMame_RunningGame_GetStateSize
+ *    - LibMame_RunningGame_SaveStateToBuffer
+ *    - LibMame_RunningGame_LoadStateFromBuffer
+ *    - LibMame_RunningGame_GetStateBufferStatus
+ *    - LibMame_RunningGame_GetDeltaStateSize
+ *    - LibMame_RunningGame_SaveDeltaStateToBuffer
+ *    - LibMame_RunningGame_LoadDeltaStateFromBuffer
+ *    - LibMame_RunningGame_Rewind
+ *    - LibMame_RunningGame_SetFramebuffer
+ *    - LibMame_RunningGame_SetScreenBitmapCallback
+ *    - LibMame_RunningGame_SetAudioRing
+ *    - LibMame_RunningGame_GetStats
+ *    - LibMame_RunningGame_SetProfilerEnabled
+ *    - LibMame_RunningGame_SetWriteTracking
+ *    - LibMame_RunningGame_GetDirtyBitmap
+ *    - LibMame_RunningGame_ResetDirtyBitmap
  *    - LibMame_RunningGame_ChangeDipswitchValue
  *
  * 4. Miscellaneous functions necessary for supporting the other libmame
@@ -82,6 +106,14 @@ extern "C" {
  *    - LibMame_Deinitialize
  *    - LibMame_Get_Default_RunGameOptions
  *
+ * 5. Functions for managing audio rings, which let a host drain a running
+ *    game's audio from a thread of its own instead of receiving it in the
+ *    UpdateAudio callback:
+ *    - LibMame_AudioRing_Create
+ *    - LibMame_AudioRing_Destroy
+ *    - LibMame_AudioRing_Read
+ *    - LibMame_AudioRing_GetStats
+ *
  *
  * In general, applications using libmame will follow this pattern:
  *
@@ -133,13 +165,16 @@ extern "C" {
  * 9. When the application is completely finished calling any LibMame
  *    functions, before it exits, it must then call LibMame_Deinitialize.
  *
- * Please keep in mind that although the API is structured as if it were
- * possible to run multiple MAME games simultaneously from the same
- * application, there is a limit in the MAME engine that prevents more than
- * one game from running at a time.  This limit may someday be lifted, in
- * which case this API will already be ready to take advantage of that, but
- * until the limit is lifted, remember that LibMame_RunGame may only be called
- * from one thread at a time within a single application.
+ * All of the state that libmame keeps for a running game belongs to that
+ * game's LibMame_RunningGame handle, and all callbacks for a game are made
+ * on the thread which called LibMame_RunGame for it.  The MAME engine
+ * itself, though, still keeps the running machine, the profiler and other
+ * state in process-wide variables, so only one game may be running at a
+ * time: while a game started by LibMame_RunGame or LibMame_StartGame is
+ * running, any other attempt to run a game fails with
+ * LibMame_RunGameStatus_GameAlreadyRunning.  Running several games
+ * concurrently in one process is not supported; an application that needs
+ * to run more than one game at once must run each in its own process.
  */
 
 
@@ -148,6 +183,7 @@ extern "C" {
  *****************************************************************************/
 
 typedef struct LibMame_RunningGame LibMame_RunningGame;
+typedef struct LibMame_AudioRing LibMame_AudioRing;
 
 
 /*****************************************************************************
@@ -715,10 +751,80 @@ typedef enum
     LibMame_RunGameStatus_MissingFiles,
     LibMame_RunGameStatus_NoSuchGame,
     LibMame_RunGameStatus_InvalidConfig,
-    LibMame_RunGameStatus_GeneralError
+    LibMame_RunGameStatus_GeneralError,
+    LibMame_RunGameStatus_GameAlreadyRunning
 } LibMame_RunGameStatus;
 
 
+/**
+ * Status codes that can be returned by
+ * LibMame_RunningGame_GetStateBufferStatus()
+ **/
+typedef enum
+{
+    /**
+     * The most recent save to or load from a buffer completed successfully.
+     **/
+    LibMame_StateBufferStatus_Success,
+    /**
+     * The most recent save to or load from a buffer has not happened yet;
+     * the buffer must be left untouched until it has.
+     **/
+    LibMame_StateBufferStatus_Pending,
+    /**
+     * The game does not support saving state.
+     **/
+    LibMame_StateBufferStatus_NotSupported,
+    /**
+     * The buffer that was to be loaded does not hold a save state for this
+     * game, or was made by an incompatible version of libmame, or the base
+     * of a delta save or load is not an uncompressed save state of this
+     * running game.
+     **/
+    LibMame_StateBufferStatus_InvalidState,
+    /**
+     * The buffer that was to be saved to is too small to hold the state.
+     **/
+    LibMame_StateBufferStatus_BufferTooSmall,
+    /**
+     * The buffer that was to be loaded is truncated or corrupt.
+     **/
+    LibMame_StateBufferStatus_CorruptState,
+    /**
+     * No save to or load from a buffer has been requested yet.
+     **/
+    LibMame_StateBufferStatus_NotRequested,
+    /**
+     * The most recent save to or load from a buffer was abandoned before it
+     * happened, either because the game could not reach a point at which its
+     * state could be saved or loaded within a second of emulated time, or
+     * because a save or load of a file was requested in its place.  The
+     * buffer is no longer in use.
+     **/
+    LibMame_StateBufferStatus_Cancelled
+} LibMame_StateBufferStatus;
+
+
+/**
+ * Pixel formats of the framebuffers that LibMame_RunningGame_SetFramebuffer()
+ * can render frames into
+ **/
+typedef enum
+{
+    /**
+     * 32 bits per pixel, with red in bits 16-23, green in bits 8-15 and blue
+     * in bits 0-7.  Bits 24-31 are always written as zero and should be
+     * treated as opaque.
+     **/
+    LibMame_FramebufferFormat_ARGB32,
+    /**
+     * 16 bits per pixel, with red in bits 11-15, green in bits 5-10 and blue
+     * in bits 0-4.
+     **/
+    LibMame_FramebufferFormat_RGB565
+} LibMame_FramebufferFormat;
+
+
 /*****************************************************************************
  * Structured type definitions
  *****************************************************************************/
@@ -1411,6 +1517,21 @@ typedef struct LibMame_RunGameOptions
     /** skip displaying the information screen at startup **/
     int skip_gameinfo_screens;
 
+    /* options added since the original release, which are kept at the end
+       of the structure so that the offsets of the options above do not
+       change ------------------------------------------------------------ */
+
+    /** format of the audio the game produces: "int16" for clipped stereo
+        16 bit samples passed to the UpdateAudio callback, or "float" for
+        unclipped stereo, or "float_speakers" for unclipped samples with one
+        channel per speaker, both passed to the UpdateAudioFloat callback **/
+    char audio_format[16];
+    /** megabytes of memory to keep for rewind history (see
+        LibMame_RunningGame_Rewind); 0 disables rewinding **/
+    int rewind_size;
+    /** number of frames between rewind history captures **/
+    int rewind_interval;
+
 } LibMame_RunGameOptions;
 
 
@@ -1546,6 +1667,311 @@ typedef struct LibMame_RenderPrimitive
 } LibMame_RenderPrimitive;
 
 
+/**
+ * Pixel formats of the native screen bitmaps reported to a
+ * LibMame_ScreenBitmapCallback
+ **/
+typedef enum
+{
+    /**
+     * 16 bits per pixel, each an index into the palette of the
+     * LibMame_ScreenBitmap
+     **/
+    LibMame_ScreenBitmapFormat_Indexed16,
+    /**
+     * 32 bits per pixel, with red in bits 16-23, green in bits 8-15 and blue
+     * in bits 0-7
+     **/
+    LibMame_ScreenBitmapFormat_RGB32
+} LibMame_ScreenBitmapFormat;
+
+
+/**
+ * This describes a frame of one of the game's screens, exactly as the game
+ * drew it, before any scaling, artwork or layout is applied.  None of the
+ * memory it refers to may be modified, and all of it is only valid until
+ * the LibMame_ScreenBitmapCallback it was passed to returns.
+ **/
+typedef struct LibMame_ScreenBitmap
+{
+    /**
+     * Index of the screen, in the same order as the screens of the game's
+     * layout
+     **/
+    int screen;
+
+    /**
+     * The primary screen frame number that this frame completed
+     **/
+    uint64_t frame_number;
+
+    /**
+     * Format of the pixels
+     **/
+    LibMame_ScreenBitmapFormat format;
+
+    /**
+     * Pointer to the top left pixel of the bitmap
+     **/
+    const void *pixels;
+
+    /**
+     * Dimensions of the bitmap, in pixels.  Only the visible area holds
+     * meaningful pixels.
+     **/
+    int width, height;
+
+    /**
+     * Distance between the starts of consecutive rows, in pixels
+     **/
+    int pitch;
+
+    /**
+     * The visible area of the bitmap; all coordinates are inclusive
+     **/
+    struct {
+        int min_x, max_x, min_y, max_y;
+    } visible_area;
+
+    /**
+     * For LibMame_ScreenBitmapFormat_Indexed16 bitmaps, the colors that
+     * pixel values index, in the same format as
+     * LibMame_ScreenBitmapFormat_RGB32 pixels; NULL otherwise.  The palette
+     * may change from frame to frame independently of the dirty rows.
+     **/
+    const uint32_t *palette;
+
+    /**
+     * Number of entries in the palette
+     **/
+    int palette_size;
+
+    /**
+     * One flag per row of the bitmap, nonzero for each row of the visible
+     * area whose pixels differ from those of the previous frame reported for
+     * this screen.  Every visible row is flagged for the first frame, and
+     * after the screen is resized.
+     **/
+    const uint8_t *dirty_rows;
+} LibMame_ScreenBitmap;
+
+
+/**
+ * Statistics about a LibMame_AudioRing, as returned by
+ * LibMame_AudioRing_GetStats()
+ **/
+typedef struct LibMame_AudioRingStats
+{
+    /**
+     * Number of frames the ring can hold
+     **/
+    uint32_t capacity_frames;
+
+    /**
+     * Number of frames currently waiting to be read
+     **/
+    uint32_t available_frames;
+
+    /**
+     * Total number of frames the game produced that were dropped because
+     * the ring was full
+     **/
+    uint32_t overrun_frames;
+
+    /**
+     * Total number of frames asked for by LibMame_AudioRing_Read() that
+     * were not available, and were returned as silence
+     **/
+    uint32_t underrun_frames;
+} LibMame_AudioRingStats;
+
+
+/**
+ * The most devices and profiler buckets that LibMame_RunningGameStats
+ * reports; any beyond these are left out
+ **/
+enum
+{
+    LibMame_StatsDeviceMax = 32,
+    LibMame_StatsProfilerBucketMax = 32
+};
+
+
+/**
+ * Statistics about one executing device (usually a CPU) of a running game
+ **/
+typedef struct LibMame_DeviceStats
+{
+    /**
+     * The tag of the device, which identifies it within the game
+     **/
+    const char *tag;
+
+    /**
+     * The name of the type of the device, for example "Z80"
+     **/
+    const char *name;
+
+    /**
+     * The clock of the device, in Hz
+     **/
+    uint32_t clock_hz;
+
+    /**
+     * Nonzero if the device is currently suspended, for example because it
+     * is halted or waiting for an interrupt
+     **/
+    int suspended;
+
+    /**
+     * Total number of cycles the device has executed
+     **/
+    uint64_t cycles_executed;
+
+    /**
+     * Number of cycles the device executed during the most recent frame
+     **/
+    uint64_t cycles_last_frame;
+
+    /**
+     * Profiler ticks spent executing the device since the profiler was
+     * enabled; always zero if it isn't
+     **/
+    uint64_t profiler_ticks;
+} LibMame_DeviceStats;
+
+
+/**
+ * The time that the profiler has attributed to one of the non-device
+ * activities it tracks, such as video updates or timer callbacks
+ **/
+typedef struct LibMame_ProfilerBucket
+{
+    /**
+     * The name of the activity
+     **/
+    const char *name;
+
+    /**
+     * Profiler ticks spent in the activity since the profiler was enabled
+     **/
+    uint64_t ticks;
+} LibMame_ProfilerBucket;
+
+
+/**
+ * Statistics about a running game, as returned by
+ * LibMame_RunningGame_GetStats().  Values described as "last frame" cover
+ * the most recently completed frame; the rest cover the whole run since the
+ * game last started or was hard reset.
+ *
+ * Profiler ticks are in whatever units the profiler's clock uses (on x86,
+ * the processor's time stamp counter), so they are only meaningful relative
+ * to one another.  They are only collected by builds of libmame made with
+ * the profiler compiled in, and only while it is enabled, either by
+ * LibMame_RunningGame_SetProfilerEnabled() or by MAME's own profiler
+ * display.  The profiler is shared by all games running in the process.
+ **/
+typedef struct LibMame_RunningGameStats
+{
+    /**
+     * Number of frames the game has completed
+     **/
+    uint64_t frame_number;
+
+    /**
+     * Emulated time, in nanoseconds
+     **/
+    uint64_t emulated_time_ns;
+
+    /**
+     * Emulated time covered by the last frame, in nanoseconds
+     **/
+    uint64_t frame_emulated_time_ns;
+
+    /**
+     * Wall clock time that the last frame took, in nanoseconds, including
+     * the time spent in callbacks
+     **/
+    uint64_t frame_wall_time_ns;
+
+    /**
+     * Speed of the game as a percentage of full speed, as MAME last
+     * measured it
+     **/
+    double speed_percent;
+
+    /**
+     * Number of scheduler timeslices run, in total and during the last frame
+     **/
+    uint64_t timeslices;
+    uint64_t timeslices_last_frame;
+
+    /**
+     * Number of timers fired, in total and during the last frame, and the
+     * rate at which they fired during the last frame per emulated second
+     **/
+    uint64_t timers_fired;
+    uint64_t timers_fired_last_frame;
+    double timers_fired_per_second;
+
+    /**
+     * The executing devices of the game
+     **/
+    int device_count;
+    LibMame_DeviceStats devices[LibMame_StatsDeviceMax];
+
+    /**
+     * Nonzero if the profiler is collecting, and the profiler's buckets for
+     * activities other than device execution, which is reported in the
+     * devices above
+     **/
+    int profiler_enabled;
+    int profiler_bucket_count;
+    LibMame_ProfilerBucket profiler_buckets[LibMame_StatsProfilerBucketMax];
+} LibMame_RunningGameStats;
+
+
+/**
+ * The pages of one of a device's address spaces that have been written
+ * since write tracking was enabled or last reset, as returned by
+ * LibMame_RunningGame_GetDirtyBitmap().  Page n covers the addresses (in
+ * bytes) from n << granularity_bits up to (n + 1) << granularity_bits, and is
+ * dirty if bit (n % 32) of bits[n / 32] is set.
+ **/
+typedef struct LibMame_DirtyBitmap
+{
+    /**
+     * The bitmap; it remains owned by the running game, and is valid until
+     * write tracking is disabled or changed, or the game exits
+     **/
+    const uint32_t *bits;
+
+    /**
+     * Number of pages, and so of valid bits, in the bitmap
+     **/
+    uint32_t page_count;
+
+    /**
+     * Each page is 1 << granularity_bits bytes
+     **/
+    int granularity_bits;
+} LibMame_DirtyBitmap;
+
+
+/**
+ * The type of the function that LibMame_RunningGame_SetScreenBitmapCallback()
+ * installs.  It is called each time one of the game's screens completes a
+ * frame that changed, before that frame is passed to UpdateVideo.
+ *
+ * @param bitmap describes the frame
+ * @param callback_data the data pointer that was passed to LibMame_RunGame
+ *        or LibMame_StartGame
+ **/
+typedef void (*LibMame_ScreenBitmapCallback)(const LibMame_ScreenBitmap *bitmap,
+                                             void *callback_data);
+
+
 /**
  * This is the set of callbacks that the caller of LibMame_RunGame passes in.
  * These provide the interface to allow MAME to supply the frames of video and
@@ -1579,10 +2005,10 @@ typedef struct LibMame_RunGameCallbacks
      * @param pct_complete is the percentage completion of this phase
      * @param running_game is an opaque pointer which identifies the game
      *        being run, and that is used in subsequent calls to
-     *        LibMame_RunningGame_XXX functions.  The application should, if
-     *        it intends to run more than one game simultaneously (currently
-     *        not possible due to internal MAME limitations), save this value
-     *        in a way that associates it with the callback data.
+     *        LibMame_RunningGame_XXX functions.  Every call to
+     *        LibMame_RunGame has its own running_game, which remains valid
+     *        until that call returns.  Only one game may run at a time, so
+     *        there is only ever one valid running_game.
      * @param callback_data the data pointer that was passed to
      *        LibMame_RunGame
      **/
@@ -1612,10 +2038,13 @@ typedef struct LibMame_RunGameCallbacks
     /**
      * Called by libmame to periodically (and regularly, at the original
      * frame rate of the game) provide the primitives that need to be rendered
-     * to display the current frame of the game.
+     * to display the current frame of the game.  If a framebuffer has been
+     * set by LibMame_RunningGame_SetFramebuffer(), the frame has instead
+     * already been rendered into it when this is called, and
+     * render_primitive_list is NULL.
      *
      * @param render_primitive_list is a list of primitives that are to be
-     *        rendered
+     *        rendered, or NULL if the frame was rendered into a framebuffer
      * @param callback_data the data pointer that was passed to
      *        LibMame_RunGame
      **/
@@ -1679,7 +2108,30 @@ typedef struct LibMame_RunGameCallbacks
      *        LibMame_RunGame
      **/
     void (*Paused)(void *callback_data);
-     
+
+    /**
+     * Called by libmame instead of UpdateAudio when the audio_format option
+     * is "float" or "float_speakers", to provide the audio for the current
+     * frame as floating point samples which have not been clipped.  This
+     * callback is only made for such games, so it may be left NULL
+     * otherwise.  Floating point audio is never pushed into an audio ring.
+     *
+     * @param sample_rate is the sample rate of the game which is delivering
+     *        this audio
+     * @param channels is the number of channels; 2 (left, then right) for
+     *        "float", or the number of speakers of the game for
+     *        "float_speakers", in the order the game declares them
+     * @param samples_this_frame is the number of samples per channel
+     *        contained in the buffer
+     * @param buffer holds the samples, interleaved across the channels;
+     *        full scale is -1.0 to 1.0, but louder samples are passed
+     *        through rather than clipped
+     * @param callback_data the data pointer that was passed to
+     *        LibMame_RunGame
+     **/
+    void (*UpdateAudioFloat)(int sample_rate, int channels,
+                             int samples_this_frame, const float *buffer,
+                             void *callback_data);
 } LibMame_RunGameCallbacks;
 
 
@@ -1728,6 +2180,24 @@ const char *LibMame_Get_Version_String();
  * Functions for querying the supported games and their properties
  ----------------------------------------------------------------------------*/
 
+/**
+ * Builds the descriptive details of every game up front.  Without this call,
+ * the details of each game are built the first time that they are asked for,
+ * one game at a time, which makes walking the whole catalog slow.  This call
+ * builds them all at once on [thread_count] threads, and returns when they
+ * are all built.  After that, none of the LibMame_Get_Game_XXX functions
+ * ever need to wait on each other, no matter how many threads call them.
+ *
+ * This function is optional, and may be called at any time after
+ * LibMame_Initialize; calls made by other threads while it runs wait for it
+ * to complete.
+ *
+ * @param thread_count is the number of threads to build the details on, or
+ *        0 or less to use one thread per online CPU
+ **/
+void LibMame_Prepare_Game_Info(int thread_count);
+
+
 /**
  * Returns the total number of games supported by this instance of libmame.
  *
@@ -2053,9 +2523,11 @@ void LibMame_Get_Default_RunGameOptions(LibMame_RunGameOptions *options);
  ----------------------------------------------------------------------------*/
 
 /**
- * Runs a game.  Currently, this is a non-thread-safe call, so only one thread
- * can be running this at a time.  The game will be run until it is instructed
- * to exit by a call to LibMame_RunningGame_ScheduleExit().
+ * Runs a game on the calling thread.  The game will be run until it is
+ * instructed to exit by a call to LibMame_RunningGame_ScheduleExit().  All
+ * callbacks for the game are made from the calling thread.  Only one game
+ * may be running at a time; if another game is already running, this
+ * returns LibMame_RunGameStatus_GameAlreadyRunning immediately.
  *
  * @param gamenum is the game number of the game to run
  * @param benchmarking is a special parameter which should only be set to
@@ -2075,6 +2547,76 @@ LibMame_RunGameStatus LibMame_RunGame(int gamenum, int benchmarking,
                                       void *callback_data);
 
 
+/**
+ * Starts a game that is then run one frame at a time by calls to
+ * LibMame_RunningGame_RunFrame(), rather than freely as LibMame_RunGame()
+ * does.  A stepped game is never throttled and never skips frames; it runs
+ * exactly as fast as it is stepped.  This function returns once the game
+ * has started up and reached the end of its first frame.
+ *
+ * The game runs on a thread of its own, but that thread only ever runs
+ * while the caller is inside this function, LibMame_RunningGame_RunFrame()
+ * or LibMame_FinishGame(), so emulation is deterministic for a given
+ * sequence of controls states.  All callbacks are made from that thread
+ * while the caller waits.  The PollAllControlsState callback is never made
+ * for a stepped game.
+ *
+ * Between calls to LibMame_RunningGame_RunFrame(), the game is stopped at
+ * the end of a frame, and any of the LibMame_RunningGame_XXX functions may
+ * be called from the thread that is stepping the game, in addition to from
+ * within the MakeRunningGameCalls callback.
+ *
+ * @param gamenum is the game number of the game to run
+ * @param options if non-NULL, provides the options that the game will be run
+ *        with.  If NULL, defaults will be used.  The throttle, frame skip
+ *        and auto frame skip options are ignored.
+ * @param cbs is the set of callback functions that will be made as the game
+ *        runs to display output
+ * @param callback_data is a pointer that is passed into all of the callback
+ *        functions
+ * @param running_game returns the game that was started, which must
+ *        eventually be passed to LibMame_FinishGame(), or NULL if the game
+ *        failed to start
+ * @return LibMame_RunGameStatus_Success if the game was started,
+ *         LibMame_RunGameStatus_GameAlreadyRunning if another game is still
+ *         running, or the status that resulted from attempting to run the
+ *         game otherwise
+ **/
+LibMame_RunGameStatus LibMame_StartGame(int gamenum,
+                                        const LibMame_RunGameOptions *options,
+                                        const LibMame_RunGameCallbacks *cbs,
+                                        void *callback_data,
+                                        LibMame_RunningGame **running_game);
+
+
+/**
+ * Runs exactly one frame of a game started by LibMame_StartGame(), and
+ * returns once the frame has been emulated and its video and audio have been
+ * delivered to the callbacks.
+ *
+ * @param game is the game to run, as returned by LibMame_StartGame()
+ * @param controls_state is the state of all controls to use for this frame,
+ *        set up as the PollAllControlsState callback would; if NULL, all
+ *        controls are released
+ * @return nonzero if the game is still running, or zero if it has exited
+ *         (for example because LibMame_RunningGame_Schedule_Exit() was
+ *         called); either way, the game must still be passed to
+ *         LibMame_FinishGame()
+ **/
+int LibMame_RunningGame_RunFrame(LibMame_RunningGame *game,
+                                 const LibMame_AllControlsState *controls_state);
+
+
+/**
+ * Stops a game started by LibMame_StartGame(), if it is still running, and
+ * releases it.  The game may not be used after this call.
+ *
+ * @param game is the game to stop, as returned by LibMame_StartGame()
+ * @return the status that resulted from running the game
+ **/
+LibMame_RunGameStatus LibMame_FinishGame(LibMame_RunningGame *game);
+
+
 /**
  * Returns a text string describing the current speed of the game relative
  * to its ideal speed, and additionally information about the autoskip
@@ -2174,6 +2716,358 @@ void LibMame_RunningGame_LoadState(LibMame_RunningGame *game,
                                    const char *filename);
 
 
+/**
+ * Returns the number of bytes needed to hold a snapshot of the currently
+ * running game's state in memory.  For an uncompressed snapshot, this is
+ * the exact size of the snapshot; for a compressed snapshot, this is the
+ * largest size that the snapshot could possibly be.  The size does not
+ * change while a game is running.  This function may only be called from
+ * within the MakeRunningGameCalls or Paused callback, and not from any
+ * other context of execution.
+ *
+ * @param game is the game that is to be queried; this game is known because
+ *        it was passed into the StartingUp() callback function.
+ * @param compressed is nonzero to return the size bound of a compressed
+ *        snapshot, zero to return the size of an uncompressed snapshot
+ * @return the number of bytes needed to hold a snapshot of the game's state
+ **/
+uint32_t LibMame_RunningGame_GetStateSize(LibMame_RunningGame *game,
+                                          int compressed);
+
+
+/**
+ * Requests that the currently running game save a snapshot of its state
+ * into the given buffer as soon as possible, without any file I/O.  The
+ * snapshot is taken before the next call to the MakeRunningGameCalls
+ * callback, and the buffer must be left untouched until then; its outcome
+ * is reported by LibMame_RunningGame_GetStateBufferStatus().  This function
+ * may only be called from within the MakeRunningGameCalls or Paused
+ * callback, and not from any other context of execution.
+ *
+ * @param game is the game that is to be saved; this game is known because
+ *        it was passed into the StartingUp() callback function.
+ * @param buffer is the memory to save the snapshot into
+ * @param buffer_size is the size of [buffer] in bytes; it should be at least
+ *        LibMame_RunningGame_GetStateSize(game, compress)
+ * @param compress is nonzero to deflate the snapshot, which makes it
+ *        smaller but slower to take, or zero to store it uncompressed
+ **/
+void LibMame_RunningGame_SaveStateToBuffer(LibMame_RunningGame *game,
+                                           void *buffer, uint32_t buffer_size,
+                                           int compress);
+
+
+/**
+ * Requests that the currently running game load a snapshot of its state,
+ * previously saved by LibMame_RunningGame_SaveStateToBuffer(), from the
+ * given buffer as soon as possible, which will replace the current state.
+ * The snapshot is loaded before the next call to the MakeRunningGameCalls
+ * callback, and the buffer must be left untouched until then; its outcome
+ * is reported by LibMame_RunningGame_GetStateBufferStatus().  This function
+ * may only be called from within the MakeRunningGameCalls or Paused
+ * callback, and not from any other context of execution.
+ *
+ * @param game is the game that is to be loaded; this game is known because
+ *        it was passed into the StartingUp() callback function.
+ * @param buffer is the memory holding the snapshot
+ * @param buffer_size is the size of the snapshot in bytes
+ **/
+void LibMame_RunningGame_LoadStateFromBuffer(LibMame_RunningGame *game,
+                                             const void *buffer,
+                                             uint32_t buffer_size);
+
+
+/**
+ * Returns the largest number of bytes that a delta snapshot of the currently
+ * running game's state can need.  In practice a delta snapshot is only as
+ * large as the parts of the state which have changed since its base
+ * snapshot was taken.  This function may only be called from within the
+ * MakeRunningGameCalls or Paused callback, and not from any other context
+ * of execution.
+ *
+ * @param game is the game that is to be queried; this game is known because
+ *        it was passed into the StartingUp() callback function.
+ * @return the largest number of bytes that a delta snapshot can need
+ **/
+uint32_t LibMame_RunningGame_GetDeltaStateSize(LibMame_RunningGame *game);
+
+
+/**
+ * Requests that the currently running game save a delta snapshot of its
+ * state into the given buffer as soon as possible, without any file I/O.
+ * A delta snapshot holds only those parts of the state which differ from a
+ * base snapshot, which must be an uncompressed snapshot previously saved by
+ * LibMame_RunningGame_SaveStateToBuffer() for this same running game.  Its
+ * size is mostly proportional to how much has changed, but taking it still
+ * compares the whole of the state against the base snapshot.
+ * The snapshot is taken before the next call to the MakeRunningGameCalls
+ * callback, and both buffers must be left untouched until then; its outcome
+ * is reported by LibMame_RunningGame_GetStateBufferStatus().  This function
+ * may only be called from within the MakeRunningGameCalls or Paused
+ * callback, and not from any other context of execution.
+ *
+ * @param game is the game that is to be saved; this game is known because
+ *        it was passed into the StartingUp() callback function.
+ * @param base is the uncompressed snapshot that the delta is relative to
+ * @param base_size is the size of [base] in bytes
+ * @param buffer is the memory to save the delta snapshot into
+ * @param buffer_size is the size of [buffer] in bytes; a buffer of
+ *        LibMame_RunningGame_GetDeltaStateSize(game) bytes is always
+ *        large enough
+ **/
+void LibMame_RunningGame_SaveDeltaStateToBuffer(LibMame_RunningGame *game,
+                                                const void *base,
+                                                uint32_t base_size,
+                                                void *buffer,
+                                                uint32_t buffer_size);
+
+
+/**
+ * Requests that the currently running game load a delta snapshot of its
+ * state, previously saved by LibMame_RunningGame_SaveDeltaStateToBuffer(),
+ * as soon as possible, which will replace the current state.  The snapshot
+ * is loaded before the next call to the MakeRunningGameCalls callback, and
+ * both buffers must be left untouched until then; its outcome is reported
+ * by LibMame_RunningGame_GetStateBufferStatus().  This function may only be
+ * called from within the MakeRunningGameCalls or Paused callback, and not
+ * from any other context of execution.
+ *
+ * @param game is the game that is to be loaded; this game is known because
+ *        it was passed into the StartingUp() callback function.
+ * @param base is the same base snapshot that the delta was saved against
+ * @param base_size is the size of [base] in bytes
+ * @param buffer is the memory holding the delta snapshot
+ * @param buffer_size is the size of the delta snapshot in bytes
+ **/
+void LibMame_RunningGame_LoadDeltaStateFromBuffer(LibMame_RunningGame *game,
+                                                  const void *base,
+                                                  uint32_t base_size,
+                                                  const void *buffer,
+                                                  uint32_t buffer_size);
+
+
+/**
+ * Returns the outcome of the most recent call to
+ * LibMame_RunningGame_SaveStateToBuffer(),
+ * LibMame_RunningGame_LoadStateFromBuffer(),
+ * LibMame_RunningGame_SaveDeltaStateToBuffer() or
+ * LibMame_RunningGame_LoadDeltaStateFromBuffer().  This function may only be
+ * called from within the MakeRunningGameCalls or Paused callback, and not
+ * from any other context of execution.
+ *
+ * @param game is the game that is to be queried; this game is known because
+ *        it was passed into the StartingUp() callback function.
+ * @param size if non-NULL, is set to the number of bytes of the buffer that
+ *        were written by a successful save, or 0 otherwise
+ * @return the outcome of the most recent save to or load from a buffer
+ **/
+LibMame_StateBufferStatus LibMame_RunningGame_GetStateBufferStatus
+    (LibMame_RunningGame *game, uint32_t *size);
+
+
+/**
+ * Requests that the currently running game be rewound by the given number of
+ * frames of its primary screen, as soon as possible.  Rewinding uses the
+ * history kept when the rewind_size option of the LibMame_RunGameOptions is
+ * nonzero; the state restored is the newest one captured at or before the
+ * requested frame, or the oldest one available if the history does not go
+ * back that far.  Any history newer than the restored state is discarded.
+ * The rewind happens before the next call to the MakeRunningGameCalls
+ * callback, and multiple requests made before then accumulate.  If the
+ * saved state cannot be restored then, the game carries on from where it
+ * was and rewinding is disabled for the rest of the game.  This function may
+ * only be called from within the MakeRunningGameCalls or Paused callback,
+ * and not from any other context of execution.
+ *
+ * @param game is the game that is to be rewound; this game is known because
+ *        it was passed into the StartingUp() callback function.
+ * @param frames is the number of frames to rewind by
+ * @return nonzero if the rewind was scheduled, or zero if rewinding is not
+ *         enabled for this game, there is no history to rewind to, or the
+ *         previous rewind failed to restore its state
+ **/
+int LibMame_RunningGame_Rewind(LibMame_RunningGame *game, int frames);
+
+
+/**
+ * Switches video output of the running game between primitive lists and a
+ * caller-owned framebuffer.  Once a framebuffer is set, every frame is
+ * composed by MAME's software renderer into the framebuffer at its size,
+ * and the UpdateVideo callback is then made with a NULL primitive list to
+ * announce that the framebuffer holds a new frame.  This spares callers
+ * that only want pixels, such as headless encoders, from rasterizing the
+ * primitive list themselves.  The framebuffer must remain valid until it
+ * is replaced or cleared by another call to this function, or the game
+ * exits.  This function may only be called from within the
+ * MakeRunningGameCalls or Paused callback, and not from any other context of
+ * execution.
+ *
+ * @param game is the game whose output is to be changed; this game is known
+ *        because it was passed into the StartingUp() callback function.
+ * @param buffer is the framebuffer to render into, or NULL to go back to
+ *        passing primitive lists to the UpdateVideo callback
+ * @param format is the pixel format of [buffer]
+ * @param width is the width of [buffer] in pixels
+ * @param height is the height of [buffer] in pixels
+ * @param pitch is the distance between the starts of consecutive rows of
+ *        [buffer], in pixels; it must be at least [width]
+ * @return nonzero if the framebuffer was set or cleared, or zero if [format]
+ *         is unknown, [width] or [height] is not positive, [pitch] is less
+ *         than [width], or [buffer] would be 2 GB or larger; the previous
+ *         framebuffer, if any, is then left in place
+ **/
+int LibMame_RunningGame_SetFramebuffer(LibMame_RunningGame *game,
+                                       void *buffer,
+                                       LibMame_FramebufferFormat format,
+                                       int width, int height, int pitch);
+
+
+/**
+ * Installs a callback that is given direct access to the native bitmap of
+ * each of the game's screens every time one of them completes a frame that
+ * changed, along with its palette, visible area and the rows that changed
+ * since the previous frame.  This lets callers that only want the game's
+ * own pixels avoid the render target entirely.  Screens that draw
+ * themselves directly into the layout, such as vector screens, are never
+ * reported.  This function may only be called from within the
+ * MakeRunningGameCalls or Paused callback, and not from any other context of
+ * execution.
+ *
+ * @param game is the game whose screens are to be reported; this game is
+ *        known because it was passed into the StartingUp() callback
+ *        function.
+ * @param callback is the function to call with each frame, or NULL to stop
+ *        reporting frames
+ **/
+void LibMame_RunningGame_SetScreenBitmapCallback
+    (LibMame_RunningGame *game, LibMame_ScreenBitmapCallback callback);
+
+
+/**
+ * Attaches an audio ring to the running game, or detaches it.  While a ring
+ * is attached, the game's audio is pushed into it instead of being passed
+ * to the UpdateAudio callback, so that a slow audio host never holds up
+ * emulation; see LibMame_AudioRing_Create().  A ring may only be attached to
+ * one running game at a time.  This function may only be called from within
+ * the MakeRunningGameCalls or Paused callback, and not from any other context
+ * of execution.
+ *
+ * @param game is the game whose audio is to be redirected; this game is
+ *        known because it was passed into the StartingUp() callback
+ *        function.
+ * @param ring is the ring to push audio into, or NULL to go back to the
+ *        UpdateAudio callback
+ **/
+void LibMame_RunningGame_SetAudioRing(LibMame_RunningGame *game,
+                                      LibMame_AudioRing *ring);
+
+
+/**
+ * Collects statistics about the running game: how much work the scheduler
+ * and each executing device are doing, and where the time of each frame is
+ * going.  Sampling this once per frame is cheap.  This function may only be
+ * called from within the MakeRunningGameCalls or Paused callback, or
+ * between calls to LibMame_RunningGame_RunFrame(), and not from any other
+ * context of execution.
+ *
+ * @param game is the game that is to be queried; this game is known because
+ *        it was passed into the StartingUp() callback function.
+ * @param stats returns the statistics
+ **/
+void LibMame_RunningGame_GetStats(LibMame_RunningGame *game,
+                                  LibMame_RunningGameStats *stats);
+
+
+/**
+ * Enables or disables the profiler, whose figures are reported by
+ * LibMame_RunningGame_GetStats().  Enabling it resets its totals.  It costs
+ * some emulation speed while enabled, and does nothing in builds of libmame
+ * made without it.  The profiler is shared by the whole process; this is
+ * safe because only one game may run at a time (see
+ * LibMame_RunGameStatus_GameAlreadyRunning), and it is turned off whenever
+ * a game finishes, so every game starts with it disabled.  This function
+ * may only be called from within the MakeRunningGameCalls or Paused
+ * callback, or between calls to LibMame_RunningGame_RunFrame(), and not
+ * from any other context of execution.
+ *
+ * @param game is the game whose profiler is to be enabled or disabled; this
+ *        game is known because it was passed into the StartingUp() callback
+ *        function.
+ * @param enabled is nonzero to enable the profiler, zero to disable it
+ **/
+void LibMame_RunningGame_SetProfilerEnabled(LibMame_RunningGame *game,
+                                            int enabled);
+
+
+/**
+ * Enables or disables write tracking for one address space of one of the
+ * game's devices.  While enabled, every write the space makes to RAM, ROM or
+ * a memory bank marks the page containing it as dirty, which
+ * LibMame_RunningGame_GetDirtyBitmap() reports.  Writes that bypass the
+ * address space, such as those made by a CPU core directly through its
+ * opcode or RAM pointers, or by DMA into a shared pointer, are not seen.
+ * Enabling tracking, even if it was already enabled, starts with every page
+ * clean.  This function may only be called from within the
+ * MakeRunningGameCalls or Paused callback, or between calls to
+ * LibMame_RunningGame_RunFrame(), and not from any other context of
+ * execution.
+ *
+ * @param game is the game whose memory is to be tracked; this game is known
+ *        because it was passed into the StartingUp() callback function.
+ * @param tag is the tag of the device owning the address space, for example
+ *        "maincpu"
+ * @param space is the number of the address space: 0 for program, 1 for
+ *        data and 2 for I/O
+ * @param granularity_bits gives the size of each tracked page, which is
+ *        1 << granularity_bits bytes; it is clamped to between 3 and 31.  0
+ *        disables tracking.
+ * @return nonzero on success, zero if there is no such device or address
+ *         space
+ **/
+int LibMame_RunningGame_SetWriteTracking(LibMame_RunningGame *game,
+                                         const char *tag, int space,
+                                         int granularity_bits);
+
+
+/**
+ * Returns the dirty page bitmap of an address space for which write
+ * tracking has been enabled with LibMame_RunningGame_SetWriteTracking().
+ * This function may only be called from within the MakeRunningGameCalls or
+ * Paused callback, or between calls to LibMame_RunningGame_RunFrame(), and
+ * not from any other context of execution.
+ *
+ * @param game is the game whose memory is tracked; this game is known
+ *        because it was passed into the StartingUp() callback function.
+ * @param tag is the tag of the device owning the address space
+ * @param space is the number of the address space
+ * @param bitmap returns the bitmap
+ * @return nonzero on success, zero if there is no such device or address
+ *         space, or it is not being tracked
+ **/
+int LibMame_RunningGame_GetDirtyBitmap(LibMame_RunningGame *game,
+                                       const char *tag, int space,
+                                       LibMame_DirtyBitmap *bitmap);
+
+
+/**
+ * Marks every page of a tracked address space as clean, typically after
+ * the pages reported dirty by LibMame_RunningGame_GetDirtyBitmap() have been
+ * consumed.  This function may only be called from within the
+ * MakeRunningGameCalls or Paused callback, or between calls to
+ * LibMame_RunningGame_RunFrame(), and not from any other context of
+ * execution.
+ *
+ * @param game is the game whose memory is tracked; this game is known
+ *        because it was passed into the StartingUp() callback function.
+ * @param tag is the tag of the device owning the address space
+ * @param space is the number of the address space
+ * @return nonzero on success, zero if there is no such device or address
+ *         space, or it is not being tracked
+ **/
+int LibMame_RunningGame_ResetDirtyBitmap(LibMame_RunningGame *game,
+                                         const char *tag, int space);
+
+
 /**
  * Sets a new value for a dipswitch.  The dipswitch is identified by the name
  * and mask of the LibMame_Dipswitch.  This function may only be called from
@@ -2192,6 +3086,67 @@ void LibMame_RunningGame_ChangeDipswitchValue(LibMame_RunningGame *game,
                                               const char *value);
 
 
+/*----------------------------------------------------------------------------
+ * Functions for managing audio rings
+ ----------------------------------------------------------------------------*/
+
+/**
+ * Creates an audio ring: a lock-free ring buffer of interleaved stereo 16
+ * bit frames, with a single producer, which is the running game that the
+ * ring is attached to by LibMame_RunningGame_SetAudioRing(), and a single
+ * consumer, which is whichever one thread calls LibMame_AudioRing_Read().
+ * Neither ever blocks the other.  If the ring is full when the game
+ * produces audio, the frames that do not fit are dropped and counted as an
+ * overrun.  The ring belongs to the caller, and may outlive the games it is
+ * attached to.
+ *
+ * @param capacity_frames is the minimum number of frames the ring must hold;
+ *        it is rounded up to a power of two, and may be at most 2^30
+ * @return the new ring, or NULL if capacity_frames is out of range or the
+ *         ring could not be allocated
+ **/
+LibMame_AudioRing *LibMame_AudioRing_Create(int capacity_frames);
+
+
+/**
+ * Destroys an audio ring.  The ring must not be attached to a running game,
+ * and must not be in use by any thread.
+ *
+ * @param ring is the ring to destroy
+ **/
+void LibMame_AudioRing_Destroy(LibMame_AudioRing *ring);
+
+
+/**
+ * Reads frames from an audio ring.  If fewer frames are available than
+ * were asked for, all available frames are returned, the rest of the buffer
+ * is filled with silence, and the shortfall is counted as an underrun.  This
+ * function may only be called by one thread at a time.
+ *
+ * @param ring is the ring to read from
+ * @param buffer is where to store the frames; it must have room for
+ *        [frames] frames of two samples each
+ * @param frames is the number of frames to read
+ * @param time_ns if non-NULL, returns the emulated time of the first frame
+ *        read, in nanoseconds, or 0 if no frames were read
+ * @return the number of frames read from the ring
+ **/
+int LibMame_AudioRing_Read(LibMame_AudioRing *ring, int16_t *buffer,
+                           int frames, uint64_t *time_ns);
+
+
+/**
+ * Returns statistics about an audio ring.  This may be called from any
+ * thread; the values returned are a snapshot that may already be out of
+ * date.
+ *
+ * @param ring is the ring to query
+ * @param stats returns the statistics
+ **/
+void LibMame_AudioRing_GetStats(LibMame_AudioRing *ring,
+                                LibMame_AudioRingStats *stats);
+
+
 #ifdef __cplusplus
 }
 #endif
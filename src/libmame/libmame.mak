@@ -15,6 +15,7 @@ OBJDIRS += $(OBJ)/libmame
 # These are the libmame objects
 
 LIBMAMEOBJS = $(OBJ)/libmame/hashtable.o                                     \
+              $(OBJ)/libmame/libmame_audio.o                                 \
               $(OBJ)/libmame/libmame_idv.o                                   \
               $(OBJ)/libmame/libmame_games.o                                 \
               $(OBJ)/libmame/libmame_options.o                               \
@@ -38,6 +39,10 @@ endif
 # rules
 #------------------------------------------------
 
+# libmame_rungame.c includes the software renderer to compose frames into
+# caller-owned framebuffers
+$(OBJ)/libmame/libmame_rungame.o: $(SRC)/emu/rendersw.c
+
 ifdef STATIC
 
 # Because of command line length limits in Microsoft Windows, use GNU tools
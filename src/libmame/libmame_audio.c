@@ -0,0 +1,329 @@
+/** **************************************************************************
+ * libmame_audio.c
+ *
+ * LibMame audio ring buffer implementation.
+ *
+ * Copyright Bryan Ischo and the MAME Team.
+ * Visit http://mamedev.org for licensing and usage restrictions.
+ *
+ ************************************************************************** **/
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "libmame.h"
+
+
+/**
+ * An audio ring is a single-producer, single-consumer ring buffer of
+ * interleaved stereo frames.  The producer is the thread running the game,
+ * which pushes each batch of audio that MAME produces; the consumer is
+ * whatever thread the host drains audio from.  Neither side ever takes a
+ * lock or waits for the other.
+ *
+ * Each side owns one position counter and only reads the other's.  The
+ * counters count frames since the ring was created and are allowed to wrap;
+ * capacities are powers of two so that wrapped differences still work.  A
+ * memory barrier separates writing ring contents from publishing the
+ * position that makes them visible, and reading the other side's position
+ * from touching the contents it covers.
+ *
+ * Alongside the samples is a second, smaller ring with one record per push,
+ * holding the frame position at which the push started, along with its
+ * emulated time and sample rate.  These records let the consumer timestamp
+ * whatever frame it is about to read.
+ **/
+
+
+/** **************************************************************************
+ * Helper Macros
+ ************************************************************************** **/
+
+/**
+ * The largest capacity a ring may have, in frames.  Positions are 32 bit
+ * counters, so differences between them are only meaningful for rings of
+ * up to 2^31 frames; staying well below that also keeps the size of the
+ * sample buffer from overflowing.
+ **/
+#define MAX_CAPACITY_FRAMES (1 << 30)
+
+
+/** **************************************************************************
+ * Structured Type Definitions
+ ************************************************************************** **/
+
+/**
+ * A record of one push of audio into the ring
+ **/
+typedef struct libmame_audio_push
+{
+    /**
+     * Frame position of the first frame of the push
+     **/
+    uint32_t position;
+
+    /**
+     * Sample rate of the frames of the push
+     **/
+    int sample_rate;
+
+    /**
+     * Emulated time of the first frame of the push, in nanoseconds
+     **/
+    uint64_t time_ns;
+} libmame_audio_push;
+
+
+struct LibMame_AudioRing
+{
+    /**
+     * Size of the ring in frames, and that minus one
+     **/
+    uint32_t capacity, mask;
+
+    /**
+     * The frames; each is two interleaved samples
+     **/
+    int16_t *samples;
+
+    /**
+     * Frame positions: frames are written at write_position by the producer
+     * and read from read_position by the consumer
+     **/
+    volatile uint32_t write_position;
+    volatile uint32_t read_position;
+
+    /**
+     * The push records, and their write and read indices, which behave just
+     * like the frame positions
+     **/
+    uint32_t push_capacity, push_mask;
+    libmame_audio_push *pushes;
+    volatile uint32_t push_write;
+    volatile uint32_t push_read;
+
+    /**
+     * Frames dropped because the ring was full; written by the producer
+     **/
+    volatile uint32_t overrun_frames;
+
+    /**
+     * Frames requested that were not available; written by the consumer
+     **/
+    volatile uint32_t underrun_frames;
+};
+
+
+/** **************************************************************************
+ * Static helper functions
+ ************************************************************************** **/
+
+/**
+ * Orders all memory accesses before the barrier ahead of all those after it
+ **/
+static inline void memory_barrier()
+{
+    __sync_synchronize();
+}
+
+
+/**
+ * Returns the smallest power of two that is at least [value]
+ **/
+static uint32_t round_up_to_power_of_two(uint32_t value)
+{
+    uint32_t result = 1;
+
+    while (result < value) {
+        result <<= 1;
+    }
+
+    return result;
+}
+
+
+/** **************************************************************************
+ * Exported functions
+ ************************************************************************** **/
+
+/**
+ * Called from the game thread with each batch of audio while an audio ring
+ * is attached to the running game.  [time_ns] is the emulated time of the
+ * first frame.
+ **/
+void libmame_audio_ring_push(LibMame_AudioRing *ring, int sample_rate,
+                             const int16_t *buffer, int frames,
+                             uint64_t time_ns)
+{
+    uint32_t write = ring->write_position;
+    uint32_t push_write = ring->push_write;
+
+    /* See how much room the consumer has left us */
+    uint32_t read = ring->read_position;
+    uint32_t push_read = ring->push_read;
+    memory_barrier();
+
+    uint32_t count = ring->capacity - (write - read);
+    if (count > (uint32_t) frames) {
+        count = frames;
+    }
+
+    /* Without a push record to describe them, frames can't be stored */
+    if ((push_write - push_read) == ring->push_capacity) {
+        count = 0;
+    }
+
+    ring->overrun_frames += frames - count;
+
+    if (count == 0) {
+        return;
+    }
+
+    /* Copy the frames in, in two pieces if they wrap around the end */
+    uint32_t start = write & ring->mask;
+    uint32_t first = ring->capacity - start;
+    if (first > count) {
+        first = count;
+    }
+    memcpy(&(ring->samples[start * 2]), buffer, first * 2 * sizeof(int16_t));
+    memcpy(ring->samples, &(buffer[first * 2]),
+           (count - first) * 2 * sizeof(int16_t));
+
+    libmame_audio_push *push = &(ring->pushes[push_write & ring->push_mask]);
+    push->position = write;
+    push->sample_rate = sample_rate;
+    push->time_ns = time_ns;
+
+    /* Publish the record before the frames, so that any frame the consumer
+       can see is always described by a record it can also see */
+    memory_barrier();
+    ring->push_write = push_write + 1;
+    memory_barrier();
+    ring->write_position = write + count;
+}
+
+
+LibMame_AudioRing *LibMame_AudioRing_Create(int capacity_frames)
+{
+    if ((capacity_frames <= 0) || (capacity_frames > MAX_CAPACITY_FRAMES)) {
+        return 0;
+    }
+
+    LibMame_AudioRing *ring =
+        (LibMame_AudioRing *) calloc(1, sizeof(LibMame_AudioRing));
+    if (!ring) {
+        return 0;
+    }
+
+    ring->capacity = round_up_to_power_of_two(capacity_frames);
+    ring->mask = ring->capacity - 1;
+
+    /* A push rarely carries fewer than 64 frames, so this many records is
+       enough to describe a full ring in all but unusual cases */
+    ring->push_capacity = round_up_to_power_of_two(ring->capacity / 64);
+    if (ring->push_capacity < 64) {
+        ring->push_capacity = 64;
+    }
+    ring->push_mask = ring->push_capacity - 1;
+
+    /* Sizes are computed in size_t; on 32 bit hosts the largest rings
+       don't fit in it at all */
+    if (ring->capacity <= (SIZE_MAX / (2 * sizeof(int16_t)))) {
+        ring->samples = (int16_t *)
+            malloc(((size_t) ring->capacity) * 2 * sizeof(int16_t));
+        ring->pushes = (libmame_audio_push *)
+            malloc(((size_t) ring->push_capacity) *
+                   sizeof(libmame_audio_push));
+    }
+
+    if (!ring->samples || !ring->pushes) {
+        LibMame_AudioRing_Destroy(ring);
+        return 0;
+    }
+
+    return ring;
+}
+
+
+void LibMame_AudioRing_Destroy(LibMame_AudioRing *ring)
+{
+    free(ring->pushes);
+    free(ring->samples);
+    free(ring);
+}
+
+
+int LibMame_AudioRing_Read(LibMame_AudioRing *ring, int16_t *buffer,
+                           int frames, uint64_t *time_ns)
+{
+    uint32_t read = ring->read_position;
+    uint32_t push_read = ring->push_read;
+
+    /* See how much the producer has given us; the frame position must be
+       read before the push records so that every visible frame has one */
+    uint32_t write = ring->write_position;
+    memory_barrier();
+    uint32_t push_write = ring->push_write;
+    memory_barrier();
+
+    uint32_t count = write - read;
+    if (count > (uint32_t) frames) {
+        count = frames;
+    }
+
+    /* Anything asked for that isn't there is an underrun, and silence */
+    if (count < (uint32_t) frames) {
+        ring->underrun_frames += frames - count;
+        memset(&(buffer[count * 2]), 0,
+               (frames - count) * 2 * sizeof(int16_t));
+    }
+
+    if (count == 0) {
+        if (time_ns) {
+            *time_ns = 0;
+        }
+        return 0;
+    }
+
+    /* Skip the records of pushes that have been completely read */
+    while (((push_write - push_read) > 1) &&
+           ((int32_t) (ring->pushes[(push_read + 1) & ring->push_mask].position
+                       - read) <= 0)) {
+        push_read++;
+    }
+
+    if (time_ns) {
+        const libmame_audio_push *push =
+            &(ring->pushes[push_read & ring->push_mask]);
+        *time_ns = push->time_ns +
+            (((uint64_t) (read - push->position)) * 1000000000ULL /
+             push->sample_rate);
+    }
+
+    /* Copy the frames out, in two pieces if they wrap around the end */
+    uint32_t start = read & ring->mask;
+    uint32_t first = ring->capacity - start;
+    if (first > count) {
+        first = count;
+    }
+    memcpy(buffer, &(ring->samples[start * 2]), first * 2 * sizeof(int16_t));
+    memcpy(&(buffer[first * 2]), ring->samples,
+           (count - first) * 2 * sizeof(int16_t));
+
+    /* Hand the space back to the producer */
+    memory_barrier();
+    ring->push_read = push_read;
+    ring->read_position = read + count;
+
+    return count;
+}
+
+
+void LibMame_AudioRing_GetStats(LibMame_AudioRing *ring,
+                                LibMame_AudioRingStats *stats)
+{
+    stats->capacity_frames = ring->capacity;
+    stats->available_frames = ring->write_position - ring->read_position;
+    stats->overrun_frames = ring->overrun_frames;
+    stats->underrun_frames = ring->underrun_frames;
+}
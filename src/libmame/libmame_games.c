@@ -13,6 +13,7 @@
 
 #include <pthread.h>
 #include <string.h>
+#include <unistd.h>
 #include "hashtable.h"
 #include "emu.h"
 #include "drivenum.h"
@@ -33,7 +34,7 @@ static const char *emptyStringG = "";
 
 typedef struct GameInfo
 {
-    bool converted;
+    volatile bool converted;
     int driver_index;
     int gameinfo_index;
     int year_of_release;
@@ -100,7 +101,14 @@ private:
 
 static MameDriversWrapper g_drivers;
 
+/**
+ * g_mutex serializes building the catalog and converting its entries.  Once
+ * g_gameinfos_ready is set the catalog index never changes, and once an
+ * entry's converted flag is set that entry never changes, so readers only
+ * take the mutex when they need something built.
+ **/
 static pthread_mutex_t g_mutex = PTHREAD_MUTEX_INITIALIZER;
+static volatile bool g_gameinfos_ready = false;
 static int g_game_count = 0;
 static GameInfo *g_gameinfos = 0;
 /* Hash short names to driver indexes */
@@ -128,6 +136,12 @@ static Hash::Table<Hash::StringKey, int> g_gameinfos_hash;
 static GameInfo *get_gameinfo_locked(int gamenum);
 static GameInfo *get_gameinfo(int gamenum);
 
+static inline void memory_barrier()
+{
+    __sync_synchronize();
+}
+
+
 static void *osd_calloc(size_t size)
 {
     void *ret = osd_malloc(size);
@@ -381,18 +395,24 @@ static void convert_sound_samples(const machine_config *machineconfig,
         if (gameinfo->sound_samples_source == -1) {
             gameinfo->sound_samples_source = gameinfo->gameinfo_index;
         }
-        /* Finally, if the sound samples that were found were identical to
-           those of the source game (and the source game was different than
-           this game), then just free them as an indication that they are
-           identical */
-        if (gameinfo->sound_samples_source != gameinfo->gameinfo_index) {
-            const GameInfo *source_gameinfo = 
-                get_gameinfo_locked(gameinfo->sound_samples_source);
-            if (sound_samples_identical(gameinfo, source_gameinfo)) {
-                osd_free(gameinfo->sound_samples);
-                gameinfo->sound_samples = NULL;
-            }
-        }
+    }
+}
+
+
+/**
+ * If the sound samples of a converted game are identical to those of its
+ * (converted) source game, and the source game is a different game, then
+ * free them as an indication that they are identical.  This is separate
+ * from convert_sound_samples so that games can be converted without
+ * depending upon each other.
+ **/
+static void share_sound_samples(GameInfo *gameinfo,
+                                const GameInfo *source_gameinfo)
+{
+    if ((source_gameinfo != gameinfo) &&
+        sound_samples_identical(gameinfo, source_gameinfo)) {
+        osd_free(gameinfo->sound_samples);
+        gameinfo->sound_samples = NULL;
     }
 }
 
@@ -1006,7 +1026,8 @@ static void convert_controllers(const ioport_list *ioportlist,
 }
 
 
-static void convert_image_info(const game_driver &driver,
+static void convert_image_info(driver_enumerator &drivers,
+                               const game_driver &driver,
                                const device_t &device, GameInfo *gameinfo)
 {
     /* Convert the roms and hdd images */
@@ -1070,10 +1091,10 @@ static void convert_image_info(const game_driver &driver,
             image->clone_of_game = emptyStringG;
             image->clone_of_rom = emptyStringG;
 
-            int clone_of = g_drivers.Get().find(driver.parent);
+            int clone_of = drivers.find(driver.parent);
             if (clone_of != -1) {
                 machine_config &clone_of_machineconfig =
-                    g_drivers.Get().config(clone_of);
+                    drivers.config(clone_of);
                 for (const rom_entry *pregion = 
                          rom_first_region(clone_of_machineconfig.
                                           root_device()); pregion;
@@ -1193,11 +1214,16 @@ static void convert_source_file_name(const game_driver *driver,
 }
 
 
-static void convert_game_info(GameInfo *gameinfo)
+/**
+ * Converts everything but the sharing of sound samples, which is done by
+ * share_sound_samples once the source game is also converted.  [drivers]
+ * caches the machine configs that it builds, so concurrent conversions must
+ * each use their own.
+ **/
+static void convert_game_info(driver_enumerator &drivers, GameInfo *gameinfo)
 {
-    const game_driver &driver = g_drivers.Get().driver(gameinfo->driver_index);
-	machine_config &machineconfig = g_drivers.Get().config
-        (gameinfo->driver_index);
+    const game_driver &driver = drivers.driver(gameinfo->driver_index);
+	machine_config &machineconfig = drivers.config(gameinfo->driver_index);
     ioport_list ioportlist;
     astring errors;
 	device_iterator iter(machineconfig.root_device());
@@ -1216,19 +1242,21 @@ static void convert_game_info(GameInfo *gameinfo)
     convert_chips(&machineconfig, gameinfo);
     convert_settings(&ioportlist, gameinfo);
     convert_controllers(&ioportlist, gameinfo);
-    convert_image_info(driver, machineconfig.root_device(), gameinfo);
+    convert_image_info(drivers, driver, machineconfig.root_device(),
+                       gameinfo);
     convert_source_file_name(&driver, gameinfo);
 }
 
 
 static GameInfo *get_gameinfo_helper_locked(int gamenum, bool converted)
 {
-    if (g_game_count == 0) {
+    if (!g_gameinfos_ready) {
         // Get the drivers list to ensure that it has been created
         (void) g_drivers.Get();
 
         int count = driver_list::total();
     
+        g_game_count = 0;
         for (int i = 0; i < count; i++) {
             const game_driver &driver = driver_list::driver(i);
             if (driver.flags & (GAME_IS_BIOS_ROOT | GAME_NO_STANDALONE |
@@ -1258,12 +1286,21 @@ static GameInfo *get_gameinfo_helper_locked(int gamenum, bool converted)
                 (driver.name, /* returns */ pHashValue);
             *pHashValue = gameinfo_index++;
         }
+
+        /* Everything above must be visible before the flag is */
+        memory_barrier();
+        g_gameinfos_ready = true;
     }
 
     GameInfo *ret = &(g_gameinfos[gamenum]);
 
     if (converted && !ret->converted) {
-        convert_game_info(ret);
+        convert_game_info(g_drivers.Get(), ret);
+        if (ret->sound_samples_count) {
+            share_sound_samples
+                (ret, get_gameinfo_locked(ret->sound_samples_source));
+        }
+        memory_barrier();
         ret->converted = true;
     }
 
@@ -1273,6 +1310,16 @@ static GameInfo *get_gameinfo_helper_locked(int gamenum, bool converted)
 
 static GameInfo *get_gameinfo_helper(int gamenum, bool converted)
 {
+    /* Anything that has already been built can be read without the lock */
+    if (g_gameinfos_ready) {
+        memory_barrier();
+        GameInfo *ret = &(g_gameinfos[gamenum]);
+        if (!converted || ret->converted) {
+            memory_barrier();
+            return ret;
+        }
+    }
+
     pthread_mutex_lock(&g_mutex);
 
     GameInfo *ret = get_gameinfo_helper_locked(gamenum, converted);
@@ -1314,6 +1361,32 @@ static GameInfo *get_gameinfo(int gamenum)
 }
 
 
+/**
+ * Thread function for LibMame_Prepare_Game_Info, which converts games,
+ * claiming them one at a time from [arg], until there are none left
+ **/
+static void *convert_games_thread(void *arg)
+{
+    volatile int *next_gamenum = (volatile int *) arg;
+
+    emu_options options;
+    driver_enumerator drivers(options);
+
+    while (true) {
+        int gamenum = __sync_fetch_and_add(next_gamenum, 1);
+        if (gamenum >= g_game_count) {
+            break;
+        }
+        GameInfo *gameinfo = &(g_gameinfos[gamenum]);
+        if (!gameinfo->converted) {
+            convert_game_info(drivers, gameinfo);
+        }
+    }
+
+    return 0;
+}
+
+
 void LibMame_Games_Deinitialize()
 {
     pthread_mutex_lock(&g_mutex);
@@ -1384,6 +1457,7 @@ void LibMame_Games_Deinitialize()
         g_gameinfos = 0;
     }
 
+    g_gameinfos_ready = false;
     g_game_count = 0;
 
     g_drivers_hash.Clear();
@@ -1393,6 +1467,70 @@ void LibMame_Games_Deinitialize()
 }
 
 
+void LibMame_Prepare_Game_Info(int thread_count)
+{
+    pthread_mutex_lock(&g_mutex);
+
+    (void) get_gameinfo_helper_locked(0, false);
+
+    if (thread_count <= 0) {
+        long cpu_count = sysconf(_SC_NPROCESSORS_ONLN);
+        thread_count = (cpu_count > 0) ? cpu_count : 1;
+    }
+    if (thread_count > g_game_count) {
+        thread_count = g_game_count;
+    }
+
+    /* Converting a game doesn't touch any other game, so the games can be
+       converted by any number of threads at once.  None of them are marked
+       converted until all are done, so readers that want an unconverted game
+       wait on g_mutex until then. */
+    volatile int next_gamenum = 0;
+    pthread_t *threads = (pthread_t *) osd_malloc
+        (sizeof(pthread_t) * thread_count);
+    int started = 0;
+    while (threads && (started < thread_count)) {
+        if (pthread_create(&(threads[started]), 0, &convert_games_thread,
+                           (void *) &next_gamenum)) {
+            break;
+        }
+        started++;
+    }
+
+    /* If no thread could be started, then do the work on this one */
+    if (started == 0) {
+        (void) convert_games_thread((void *) &next_gamenum);
+    }
+
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], 0);
+    }
+
+    osd_free(threads);
+
+    /* Sound samples sharing compares games against each other, so it can
+       only be done now that all games are converted */
+    for (int i = 0; i < g_game_count; i++) {
+        GameInfo *gameinfo = &(g_gameinfos[i]);
+        if (gameinfo->converted) {
+            continue;
+        }
+        if (gameinfo->sound_samples_count) {
+            share_sound_samples
+                (gameinfo, &(g_gameinfos[gameinfo->sound_samples_source]));
+        }
+    }
+
+    memory_barrier();
+
+    for (int i = 0; i < g_game_count; i++) {
+        g_gameinfos[i].converted = true;
+    }
+
+    pthread_mutex_unlock(&g_mutex);
+}
+
+
 int LibMame_Get_Game_Count()
 {
     /* Force get_gameinfo_helper() to ensure that all game infos are
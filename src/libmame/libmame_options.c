@@ -84,6 +84,8 @@ static const option_map_entry g_option_map[] =
     OPTION_MAP_ENTRY(string, SNAPSIZE, snapsize),
     OPTION_MAP_ENTRY(string, SNAPVIEW, snapview),
     OPTION_MAP_ENTRY(integer, BURNIN, burnin),
+    OPTION_MAP_ENTRY(integer, REWIND_SIZE, rewind_size),
+    OPTION_MAP_ENTRY(integer, REWIND_INTERVAL, rewind_interval),
     OPTION_MAP_ENTRY(boolean, AUTOFRAMESKIP, auto_frame_skip),
     OPTION_MAP_ENTRY(integer, FRAMESKIP, frame_skip_level),
     OPTION_MAP_ENTRY(boolean, THROTTLE, throttle),
@@ -114,6 +116,7 @@ static const option_map_entry g_option_map[] =
     OPTION_MAP_ENTRY(integer, SAMPLERATE, sample_rate),
     OPTION_MAP_ENTRY(boolean, SAMPLES, use_samples),
     OPTION_MAP_ENTRY(integer, VOLUME, volume_attenuation),
+    OPTION_MAP_ENTRY(string, AUDIO_FORMAT, audio_format),
     OPTION_MAP_ENTRY(boolean, COIN_LOCKOUT, coin_lockout),
     OPTION_MAP_ENTRY(string, JOYSTICK_MAP, joystick_map),
     OPTION_MAP_ENTRY(float, JOYSTICK_DEADZONE, joystick_deadzone),
@@ -8,6 +8,7 @@
  *
  ************************************************************************** **/
 
+#include <pthread.h>
 #include <stddef.h>
 #include <string.h>
 #include "emu.h"
@@ -17,6 +18,8 @@
 #include "osdcore.h"
 #include "osdepend.h"
 #include "render.h"
+#include "rendersw.c"
+#include "rewind.h"
 #include "video.h"
 
 
@@ -30,6 +33,9 @@
 extern void get_mame_options(const LibMame_RunGameOptions *options,
                              const char *gamename,
                              emu_options &mame_options);
+extern void libmame_audio_ring_push(LibMame_AudioRing *ring, int sample_rate,
+                                    const int16_t *buffer, int frames,
+                                    uint64_t time_ns);
 
 
 /** **************************************************************************
@@ -67,13 +73,20 @@ typedef enum
  * Static prototypes
  ************************************************************************** **/
 /* libmame OSD prototypes */
-static void osd_init(running_machine *machine);
-static void osd_update(running_machine *machine, int skip_redraw);
-static void osd_update_audio_stream(running_machine *machine, 
+static void osd_init(LibMame_RunningGame *game, running_machine *machine);
+static void osd_update(LibMame_RunningGame *game, running_machine *machine,
+                       int skip_redraw);
+static void osd_update_audio_stream(LibMame_RunningGame *game,
+                                    running_machine *machine, 
                                     const INT16 *buffer,
                                     int samples_this_frame);
-static void osd_set_mastervolume(int attenuation);
-static void osd_customize_input_type_list(simple_list<input_type_entry> &typelist);
+static void osd_update_audio_stream_float(LibMame_RunningGame *game,
+                                          running_machine *machine,
+                                          const float *buffer, int channels,
+                                          int samples_this_frame);
+static void osd_set_mastervolume(LibMame_RunningGame *game, int attenuation);
+static void osd_customize_input_type_list(LibMame_RunningGame *game,
+                                          simple_list<input_type_entry> &typelist);
 
 
 /** **************************************************************************
@@ -84,7 +97,8 @@ class libmame_rungame_osd_interface : public osd_interface
 {
 public:
 
-	libmame_rungame_osd_interface()
+	libmame_rungame_osd_interface(LibMame_RunningGame *game)
+        : m_game(game)
     {
     }
 
@@ -96,30 +110,51 @@ public:
     {
         this->osd_interface::init(machine);
 
-        return osd_init(&machine);
+        return osd_init(m_game, &machine);
     }
 
 	virtual void update(bool skip_redraw)
     {
-        return osd_update(&(this->machine()), skip_redraw);
+        return osd_update(m_game, &(this->machine()), skip_redraw);
     }
 
 	virtual void update_audio_stream(const INT16 *buffer, 
                                      int samples_this_frame)
     {
-        return osd_update_audio_stream(&(this->machine()), buffer, 
+        return osd_update_audio_stream(m_game, &(this->machine()), buffer, 
                                        samples_this_frame);
     }
 
+	virtual void update_audio_stream_float(const float *buffer, int channels,
+                                           int samples_this_frame)
+    {
+        return osd_update_audio_stream_float(m_game, &(this->machine()),
+                                             buffer, channels,
+                                             samples_this_frame);
+    }
+
 	virtual void set_mastervolume(int attenuation)
     {
-        return osd_set_mastervolume(attenuation);
+        return osd_set_mastervolume(m_game, attenuation);
     }
 
 	virtual void customize_input_type_list(simple_list<input_type_entry> &typelist)
     {
-        return osd_customize_input_type_list(typelist);
+        return osd_customize_input_type_list(m_game, typelist);
+    }
+
+    LibMame_RunningGame *game() const
+    {
+        return m_game;
     }
+
+private:
+
+    /**
+     * This is the running game that this osd interface is running; every
+     * running game has its own osd interface.
+     **/
+    LibMame_RunningGame *m_game;
 };
 
 
@@ -144,11 +179,27 @@ typedef struct libmame_input_descriptor
 } libmame_input_descriptor;
 
 
+/**
+ * A sample of the scheduler and device counters of a running machine, taken
+ * at the end of a frame, from which per-frame statistics are computed
+ **/
+typedef struct libmame_stats_sample
+{
+    osd_ticks_t ticks;
+    attotime time;
+    UINT64 timeslices;
+    UINT64 timers_fired;
+    UINT64 device_cycles[LibMame_StatsDeviceMax];
+} libmame_stats_sample;
+
+
 /**
  * This encapsulates all of the state that LibMame keeps track of during
- * LibMame_RunGame().
+ * LibMame_RunGame().  Each call to LibMame_RunGame() has its own instance of
+ * this structure, and the address of that instance is the
+ * LibMame_RunningGame handle that is passed to the StartingUp callback.
  **/
-typedef struct LibMame_RunGame_State
+struct LibMame_RunningGame
 {
     /**
      * These are the callbacks that were provided to LibMame_RunGame.
@@ -203,14 +254,82 @@ typedef struct LibMame_RunGame_State
      **/
     astring speed_text;
 
-    // More MAME incredible C++ lameness.  Seriously MAME's C++ is the worst
-    // C++ I have ever seen.  Totally unmaintainable.
-    void output_callback(const char *format, va_list args)
-    {
-        (*(callbacks->StatusText))(format, args, callback_data);
-    }
+    /**
+     * If non-NULL, the caller-owned framebuffer that frames are rendered
+     * into, as set by LibMame_RunningGame_SetFramebuffer()
+     **/
+    void *framebuffer;
+    LibMame_FramebufferFormat framebuffer_format;
+    int framebuffer_width, framebuffer_height, framebuffer_pitch;
 
-} LibMame_RunGame_State;
+    /**
+     * The work queue that framebuffer rendering is spread across, for as
+     * long as the current machine runs
+     **/
+    osd_work_queue *render_queue;
+
+    /**
+     * If non-NULL, the callback that screen frames are reported to, as set
+     * by LibMame_RunningGame_SetScreenBitmapCallback()
+     **/
+    LibMame_ScreenBitmapCallback screen_bitmap_callback;
+
+    /**
+     * Has screen_frame_callback been registered with the screens of the
+     * current machine?
+     **/
+    bool screen_frame_callbacks_registered;
+
+    /**
+     * If non-NULL, the ring that audio is pushed into instead of being passed
+     * to UpdateAudio, as set by LibMame_RunningGame_SetAudioRing()
+     **/
+    LibMame_AudioRing *audio_ring;
+
+    /**
+     * The number of frames the current machine has completed, and samples
+     * of its counters taken at the end of the last two of them, which
+     * LibMame_RunningGame_GetStats() reports the difference between
+     **/
+    UINT64 stats_frames;
+    libmame_stats_sample stats_last, stats_previous;
+
+    /**
+     * Is this game being stepped one frame at a time by
+     * LibMame_RunningGame_RunFrame(), rather than run freely by
+     * LibMame_RunGame()?
+     **/
+    bool stepping;
+
+    /**
+     * The remaining fields are only used by stepped games, which run on
+     * their own thread.  That thread only ever runs while the thread that
+     * called LibMame_StartGame() or LibMame_RunningGame_RunFrame() waits for
+     * it, so the two never touch the game at the same time.
+     **/
+    LibMame_RunGameOptions options;
+    pthread_t thread;
+    pthread_mutex_t step_mutex;
+    pthread_cond_t step_cond;
+
+    /**
+     * Set by the caller to let the game thread run to the end of the next
+     * frame, and cleared by the game thread when it gets there
+     **/
+    bool step_requested;
+
+    /**
+     * Set by LibMame_FinishGame() so that the game thread stops waiting at
+     * frame boundaries while it runs to completion
+     **/
+    bool step_finishing;
+
+    /**
+     * Set by the game thread once the game has exited, along with its status
+     **/
+    bool step_finished;
+    LibMame_RunGameStatus step_status;
+};
 
 
 /** **************************************************************************
@@ -499,16 +618,95 @@ static int g_input_descriptor_count =
     (sizeof(g_input_descriptors) / sizeof(g_input_descriptors[0]));
 
 /**
- * This global is unfortunate but necessary.  If MAME is enhanced to
- * support callback data in its callbacks, then it will be unnecessary.
+ * MAME's output channels are process-wide, so they are pointed once at a
+ * single callback which forwards the output to the StatusText callback of
+ * whichever running game is executing on the calling thread.  This key
+ * holds that running game for each thread that is running a game.
+ **/
+static pthread_key_t g_running_game_key;
+static pthread_once_t g_running_game_once = PTHREAD_ONCE_INIT;
+
+/**
+ * The MAME engine keeps the running machine and other state in process-wide
+ * variables, so only one game may run at a time.  This is nonzero while a
+ * game started by LibMame_RunGame() or LibMame_StartGame() is running.
  **/
-static LibMame_RunGame_State g_state;
+static volatile int g_game_running;
 
 
 /** **************************************************************************
  * Static helper functions
  ************************************************************************** **/
 
+/**
+ * Claims the right to run a game, returning false if another game is
+ * already running
+ **/
+static bool claim_game()
+{
+    return __sync_bool_compare_and_swap(&g_game_running, 0, 1);
+}
+
+
+/**
+ * Gives up the right to run a game, once the game that claimed it is done.
+ * The profiler is process-wide too, so it is turned off here rather than
+ * left running, with the finished game's totals, for the next game.
+ **/
+static void release_game()
+{
+    g_profiler.enable(false);
+    __sync_lock_release(&g_game_running);
+}
+
+
+/**
+ * Returns the running game that the given machine was created for.  Every
+ * machine created by LibMame_RunGame() uses a libmame_rungame_osd_interface.
+ **/
+static LibMame_RunningGame *get_running_game(running_machine &machine)
+{
+    return ((libmame_rungame_osd_interface &) machine.osd()).game();
+}
+
+
+/**
+ * This is the callback that all MAME output channels are directed to.  It
+ * forwards the output to the running game on the current thread, if any.
+ **/
+static void output_callback(LibMame_RunningGame *, const char *format,
+                            va_list args)
+{
+    LibMame_RunningGame *game = 
+        (LibMame_RunningGame *) pthread_getspecific(g_running_game_key);
+
+    if (game) {
+        (*(game->callbacks->StatusText))(format, args, game->callback_data);
+    }
+}
+
+
+/**
+ * Called exactly once, before the first game is run, to set up the
+ * thread-specific running game key and to set up MAME's "output channels"
+ * so that we accumulate it all in a buffer rather than dumping it to
+ * stdout/stderr/wherever
+ **/
+static void initialize_running_game_key()
+{
+    pthread_key_create(&g_running_game_key, NULL);
+
+    output_delegate output(FUNC(output_callback), (LibMame_RunningGame *) 0);
+
+    mame_set_output_channel(OUTPUT_CHANNEL_ERROR, output);
+    mame_set_output_channel(OUTPUT_CHANNEL_WARNING, output);
+    mame_set_output_channel(OUTPUT_CHANNEL_INFO, output);
+    mame_set_output_channel(OUTPUT_CHANNEL_DEBUG, output);
+    mame_set_output_channel(OUTPUT_CHANNEL_VERBOSE, output);
+    mame_set_output_channel(OUTPUT_CHANNEL_LOG, output);
+}
+
+
 /**
  * This is the callback we hook up to the input device that MAME uses
  * to be called back to get the state of a controller input.  We also
@@ -516,8 +714,9 @@ static LibMame_RunGame_State g_state;
  * what bit of state is being asked about; this one function handles all of
  * the input for all controller types.
  **/
-static INT32 get_controller_state(void *, void *data)
+static INT32 get_controller_state(void *device_internal, void *data)
 {
+    LibMame_RunningGame *game = (LibMame_RunningGame *) device_internal;
     int player = CBDATA_PLAYER(data);
     int index = CBDATA_IPT(data);
 
@@ -531,9 +730,9 @@ static INT32 get_controller_state(void *, void *data)
 
     /* Just in case we need these */
     LibMame_PerPlayerControlsState *perplayer_state =
-        &(g_state.controls_state.per_player[player]);
+        &(game->controls_state.per_player[player]);
     LibMame_SharedControlsState *shared_state =
-        &(g_state.controls_state.shared);
+        &(game->controls_state.shared);
 
     /* MAME defines input ranges from -65536 to +65536 inclusive.  This is 17
        bits which is cumbersome.  So libmame allows ranges of -65535 to
@@ -612,12 +811,14 @@ static INT32 get_controller_state(void *, void *data)
  * what bit of state is being asked about; this one function handles all of
  * the input for all special inputs.
  **/
-static INT32 get_special_state(void *, void *data)
+static INT32 get_special_state(void *device_internal, void *data)
 {
+    LibMame_RunningGame *game = (LibMame_RunningGame *) device_internal;
+
     int special_button_index = (long) (uintptr_t) data;
 
     LibMame_SharedControlsState *shared_state =
-        &(g_state.controls_state.shared);
+        &(game->controls_state.shared);
 
     return shared_state->special_buttons_state & (1 << special_button_index);
 }
@@ -753,21 +954,229 @@ static bool controllers_have_input
 }
 
 
+/**
+ * Composes the primitives of a frame into the game's framebuffer using
+ * MAME's software renderer, split into bands that are rendered on the
+ * render queue.  The renderer only touches pixels covered by primitives, so
+ * the framebuffer is cleared first.
+ **/
+static void render_framebuffer(LibMame_RunningGame *game,
+                               const render_primitive_list &list)
+{
+    int bytes_per_pixel =
+        (game->framebuffer_format == LibMame_FramebufferFormat_RGB565) ? 2 : 4;
+
+    for (int y = 0; y < game->framebuffer_height; y++) {
+        memset(((UINT8 *) game->framebuffer) + 
+               (y * game->framebuffer_pitch * bytes_per_pixel), 0,
+               game->framebuffer_width * bytes_per_pixel);
+    }
+
+    switch (game->framebuffer_format) {
+    case LibMame_FramebufferFormat_ARGB32:
+        software_renderer<UINT32, 0,0,0, 16,8,0>::draw_primitives
+            (list, game->framebuffer, game->framebuffer_width,
+             game->framebuffer_height, game->framebuffer_pitch,
+             game->render_queue);
+        break;
+    case LibMame_FramebufferFormat_RGB565:
+        software_renderer<UINT16, 3,2,3, 11,5,0>::draw_primitives
+            (list, game->framebuffer, game->framebuffer_width,
+             game->framebuffer_height, game->framebuffer_pitch,
+             game->render_queue);
+        break;
+    }
+}
+
+
+/**
+ * Called by each screen of the machine when it completes a new frame, to
+ * forward the frame to the screen bitmap callback
+ **/
+static void screen_frame_callback(LibMame_RunningGame *game,
+                                  screen_device &screen)
+{
+    if (!game->screen_bitmap_callback) {
+        return;
+    }
+
+    screen_bitmap &bitmap = screen.frame_bitmap();
+    const rectangle &visarea = screen.visible_area();
+    screen_device_iterator iter(game->machine->root_device());
+
+    LibMame_ScreenBitmap info;
+    info.screen = iter.indexof(screen);
+    info.frame_number = game->machine->primary_screen->frame_number();
+    info.pixels = ((bitmap_t &) bitmap).raw_pixptr(0);
+    info.width = bitmap.width();
+    info.height = bitmap.height();
+    info.pitch = bitmap.rowpixels();
+    info.visible_area.min_x = visarea.min_x;
+    info.visible_area.max_x = visarea.max_x;
+    info.visible_area.min_y = visarea.min_y;
+    info.visible_area.max_y = visarea.max_y;
+    info.dirty_rows = screen.frame_dirty_rows();
+
+    if (bitmap.format() == BITMAP_FORMAT_IND16) {
+        info.format = LibMame_ScreenBitmapFormat_Indexed16;
+        info.palette = bitmap.palette() ?
+            palette_entry_list_adjusted(bitmap.palette()) : 0;
+        info.palette_size = bitmap.palette() ?
+            palette_get_max_index(bitmap.palette()) : 0;
+    }
+    else {
+        info.format = LibMame_ScreenBitmapFormat_RGB32;
+        info.palette = 0;
+        info.palette_size = 0;
+    }
+
+    (*(game->screen_bitmap_callback))(&info, game->callback_data);
+}
+
+
+/**
+ * Registers screen_frame_callback with every screen of the machine, the
+ * first time a screen bitmap callback is installed for it
+ **/
+static void register_screen_frame_callbacks(LibMame_RunningGame *game)
+{
+    if (game->screen_frame_callbacks_registered) {
+        return;
+    }
+
+    game->screen_frame_callbacks_registered = true;
+
+    screen_device_iterator iter(game->machine->root_device());
+    for (screen_device *screen = iter.first(); screen != NULL;
+         screen = iter.next()) {
+        screen->register_frame_callback
+            (screen_frame_delegate(FUNC(screen_frame_callback), game));
+    }
+}
+
+
+/**
+ * Unregisters screen_frame_callback from every screen of the machine, once
+ * the screen bitmap callback is cleared, so that the screens stop
+ * computing dirty rows for it
+ **/
+static void unregister_screen_frame_callbacks(LibMame_RunningGame *game)
+{
+    if (!game->screen_frame_callbacks_registered) {
+        return;
+    }
+
+    game->screen_frame_callbacks_registered = false;
+
+    screen_device_iterator iter(game->machine->root_device());
+    for (screen_device *screen = iter.first(); screen != NULL;
+         screen = iter.next()) {
+        screen->unregister_frame_callback
+            (screen_frame_delegate(FUNC(screen_frame_callback), game));
+    }
+}
+
+
+/**
+ * Samples the counters of the game's machine into [sample]
+ **/
+static void take_stats_sample(LibMame_RunningGame *game,
+                              libmame_stats_sample *sample)
+{
+    running_machine *machine = game->machine;
+
+    sample->ticks = osd_ticks();
+    sample->time = machine->time();
+    sample->timeslices = machine->scheduler().timeslices();
+    sample->timers_fired = machine->scheduler().timers_fired();
+
+    execute_interface_iterator iter(machine->root_device());
+    int index = 0;
+    for (device_execute_interface *exec = iter.first();
+         (exec != NULL) && (index < LibMame_StatsDeviceMax);
+         exec = iter.next(), index++) {
+        sample->device_cycles[index] = exec->total_cycles();
+    }
+}
+
+
+/**
+ * Returns the address space numbered [space] of the device tagged [tag], or
+ * NULL if there is no such device or it has no such space
+ **/
+static address_space *find_address_space(LibMame_RunningGame *game,
+                                         const char *tag, int space)
+{
+    if ((tag == NULL) || (space < 0) || (space >= ADDRESS_SPACES)) {
+        return NULL;
+    }
+
+    device_t *device = game->machine->device(tag);
+    device_memory_interface *memory;
+    if ((device == NULL) || !device->get_interface(memory)) {
+        return NULL;
+    }
+
+    return memory->space(space);
+}
+
+
+/**
+ * Called by the thread running a stepped game at the end of every frame.
+ * Tells the caller of LibMame_RunningGame_RunFrame() that the frame is done,
+ * and then waits until the next frame is requested.
+ **/
+static void wait_for_step_request(LibMame_RunningGame *game)
+{
+    pthread_mutex_lock(&(game->step_mutex));
+
+    game->step_requested = false;
+    pthread_cond_broadcast(&(game->step_cond));
+
+    while (!game->step_requested && !game->step_finishing) {
+        pthread_cond_wait(&(game->step_cond), &(game->step_mutex));
+    }
+
+    pthread_mutex_unlock(&(game->step_mutex));
+}
+
+
+/**
+ * Called by the thread that is stepping a game to let the game thread run,
+ * and then wait until it reaches the end of the next frame or exits.
+ **/
+static void run_until_step_complete(LibMame_RunningGame *game)
+{
+    pthread_mutex_lock(&(game->step_mutex));
+
+    game->step_requested = true;
+    pthread_cond_broadcast(&(game->step_cond));
+
+    while (game->step_requested && !game->step_finished) {
+        pthread_cond_wait(&(game->step_cond), &(game->step_mutex));
+    }
+
+    pthread_mutex_unlock(&(game->step_mutex));
+}
+
+
 static void startup_callback(running_machine &machine)
 {
+    LibMame_RunningGame *game = get_running_game(machine);
+
     /**
      * If the special input ports have not been configured yet, do so now.
      * This is the earliest opportunity we have to do this, which must be done
      * after osd_customize_input_type_list.
      **/
-    if (!g_state.special_inputs_configured) {
-        g_state.special_inputs_configured = true;
+    if (!game->special_inputs_configured) {
+        game->special_inputs_configured = true;
         input_device *keyboard = 0;
         input_item_id keyboard_item = ITEM_ID_A;
         int keyboard_count = 0;
         int special_button_index = 0;
 
-        ioport_manager &man = g_state.machine->ioport();
+        ioport_manager &man = game->machine->ioport();
 
         for (ioport_port *port = man.first_port(); port != NULL;
              port = port->next()) {
@@ -795,7 +1204,7 @@ static void startup_callback(running_machine &machine)
                              "libmame_virtual_special_keyboard_%d", 
                              keyboard_count++);
                     keyboard = machine.input().device_class
-                        (DEVICE_CLASS_KEYBOARD).add_device(namebuf);
+                        (DEVICE_CLASS_KEYBOARD).add_device(namebuf, game);
                     keyboard_item = ITEM_ID_A;
                 }
                 input_code item_input_code = 
@@ -835,19 +1244,19 @@ static void startup_callback(running_machine &machine)
         return;
     }
 
-    /* Currently, only one running game at a time is supported, so just pass
-       in a bogus value */
-    (*(g_state.callbacks->StartingUp))
-        (phase, machine.init_phase_percent_complete(), 
-         (LibMame_RunningGame *) 0x1, g_state.callback_data);
+    (*(game->callbacks->StartingUp))
+        (phase, machine.init_phase_percent_complete(), game,
+         game->callback_data);
 }
 
 
 static void pause_callback(running_machine &machine)
 {
-    if (g_state.waiting_for_pause) {
-        g_state.waiting_for_pause = false;
-        (*(g_state.callbacks->Paused))(g_state.callback_data);
+    LibMame_RunningGame *game = get_running_game(machine);
+
+    if (game->waiting_for_pause) {
+        game->waiting_for_pause = false;
+        (*(game->callbacks->Paused))(game->callback_data);
         /* Unpause */
         machine.resume();
     }
@@ -855,6 +1264,21 @@ static void pause_callback(running_machine &machine)
 }
 
 
+/**
+ * Called when a machine exits, to release what was allocated for it in
+ * osd_init
+ **/
+static void exit_callback(running_machine &machine)
+{
+    LibMame_RunningGame *game = get_running_game(machine);
+
+    if (game->render_queue) {
+        osd_work_queue_free(game->render_queue);
+        game->render_queue = 0;
+    }
+}
+
+
 static void set_configuration_value(LibMame_RunningGame *game,
                                     const char *tag, uint32_t mask,
                                     int value)
@@ -863,7 +1287,7 @@ static void set_configuration_value(LibMame_RunningGame *game,
     // This no longer works; the whole dipswitch/coniguration thing needs
     // to be redone as per other comments
     
-    ioport_manager &manager = g_state.machine->ioport();
+    ioport_manager &manager = game->machine->ioport();
 
     for (ioport_port *ioport = manager.first_port(); ioport;
          ioport = ioport->next()) {
@@ -903,29 +1327,52 @@ static void look_up_and_set_configuration_value(LibMame_RunningGame *game,
  * libmame OSD function implementations
  ************************************************************************** **/
 
-static void osd_init(running_machine *machine)
+static void osd_init(LibMame_RunningGame *game, running_machine *machine)
 {
     /**
      *  Save away the machine, we'll need it in osd_customize_input_type_list
      **/
-    g_state.machine = machine;
+    game->machine = machine;
     
     /**
      * Create the render_target that tells MAME the rendering parameters it
      * will use.
      **/
-    g_state.target = g_state.machine->render().target_alloc();
+    game->target = game->machine->render().target_alloc();
 
     /**
      * Have this target hold every view since we only support one target
      **/
-    g_state.target->set_view(g_state.target->configured_view("auto", 0, 1));
+    game->target->set_view(game->target->configured_view("auto", 0, 1));
 
     /**
      * Set render target bounds to 10000 x 10000 and allow the callback to
-     * scale that to whatever they want.
+     * scale that to whatever they want, unless frames are being rendered into
+     * a framebuffer, in which case they are rendered at its size.
+     **/
+    if (game->framebuffer) {
+        game->target->set_bounds(game->framebuffer_width,
+                                 game->framebuffer_height, 1.0);
+    }
+    else {
+        game->target->set_bounds(10000, 10000, 1.0);
+    }
+
+    /**
+     * This is a new machine, so if screen bitmaps are being reported, its
+     * screens need to be told to report them
+     **/
+    game->screen_frame_callbacks_registered = false;
+    if (game->screen_bitmap_callback) {
+        register_screen_frame_callbacks(game);
+    }
+
+    /**
+     * Statistics start over with each new machine
      **/
-    g_state.target->set_bounds(10000, 10000, 1.0);
+    game->stats_frames = 0;
+    take_stats_sample(game, &(game->stats_last));
+    game->stats_previous = game->stats_last;
 
     /* Add a startup callback so that we can forward this info to users */
     machine->add_notifier(MACHINE_NOTIFY_STARTUP, 
@@ -935,22 +1382,34 @@ static void osd_init(running_machine *machine)
     /* Add a callback so that we can know when the running game has paused */
     machine->add_notifier(MACHINE_NOTIFY_PAUSE, machine_notify_delegate
                           (FUNC(pause_callback), machine));
+
+    /**
+     * Framebuffer rendering is spread across all of the processors; the
+     * queue lives as long as the machine does
+     **/
+    game->render_queue = osd_work_queue_alloc(WORK_QUEUE_FLAG_MULTI);
+    machine->add_notifier(MACHINE_NOTIFY_EXIT, machine_notify_delegate
+                          (FUNC(exit_callback), machine));
 }
 
 
-static void osd_update(running_machine *machine, int skip_redraw)
+static void osd_update(LibMame_RunningGame *game, running_machine *machine,
+                       int skip_redraw)
 {
     /**
-     * Poll input
+     * Poll input, unless this is a stepped game, in which case the input
+     * for the next frame comes from LibMame_RunningGame_RunFrame()
      **/
-    memset(g_state.controls_state.per_player, 0, 
-           sizeof(LibMame_PerPlayerControlsState) * 
-           g_state.maximum_player_count);
-    g_state.controls_state.shared.shared_buttons_state = 0;
-    g_state.controls_state.shared.ui_input_state = 0;
-
-    (*(g_state.callbacks->PollAllControlsState))
-        (&(g_state.controls_state), g_state.callback_data);
+    if (!game->stepping) {
+        memset(game->controls_state.per_player, 0, 
+               sizeof(LibMame_PerPlayerControlsState) * 
+               game->maximum_player_count);
+        game->controls_state.shared.shared_buttons_state = 0;
+        game->controls_state.shared.ui_input_state = 0;
+
+        (*(game->callbacks->PollAllControlsState))
+            (&(game->controls_state), game->callback_data);
+    }
 
     /**
      * Ask the callbacks to update the video.  For now, assume that there
@@ -958,39 +1417,97 @@ static void osd_update(running_machine *machine, int skip_redraw)
      * future.
      **/
     if (!skip_redraw) {
-        render_primitive_list &list = g_state.target->get_primitives();
+        render_primitive_list &list = game->target->get_primitives();
         list.acquire_lock();
-        (*(g_state.callbacks->UpdateVideo))
-            ((LibMame_RenderPrimitive *) list.first(), g_state.callback_data);
+        if (game->framebuffer) {
+            render_framebuffer(game, list);
+            (*(game->callbacks->UpdateVideo))(0, game->callback_data);
+        }
+        else {
+            (*(game->callbacks->UpdateVideo))
+                ((LibMame_RenderPrimitive *) list.first(),
+                 game->callback_data);
+        }
         list.release_lock();
     }
 
+    /**
+     * The frame's emulation is done; sample the counters so that its
+     * statistics are available to the calls about to be made
+     **/
+    game->stats_frames++;
+    game->stats_previous = game->stats_last;
+    take_stats_sample(game, &(game->stats_last));
+
     /**
      * Give the callbacks a chance to make running game calls
      **/
-    (*(g_state.callbacks->MakeRunningGameCalls))(g_state.callback_data);
+    (*(game->callbacks->MakeRunningGameCalls))(game->callback_data);
+
+    /**
+     * This is the end of a frame; a stepped game waits here for the next
+     * LibMame_RunningGame_RunFrame() call.  The controls state it supplies
+     * is picked up by MAME's input polling immediately after this returns.
+     **/
+    if (game->stepping) {
+        wait_for_step_request(game);
+    }
 }
 
 
-static void osd_update_audio_stream(running_machine *machine, 
+static void osd_update_audio_stream(LibMame_RunningGame *game,
+                                    running_machine *machine, 
                                     const INT16 *buffer,
                                     int samples_this_frame)
 {
     /**
-     * Ask the callbacks to update the audio
+     * If there is an audio ring, push the audio into it, stamped with the
+     * emulated time of its first frame, which is the current time less the
+     * duration of the audio
+     **/
+    if (game->audio_ring && (machine->sample_rate() > 0)) {
+        attotime now = machine->time();
+        uint64_t now_ns = (((uint64_t) now.seconds) * 1000000000ULL) +
+            (now.attoseconds / ATTOSECONDS_PER_NANOSECOND);
+        uint64_t duration_ns = (((uint64_t) samples_this_frame) *
+                                1000000000ULL) / machine->sample_rate();
+        libmame_audio_ring_push(game->audio_ring, machine->sample_rate(),
+                                buffer, samples_this_frame,
+                                (now_ns > duration_ns) ?
+                                (now_ns - duration_ns) : 0);
+        return;
+    }
+
+    /**
+     * Otherwise, ask the callbacks to update the audio
      **/
-    (*(g_state.callbacks->UpdateAudio))(machine->sample_rate(), 
-                                        samples_this_frame,
-                                        buffer, g_state.callback_data);
+    (*(game->callbacks->UpdateAudio))(machine->sample_rate(), 
+                                      samples_this_frame,
+                                      buffer, game->callback_data);
 }
 
 
-static void osd_set_mastervolume(int attenuation)
+static void osd_update_audio_stream_float(LibMame_RunningGame *game,
+                                          running_machine *machine,
+                                          const float *buffer, int channels,
+                                          int samples_this_frame)
+{
+    /**
+     * Ask the callbacks to update the audio; this is only called when the
+     * audio_format option asks for floating point audio
+     **/
+    (*(game->callbacks->UpdateAudioFloat))(machine->sample_rate(), channels,
+                                           samples_this_frame, buffer,
+                                           game->callback_data);
+}
+
+
+static void osd_set_mastervolume(LibMame_RunningGame *game, int attenuation)
 {
     /**
      * Ask the callbacks to set the master volume
      **/
-    (*(g_state.callbacks->SetMasterVolume))(attenuation, g_state.callback_data);
+    (*(game->callbacks->SetMasterVolume))(attenuation, game->callback_data);
 }
 
 
@@ -1002,13 +1519,14 @@ static void osd_set_mastervolume(int attenuation)
  * the current game, and for the others, make our own custom controllers as
  * neceessary to provide the inputs, and hook the input callbacks up to fetch
  * the input state from the one single LibMame_AllControlsState structure
- * that we store in the g_state object.  In this way, we completely hardwire
+ * that we store in the running game.  In this way, we completely hardwire
  * the way that MAME handles input so that the users of libmame can do
  * whatever they want to satisfy getting inputs for the various controllers
  * types.
  **/
 static void
-osd_customize_input_type_list(simple_list<input_type_entry> &typelist)
+osd_customize_input_type_list(LibMame_RunningGame *game,
+                              simple_list<input_type_entry> &typelist)
 {
     /**
      * For each input descriptor, create a keyboard key, or mouse axis, or
@@ -1057,8 +1575,8 @@ osd_customize_input_type_list(simple_list<input_type_entry> &typelist)
             snprintf(namebuf, sizeof(namebuf),                          \
                      "libmame_virtual_" #devices "_%d",                 \
                      entry->player());                                  \
-            devices [entry->player()] = g_state.machine->input().       \
-                device_class(deviceclass).add_device(namebuf);          \
+            devices [entry->player()] = game->machine->input().         \
+                device_class(deviceclass).add_device(namebuf, game);    \
         }                                                               \
         item_device = devices [entry->player()];                        \
         item_id = g_input_descriptors[entry->type()].item_id;           \
@@ -1082,8 +1600,8 @@ osd_customize_input_type_list(simple_list<input_type_entry> &typelist)
             // crash assert or something - otherwise, the input gets ignored
             continue;
         }
-        if (controllers_have_input(g_state.maximum_player_count,
-                                   &(g_state.controllers),
+        if (controllers_have_input(game->maximum_player_count,
+                                   &(game->controllers),
                                    entry->player(), index)) {
             switch (g_input_descriptors[entry->type()].type) {
             case libmame_input_type_invalid:
@@ -1100,8 +1618,8 @@ osd_customize_input_type_list(simple_list<input_type_entry> &typelist)
                 if (!keyboard || (keyboard_item > ITEM_ID_Z)) {
                     snprintf(namebuf, sizeof(namebuf), 
                              "libmame_virtual_keyboard_%d", keyboard_count++);
-                    keyboard = g_state.machine->input().device_class
-                        (DEVICE_CLASS_KEYBOARD).add_device(namebuf);
+                    keyboard = game->machine->input().device_class
+                        (DEVICE_CLASS_KEYBOARD).add_device(namebuf, game);
                     keyboard_item = ITEM_ID_A;
                 }
                 item_device = keyboard;
@@ -1193,44 +1711,60 @@ osd_customize_input_type_list(simple_list<input_type_entry> &typelist)
 
 
 /** **************************************************************************
- * LibMame exported function implementations
+ * Running game helper functions
  ************************************************************************** **/
 
-LibMame_RunGameStatus LibMame_RunGame(int gamenum, int benchmarking,
-                                      const LibMame_RunGameOptions *options,
-                                      const LibMame_RunGameCallbacks *cbs,
-                                      void *callback_data)
+/**
+ * Sets up a running game to run the given game with the given callbacks
+ **/
+static void initialize_running_game(LibMame_RunningGame *game, int gamenum,
+                                    const LibMame_RunGameCallbacks *cbs,
+                                    void *callback_data)
 {
-    if (gamenum >= LibMame_Get_Game_Count()) {
-        return LibMame_RunGameStatus_InvalidGameNum;
-    }
-
-#define MAME_LAMENESS \
-    output_delegate(FUNC(LibMame_RunGame_State::output_callback), &g_state)
-
-    /* Set up MAME's "output channels" so that we accumulate it all in a
-       buffer rather than dumping it to stdout/stderr/wherever */
-    mame_set_output_channel(OUTPUT_CHANNEL_ERROR, MAME_LAMENESS);
-    mame_set_output_channel(OUTPUT_CHANNEL_WARNING, MAME_LAMENESS);
-    mame_set_output_channel(OUTPUT_CHANNEL_INFO, MAME_LAMENESS);
-    mame_set_output_channel(OUTPUT_CHANNEL_DEBUG, MAME_LAMENESS);
-    mame_set_output_channel(OUTPUT_CHANNEL_VERBOSE, MAME_LAMENESS);
-    mame_set_output_channel(OUTPUT_CHANNEL_LOG, MAME_LAMENESS);
-
-    /* Set the unfortunate globals.  Would greatly prefer to allocate a
-       new one of these and pass it to MAME, having it pass it back in the
-       osd_ callbacks. */
-    g_state.callbacks = cbs;
-    g_state.callback_data = callback_data;
+    game->callbacks = cbs;
+    game->callback_data = callback_data;
 
     /* Save the game number */
-    g_state.gamenum = gamenum;
+    game->gamenum = gamenum;
 
     /* Look up the game number of players and controllers */
-    g_state.maximum_player_count =
+    game->maximum_player_count =
         LibMame_Get_Game_MaxSimultaneousPlayers(gamenum);
-    g_state.controllers = LibMame_Get_Game_AllControllers(gamenum);
+    game->controllers = LibMame_Get_Game_AllControllers(gamenum);
+
+    /* Haven't configured special inputs yet */
+    game->special_inputs_configured = false;
+
+    /* Not waiting for a pause */
+    game->waiting_for_pause = false;
 
+    /* No machine or render target until osd_init */
+    game->machine = 0;
+    game->target = 0;
+
+    /* Pass primitive lists to UpdateVideo until told otherwise */
+    game->framebuffer = 0;
+    game->render_queue = 0;
+
+    /* Don't report screen bitmaps until told otherwise */
+    game->screen_bitmap_callback = 0;
+
+    /* Pass audio to UpdateAudio until told otherwise */
+    game->audio_ring = 0;
+
+    /* Run freely unless LibMame_StartGame says otherwise */
+    game->stepping = false;
+}
+
+
+/**
+ * Runs a game that has been set up by initialize_running_game() on the
+ * calling thread, until it exits
+ **/
+static LibMame_RunGameStatus run_game(LibMame_RunningGame *game,
+                                      int benchmarking,
+                                      const LibMame_RunGameOptions *options)
+{
     /* Set up options stuff for MAME.  If none were supplied, use the
        defaults. */
     emu_options mame_options;
@@ -1238,26 +1772,38 @@ LibMame_RunGameStatus LibMame_RunGame(int gamenum, int benchmarking,
         LibMame_RunGameOptions default_options;
         LibMame_Get_Default_RunGameOptions(&default_options);
         get_mame_options(&default_options,
-                         LibMame_Get_Game_Short_Name(gamenum), mame_options);
+                         LibMame_Get_Game_Short_Name(game->gamenum),
+                         mame_options);
     }
     else {
-        get_mame_options(options, LibMame_Get_Game_Short_Name(gamenum),
+        get_mame_options(options, LibMame_Get_Game_Short_Name(game->gamenum),
                          mame_options);
     }
 
-    /* Haven't configured special inputs yet */
-    g_state.special_inputs_configured = false;
+    /* A stepped game runs exactly as fast as it is stepped, so never
+       throttle or skip frames */
+    if (game->stepping) {
+        astring errorstring;
+        (void) mame_options.set_value(OPTION_THROTTLE, (int) false,
+                                      OPTION_PRIORITY_MAXIMUM, errorstring);
+        (void) mame_options.set_value(OPTION_AUTOFRAMESKIP, (int) false,
+                                      OPTION_PRIORITY_MAXIMUM, errorstring);
+        (void) mame_options.set_value(OPTION_FRAMESKIP, 0,
+                                      OPTION_PRIORITY_MAXIMUM, errorstring);
+    }
 
-    /* Not waiting for a pause */
-    g_state.waiting_for_pause = false;
+    /* MAME output from this thread now goes to this game */
+    pthread_setspecific(g_running_game_key, game);
 
     /* Run the game */
     int result;
     {
-        libmame_rungame_osd_interface osd;
+        libmame_rungame_osd_interface osd(game);
         result = mame_execute(mame_options, osd, benchmarking ? true : false);
     }
 
+    pthread_setspecific(g_running_game_key, 0);
+
     /* Convert the resulting MAME code to a libmame code and return */
     switch (result) {
     case MAMERR_NONE:
@@ -1282,65 +1828,532 @@ LibMame_RunGameStatus LibMame_RunGame(int gamenum, int benchmarking,
 }
 
 
+/**
+ * This is the body of the thread that runs a stepped game
+ **/
+static void *stepped_game_thread(void *arg)
+{
+    LibMame_RunningGame *game = (LibMame_RunningGame *) arg;
+
+    LibMame_RunGameStatus status = run_game(game, 0, &(game->options));
+
+    pthread_mutex_lock(&(game->step_mutex));
+    game->step_status = status;
+    game->step_finished = true;
+    pthread_cond_broadcast(&(game->step_cond));
+    pthread_mutex_unlock(&(game->step_mutex));
+
+    return 0;
+}
+
+
+/**
+ * Releases everything associated with a stepped game whose thread has
+ * exited, and returns the status it exited with
+ **/
+static LibMame_RunGameStatus destroy_stepped_game(LibMame_RunningGame *game)
+{
+    pthread_join(game->thread, 0);
+
+    LibMame_RunGameStatus status = game->step_status;
+
+    pthread_cond_destroy(&(game->step_cond));
+    pthread_mutex_destroy(&(game->step_mutex));
+    delete game;
+
+    release_game();
+
+    return status;
+}
+
+
+/** **************************************************************************
+ * LibMame exported function implementations
+ ************************************************************************** **/
+
+LibMame_RunGameStatus LibMame_RunGame(int gamenum, int benchmarking,
+                                      const LibMame_RunGameOptions *options,
+                                      const LibMame_RunGameCallbacks *cbs,
+                                      void *callback_data)
+{
+    if (gamenum >= LibMame_Get_Game_Count()) {
+        return LibMame_RunGameStatus_InvalidGameNum;
+    }
+
+    /* Make sure that MAME's output will be routed to the running games */
+    pthread_once(&g_running_game_once, &initialize_running_game_key);
+
+    if (!claim_game()) {
+        return LibMame_RunGameStatus_GameAlreadyRunning;
+    }
+
+    /* All of the state of this running game lives here, for as long as the
+       game runs */
+    LibMame_RunningGame game;
+
+    initialize_running_game(&game, gamenum, cbs, callback_data);
+
+    LibMame_RunGameStatus status = run_game(&game, benchmarking, options);
+
+    release_game();
+
+    return status;
+}
+
+
+LibMame_RunGameStatus LibMame_StartGame(int gamenum,
+                                        const LibMame_RunGameOptions *options,
+                                        const LibMame_RunGameCallbacks *cbs,
+                                        void *callback_data,
+                                        LibMame_RunningGame **running_game)
+{
+    *running_game = 0;
+
+    if (gamenum >= LibMame_Get_Game_Count()) {
+        return LibMame_RunGameStatus_InvalidGameNum;
+    }
+
+    /* Make sure that MAME's output will be routed to the running games */
+    pthread_once(&g_running_game_once, &initialize_running_game_key);
+
+    /* The game stays running after this returns, until it is finished by
+       LibMame_FinishGame() */
+    if (!claim_game()) {
+        return LibMame_RunGameStatus_GameAlreadyRunning;
+    }
+
+    /* A stepped game outlives this call, so it lives on the heap, along
+       with its own copy of the options */
+    LibMame_RunningGame *game = new LibMame_RunningGame;
+
+    initialize_running_game(game, gamenum, cbs, callback_data);
+
+    if (options == NULL) {
+        LibMame_Get_Default_RunGameOptions(&(game->options));
+    }
+    else {
+        game->options = *options;
+    }
+
+    game->stepping = true;
+    memset(&(game->controls_state), 0, sizeof(game->controls_state));
+    pthread_mutex_init(&(game->step_mutex), 0);
+    pthread_cond_init(&(game->step_cond), 0);
+    game->step_requested = false;
+    game->step_finishing = false;
+    game->step_finished = false;
+    game->step_status = LibMame_RunGameStatus_GeneralError;
+
+    if (pthread_create(&(game->thread), 0, &stepped_game_thread, game)) {
+        pthread_cond_destroy(&(game->step_cond));
+        pthread_mutex_destroy(&(game->step_mutex));
+        delete game;
+        release_game();
+        return LibMame_RunGameStatus_GeneralError;
+    }
+
+    /* Let the game start up and run to the end of its first frame */
+    run_until_step_complete(game);
+
+    /* If it never got that far, it failed to start */
+    if (game->step_finished) {
+        return destroy_stepped_game(game);
+    }
+
+    *running_game = game;
+
+    return LibMame_RunGameStatus_Success;
+}
+
+
+int LibMame_RunningGame_RunFrame(LibMame_RunningGame *game,
+                                 const LibMame_AllControlsState *controls_state)
+{
+    if (game->step_finished) {
+        return 0;
+    }
+
+    /* The game thread is waiting at the end of a frame, so it is safe to
+       hand it the controls state for the next frame */
+    if (controls_state) {
+        game->controls_state = *controls_state;
+    }
+    else {
+        memset(&(game->controls_state), 0, sizeof(game->controls_state));
+    }
+
+    run_until_step_complete(game);
+
+    return game->step_finished ? 0 : 1;
+}
+
+
+LibMame_RunGameStatus LibMame_FinishGame(LibMame_RunningGame *game)
+{
+    /* If the game is still running, ask it to exit and then let it run
+       freely until it does */
+    if (!game->step_finished) {
+        game->machine->schedule_exit();
+
+        pthread_mutex_lock(&(game->step_mutex));
+        game->step_finishing = true;
+        pthread_cond_broadcast(&(game->step_cond));
+        pthread_mutex_unlock(&(game->step_mutex));
+    }
+
+    return destroy_stepped_game(game);
+}
+
+
 const char *LibMame_RunningGame_GetSpeedText(LibMame_RunningGame *game)
 {
-    (void) game;
+    game->machine->video().speed_text(game->speed_text);
 
-    g_state.machine->video().speed_text(g_state.speed_text);
+    return game->speed_text.cstr();
+}
+
+
+void LibMame_RunningGame_GetStats(LibMame_RunningGame *game,
+                                  LibMame_RunningGameStats *stats)
+{
+    running_machine *machine = game->machine;
+    const libmame_stats_sample *last = &(game->stats_last);
+    const libmame_stats_sample *previous = &(game->stats_previous);
+
+    memset(stats, 0, sizeof(*stats));
+
+    stats->frame_number = game->stats_frames;
+    attotime now = machine->time();
+    stats->emulated_time_ns = (((uint64_t) now.seconds) * 1000000000ULL) +
+        (now.attoseconds / ATTOSECONDS_PER_NANOSECOND);
+    attotime frame_time = last->time - previous->time;
+    stats->frame_emulated_time_ns =
+        (((uint64_t) frame_time.seconds) * 1000000000ULL) +
+        (frame_time.attoseconds / ATTOSECONDS_PER_NANOSECOND);
+    stats->frame_wall_time_ns = (uint64_t)
+        (((double) (last->ticks - previous->ticks)) * 1000000000.0 /
+         osd_ticks_per_second());
+    stats->speed_percent = machine->video().speed_percent() * 100.0;
+
+    stats->timeslices = machine->scheduler().timeslices();
+    stats->timeslices_last_frame = last->timeslices - previous->timeslices;
+    stats->timers_fired = machine->scheduler().timers_fired();
+    stats->timers_fired_last_frame =
+        last->timers_fired - previous->timers_fired;
+    if (stats->frame_emulated_time_ns > 0) {
+        stats->timers_fired_per_second =
+            ((double) stats->timers_fired_last_frame) * 1000000000.0 /
+            stats->frame_emulated_time_ns;
+    }
+
+    stats->profiler_enabled = g_profiler.enabled();
+
+    /**
+     * The profiler tracks each executing device under a type given by its
+     * index among the executing devices, which is also its index here
+     **/
+    execute_interface_iterator iter(machine->root_device());
+    for (device_execute_interface *exec = iter.first();
+         (exec != NULL) && (stats->device_count < LibMame_StatsDeviceMax);
+         exec = iter.next()) {
+        int index = stats->device_count++;
+        LibMame_DeviceStats *device = &(stats->devices[index]);
+        device->tag = exec->device().tag();
+        device->name = exec->device().name();
+        device->clock_hz = exec->device().clock();
+        device->suspended = exec->suspended();
+        device->cycles_executed = exec->total_cycles();
+        device->cycles_last_frame =
+            last->device_cycles[index] - previous->device_cycles[index];
+        device->profiler_ticks =
+            g_profiler.total(profile_type(PROFILER_DEVICE_FIRST + index));
+    }
 
-    return g_state.speed_text.cstr();
+    for (int type = PROFILER_DRC_COMPILE;
+         (type <= PROFILER_IDLE) &&
+         (stats->profiler_bucket_count < LibMame_StatsProfilerBucketMax);
+         type++) {
+        const char *name = profiler_type_name(profile_type(type));
+        if (name == NULL) {
+            continue;
+        }
+        LibMame_ProfilerBucket *bucket =
+            &(stats->profiler_buckets[stats->profiler_bucket_count++]);
+        bucket->name = name;
+        bucket->ticks = g_profiler.total(profile_type(type));
+    }
 }
 
 
-void LibMame_RunningGame_Schedule_Pause(LibMame_RunningGame *game)
+void LibMame_RunningGame_SetProfilerEnabled(LibMame_RunningGame *game,
+                                            int enabled)
 {
+    /**
+     * There is only one profiler, but claim_game() ensures that the game
+     * passed in is the only one running, so the profiler is its alone
+     **/
     (void) game;
 
-    g_state.waiting_for_pause = true;
+    g_profiler.enable(enabled != 0);
+}
+
+
+int LibMame_RunningGame_SetWriteTracking(LibMame_RunningGame *game,
+                                         const char *tag, int space,
+                                         int granularity_bits)
+{
+    address_space *as = find_address_space(game, tag, space);
+    if (as == NULL) {
+        return 0;
+    }
 
-    g_state.machine->pause();
+    if (granularity_bits == 0) {
+        as->disable_write_tracking();
+    }
+    else {
+        as->enable_write_tracking(granularity_bits);
+    }
+
+    return 1;
 }
 
 
-void LibMame_RunningGame_Schedule_Exit(LibMame_RunningGame *game)
+int LibMame_RunningGame_GetDirtyBitmap(LibMame_RunningGame *game,
+                                       const char *tag, int space,
+                                       LibMame_DirtyBitmap *bitmap)
 {
-    (void) game;
+    address_space *as = find_address_space(game, tag, space);
+    if ((as == NULL) || !as->write_tracking()) {
+        return 0;
+    }
+
+    bitmap->bits = as->dirty_bitmap();
+    bitmap->page_count = as->dirty_pages();
+    bitmap->granularity_bits = as->dirty_granularity();
 
-    g_state.machine->schedule_exit();
+    return 1;
 }
 
 
-void LibMame_RunningGame_Schedule_Hard_Reset(LibMame_RunningGame *game)
+int LibMame_RunningGame_ResetDirtyBitmap(LibMame_RunningGame *game,
+                                         const char *tag, int space)
 {
-    (void) game;
+    address_space *as = find_address_space(game, tag, space);
+    if ((as == NULL) || !as->write_tracking()) {
+        return 0;
+    }
 
-    g_state.machine->schedule_hard_reset();
+    as->reset_dirty();
+
+    return 1;
 }
 
 
-void LibMame_RunningGame_Schedule_Soft_Reset(LibMame_RunningGame *game)
+void LibMame_RunningGame_Schedule_Pause(LibMame_RunningGame *game)
 {
-    (void) game;
+    game->waiting_for_pause = true;
+
+    game->machine->pause();
+}
 
-    g_state.machine->schedule_soft_reset();
+
+void LibMame_RunningGame_Schedule_Exit(LibMame_RunningGame *game)
+{
+    game->machine->schedule_exit();
+}
+
+
+void LibMame_RunningGame_Schedule_Hard_Reset(LibMame_RunningGame *game)
+{
+    game->machine->schedule_hard_reset();
+}
+
+
+void LibMame_RunningGame_Schedule_Soft_Reset(LibMame_RunningGame *game)
+{
+    game->machine->schedule_soft_reset();
 }
 
 
 void LibMame_RunningGame_SaveState(LibMame_RunningGame *game, 
                                    const char *filename)
 {
-    (void) game;
-
-    g_state.machine->schedule_save(filename);
+    game->machine->schedule_save(filename);
 }
 
 
 void LibMame_RunningGame_LoadState(LibMame_RunningGame *game,
                                    const char *filename)
 {
-    (void) game;
+    game->machine->schedule_load(filename);
+}
+
 
-    g_state.machine->schedule_load(filename);
+uint32_t LibMame_RunningGame_GetStateSize(LibMame_RunningGame *game,
+                                          int compressed)
+{
+    save_manager &save = game->machine->save();
+
+    return compressed ? save.compressed_bound() : save.binary_size();
+}
+
+
+void LibMame_RunningGame_SaveStateToBuffer(LibMame_RunningGame *game,
+                                           void *buffer, uint32_t buffer_size,
+                                           int compress)
+{
+    game->machine->schedule_save(buffer, buffer_size, compress ? true : false);
+}
+
+
+void LibMame_RunningGame_LoadStateFromBuffer(LibMame_RunningGame *game,
+                                             const void *buffer,
+                                             uint32_t buffer_size)
+{
+    game->machine->schedule_load(buffer, buffer_size);
+}
+
+
+uint32_t LibMame_RunningGame_GetDeltaStateSize(LibMame_RunningGame *game)
+{
+    return game->machine->save().delta_bound();
+}
+
+
+void LibMame_RunningGame_SaveDeltaStateToBuffer(LibMame_RunningGame *game,
+                                                const void *base,
+                                                uint32_t base_size,
+                                                void *buffer,
+                                                uint32_t buffer_size)
+{
+    game->machine->schedule_save_delta(base, base_size, buffer, buffer_size);
+}
+
+
+void LibMame_RunningGame_LoadDeltaStateFromBuffer(LibMame_RunningGame *game,
+                                                  const void *base,
+                                                  uint32_t base_size,
+                                                  const void *buffer,
+                                                  uint32_t buffer_size)
+{
+    game->machine->schedule_load_delta(base, base_size, buffer, buffer_size);
+}
+
+
+LibMame_StateBufferStatus LibMame_RunningGame_GetStateBufferStatus
+    (LibMame_RunningGame *game, uint32_t *size)
+{
+    UINT32 actual;
+    save_error result = game->machine->saveload_buffer_result(actual);
+
+    if (size) {
+        *size = 0;
+    }
+
+    if (game->machine->save_or_load_pending()) {
+        return LibMame_StateBufferStatus_Pending;
+    }
+
+    switch (result) {
+    case STATERR_NONE:
+        if (size) {
+            *size = actual;
+        }
+        return LibMame_StateBufferStatus_Success;
+    case STATERR_ILLEGAL_REGISTRATIONS:
+        return LibMame_StateBufferStatus_NotSupported;
+    case STATERR_INVALID_HEADER:
+        return LibMame_StateBufferStatus_InvalidState;
+    case STATERR_WRITE_ERROR:
+        return LibMame_StateBufferStatus_BufferTooSmall;
+    case STATERR_NOT_REQUESTED:
+        return LibMame_StateBufferStatus_NotRequested;
+    case STATERR_PENDING:
+        return LibMame_StateBufferStatus_Pending;
+    case STATERR_CANCELLED:
+        return LibMame_StateBufferStatus_Cancelled;
+    case STATERR_READ_ERROR:
+        break;
+    }
+
+    return LibMame_StateBufferStatus_CorruptState;
+}
+
+
+int LibMame_RunningGame_Rewind(LibMame_RunningGame *game, int frames)
+{
+    rewind_manager &rewind = game->machine->rewind();
+
+    /* A failed restore disables rewinding, so it is reported here too */
+    if (!rewind.enabled() || (rewind.capture_count() == 0) || (frames <= 0)) {
+        return 0;
+    }
+
+    rewind.rewind(frames);
+
+    return 1;
+}
+
+
+int LibMame_RunningGame_SetFramebuffer(LibMame_RunningGame *game,
+                                       void *buffer,
+                                       LibMame_FramebufferFormat format,
+                                       int width, int height, int pitch)
+{
+    if (buffer) {
+        int bytes_per_pixel;
+        switch (format) {
+        case LibMame_FramebufferFormat_ARGB32:
+            bytes_per_pixel = 4;
+            break;
+        case LibMame_FramebufferFormat_RGB565:
+            bytes_per_pixel = 2;
+            break;
+        default:
+            return 0;
+        }
+        /* The renderer addresses the whole buffer with int offsets */
+        if ((width <= 0) || (height <= 0) || (pitch < width) ||
+            ((((INT64) pitch) * height * bytes_per_pixel) > 0x7FFFFFFF)) {
+            return 0;
+        }
+    }
+
+    game->framebuffer = buffer;
+    game->framebuffer_format = format;
+    game->framebuffer_width = width;
+    game->framebuffer_height = height;
+    game->framebuffer_pitch = pitch;
+
+    if (buffer) {
+        game->target->set_bounds(width, height, 1.0);
+    }
+    else {
+        game->target->set_bounds(10000, 10000, 1.0);
+    }
+
+    return 1;
+}
+
+
+void LibMame_RunningGame_SetScreenBitmapCallback
+    (LibMame_RunningGame *game, LibMame_ScreenBitmapCallback callback)
+{
+    game->screen_bitmap_callback = callback;
+
+    if (callback) {
+        register_screen_frame_callbacks(game);
+    }
+    else {
+        unregister_screen_frame_callbacks(game);
+    }
+}
+
+
+void LibMame_RunningGame_SetAudioRing(LibMame_RunningGame *game,
+                                      LibMame_AudioRing *ring)
+{
+    game->audio_ring = ring;
 }
 
 
@@ -1349,5 +2362,5 @@ void LibMame_RunningGame_ChangeDipswitchValue(LibMame_RunningGame *game,
                                               const char *value)
 {
     look_up_and_set_configuration_value
-        (game, g_state.gamenum, tag, mask, value);
+        (game, game->gamenum, tag, mask, value);
 }
@@ -196,6 +196,53 @@ file_error osd_read(osd_file *file, void *buffer, UINT64 offset, UINT32 length,
 file_error osd_write(osd_file *file, const void *buffer, UINT64 offset, UINT32 length, UINT32 *actual);
 
 
+/*-----------------------------------------------------------------------------
+    osd_map: map a range of an open file read-only into memory
+
+    Parameters:
+
+        file - handle to a file previously opened via osd_open
+
+        offset - offset within the file of the start of the range
+
+        length - number of bytes to map; the range must lie entirely
+            within the file
+
+        data - pointer to a pointer to receive the address of the mapped
+            data; valid only if the function returns FILERR_NONE
+
+    Return value:
+
+        a file_error describing any error that occurred while mapping the
+        file, or FILERR_NONE if no error occurred
+
+    Notes:
+
+        The mapping is shared and read-only, so that pages of the same file
+        mapped by several processes occupy physical memory only once.  It
+        remains valid after the file is closed, until it is released with
+        osd_unmap. Ports that cannot map files may simply return
+        FILERR_FAILURE, and callers must then fall back to osd_read.
+-----------------------------------------------------------------------------*/
+file_error osd_map(osd_file *file, UINT64 offset, UINT64 length, const void **data);
+
+
+/*-----------------------------------------------------------------------------
+    osd_unmap: release a mapping made by osd_map
+
+    Parameters:
+
+        data - address returned by osd_map
+
+        length - length originally passed to osd_map
+
+    Return value:
+
+        None
+-----------------------------------------------------------------------------*/
+void osd_unmap(const void *data, UINT64 length);
+
+
 /*-----------------------------------------------------------------------------
     osd_rmfile: deletes a file
 
@@ -162,6 +162,23 @@ void osd_interface::update_audio_stream(const INT16 *buffer, int samples_this_fr
 }
 
 
+//-------------------------------------------------
+//  update_audio_stream_float - update the
+//  floating-point audio stream
+//-------------------------------------------------
+
+void osd_interface::update_audio_stream_float(const float *buffer, int channels, int samples_this_frame)
+{
+	//
+	// This method is called instead of update_audio_stream when the
+	// audio_format option asks for floating-point output. It provides an
+	// array of unclipped samples, interleaved across the given number of
+	// channels, nominally in the range -1.0 to 1.0, which should be output
+	// at the configured sample_rate.
+	//
+}
+
+
 //-------------------------------------------------
 //  set_mastervolume - set the system volume
 //-------------------------------------------------
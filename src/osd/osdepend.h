@@ -81,6 +81,7 @@ public:
 
 	// audio overridables
 	virtual void update_audio_stream(const INT16 *buffer, int samples_this_frame);
+	virtual void update_audio_stream_float(const float *buffer, int channels, int samples_this_frame);
 	virtual void set_mastervolume(int attenuation);
 
 	// input overridables
@@ -134,6 +134,26 @@ file_error osd_write(osd_file *file, const void *buffer, UINT64 offset, UINT32 l
 }
 
 
+//============================================================
+//  osd_map
+//============================================================
+
+file_error osd_map(osd_file *file, UINT64 offset, UINT64 length, const void **data)
+{
+	// there is no standard way of doing this, so callers always fall back to osd_read
+	return FILERR_FAILURE;
+}
+
+
+//============================================================
+//  osd_unmap
+//============================================================
+
+void osd_unmap(const void *data, UINT64 length)
+{
+}
+
+
 //============================================================
 //  osd_rmfile
 //============================================================
@@ -11,6 +11,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#ifndef WINDOWS
+#include <sys/mman.h>
+#endif
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
@@ -292,6 +295,63 @@ file_error osd_write(osd_file *file, const void *buffer, UINT64 offset,
 }
 
 
+/* Mappings must start on a page boundary, so map from the page containing
+   offset and hand back a pointer into it.  Because the mapping itself is page
+   aligned, osd_unmap can find its start again from the returned address
+   alone. */
+file_error osd_map(osd_file *file, UINT64 offset, UINT64 length,
+                   const void **data)
+{
+#ifdef WINDOWS /* XXX need to find a way to make this work on Microsoft
+                  Windows without resorting to this ifdef */
+    return FILERR_FAILURE;
+#else
+    if (file->is_devnull || (length == 0)) {
+        return FILERR_FAILURE;
+    }
+
+    UINT64 pagemask = (UINT64) sysconf(_SC_PAGESIZE) - 1;
+    UINT64 base = offset & ~pagemask;
+    UINT64 span = length + (offset - base);
+
+    if ((size_t) span != span) {
+        return FILERR_OUT_OF_MEMORY;
+    }
+
+    void *mapping = mmap(NULL, (size_t) span, PROT_READ, MAP_SHARED,
+                         fileno(file->posix_file), (off_t) base);
+    if (mapping == MAP_FAILED)
+    {
+        switch (errno)
+        {
+        case EACCES:
+            return FILERR_ACCESS_DENIED;
+        case ENOMEM:
+            return FILERR_OUT_OF_MEMORY;
+        default:
+            return FILERR_FAILURE;
+        }
+    }
+
+    *data = (const UINT8 *) mapping + (offset - base);
+
+    return FILERR_NONE;
+#endif
+}
+
+
+void osd_unmap(const void *data, UINT64 length)
+{
+#ifndef WINDOWS
+    size_t pagemask = (size_t) sysconf(_SC_PAGESIZE) - 1;
+    size_t start = (size_t) data;
+    size_t base = start & ~pagemask;
+
+    (void) munmap((void *) base, (size_t) length + (start - base));
+#endif
+}
+
+
 file_error osd_rmfile(const char *filename)
 {
     if (unlink(filename))
@@ -6,38 +6,118 @@
  *
  ************************************************************************** **/
 
+#include <errno.h>
 #include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
 #include <unistd.h>
 #include "osdcore.h"
 
 /**
- * NOTE: Timeouts in work queue methods are pretty useless and should not be a
- * part of the API.  They are not really even used for anything.  It is a
- * little faster to ignore them.  So this code ignores timeouts and always
- * waits forever.
+ * General structure:
+ * - A pool of worker threads is shared across all work queues except I/O
+ *   queues.  The pool is created when the first such work queue is created,
+ *   and destroyed when the last one is destroyed.
+ * - Each worker thread owns a deque of work items.  The owner pushes and pops
+ *   items at the bottom of its deque without taking any lock; any other
+ *   worker that runs out of work steals items from the top of it, which
+ *   costs only a compare-and-swap.  This is the deque of Chase and Lev, "Dynamic
+ *   Circular Work-Stealing Deque", with a fixed size.
+ * - Threads outside of the pool (the emulator's main thread, usually) can't
+ *   push onto a deque, so they push new items onto a single lock-free stack,
+ *   the injection stack.  A worker looking for work takes the whole stack at
+ *   once and moves it into its own deque, where other workers can steal
+ *   from it.
+ * - A work item queued with numitems > 1 stays a single item; each thread
+ *   running it claims the next index with an atomic increment.  The first
+ *   thread to claim an index pushes the item back onto its own deque so that
+ *   other workers can steal it and help, and so on, so that the item spreads
+ *   across as many workers as are free.  A reference count on the item keeps
+ *   it alive until every deque entry pointing to it has been popped.
+ * - Work queues themselves are just a counter of incomplete items, and a
+ *   mutex and condition variable used only by threads that actually wait on
+ *   the queue or on one of its items.
+ * - Workers with nothing to do park on a condition variable of their own,
+ *   and are woken one at a time as work appears.  After running an item from
+ *   a WORK_QUEUE_FLAG_HIGH_FREQ queue, a worker spins for a short while
+ *   looking for more before parking, and so does a thread waiting on such a
+ *   queue, since the next item or the completion is likely only microseconds
+ *   away.
+ * - WORK_QUEUE_FLAG_IO queues get a thread of their own which runs their
+ *   items in order, instead of using the pool.  Items on I/O queues may block
+ *   for a long time (or, like the profiler's sampler, run for as long as the
+ *   queue exists), and must never tie up a pool worker that other queues are
+ *   depending on.
+ **/
+
+/**
+ * The number of entries in each worker's deque; must be a power of two.  If
+ * a deque fills up, items are left on the injection stack instead.
+ **/
+#define WORK_DEQUE_SIZE 1024
+
+/**
+ * How long, in osd_ticks, to spin looking for work or waiting for completion
+ * on high frequency queues before going to sleep
+ **/
+#define WORK_SPIN_TICKS (osd_ticks_per_second() / 10000)
+
+/**
+ * The environment variable that, when set, fixes the number of worker threads
+ * in the pool; it has the same name as in the SDL OSD
+ **/
+#define WORK_PROCESSORS_ENV "OSDPROCESSORS"
+
+/**
+ * Size of a cache line, used to keep data written by different threads from
+ * sharing one
  **/
+#define WORK_CACHE_LINE 64
+
 
 /**
- * A work queue.  All it has is an items_count and a condition variable that
- * is signalled when the items_count goes to 0.  Each work item has a pointer
- * back to its work queue, which is how work queues get updated when items are
- * completed.
+ * A work queue.  items_count is the number of items queued and not yet
+ * completed.  waiters is the number of threads waiting on the queue or one of
+ * its items; only when it is nonzero does completing an item need to take the
+ * mutex and broadcast the condition.  completing counts threads in the middle
+ * of completing an item, which must finish before the queue can be freed.
  **/
 struct _osd_work_queue
 {
-    int items_count;
+    UINT32 flags;
+
+    volatile INT32 items_count;
+
+    volatile INT32 waiters;
+
+    volatile INT32 completing;
+
+    pthread_mutex_t mutex;
 
     pthread_cond_t cond;
+
+    /**
+     * I/O queues only: the queue's own thread, the list of items it has yet
+     * to run, signalled when there are new items or it is time to stop
+     **/
+    pthread_t io_thread;
+
+    osd_work_item *io_items, *io_items_tail;
+
+    pthread_cond_t io_cond;
+
+    bool io_stop;
 };
 
 
 /**
  * A work item.  It stores all of the parameters that were passed in when it
- * was created, and keeps track of the number of items that have been run.
- * The thread to run the last item will remove the work_item from the global
- * list, and will, after running the work item, either free it, or signal its
- * condition so that whoever is waiting on it can be notified that it is done,
- * depending on flags.
+ * was created.  numitemsrun is the next index to run, and is incremented
+ * atomically by each thread that claims one; it may be incremented past
+ * numitems by threads that find nothing left to claim.  The thread that
+ * completes the last index updates the item's queue.  refs counts the deque
+ * entries pointing to the item, plus one for the API user unless the item is
+ * auto released; the item is freed when it drops to zero.
  **/
 struct _osd_work_item
 {
@@ -51,88 +131,97 @@ struct _osd_work_item
 
     UINT32 flags;
 
+    /**
+     * A copy of the queue's flags, because the queue may be gone by the time
+     * a thread pops a leftover deque entry for the item
+     **/
+    UINT32 queueflags;
+
     void *result;
 
-    int numitemsrun;
-    
-    int numitemscompleted;
+    volatile INT32 numitemsrun;
+
+    volatile INT32 numitemscompleted;
+
+    volatile INT32 refs;
 
     osd_work_queue *queue;
-    
+
+    /**
+     * Links the item into the injection stack, the list of free items, or
+     * an I/O queue's list of items
+     **/
     osd_work_item *next;
 };
 
 
 /**
- * Work queues are implemented very simply; it's not clear whether or not a
- * sophisticated implementation is necessary.  The mame source currently uses
- * work queues pretty sparingly, and until benchmarking is done, there is no
- * way to know if emulation of any game would be made significantly faster by
- * a faster work queue implementation.
- *
- * For what it's worth, a comparison against the SDL OSD work queue
- * implementation, using work_queue_test, shows that this implementation is
- * approximately 3x faster than the SDL OSD implementation so, it's probably
- * fast enough.
+ * A worker thread of the pool, and its deque.  top is written by thieves and
+ * bottom only by the owner, so they are kept in separate cache lines.
  **/
+typedef struct work_thread
+{
+    volatile UINT32 top;
+
+    UINT8 pad1[WORK_CACHE_LINE - sizeof(UINT32)];
+
+    volatile UINT32 bottom;
+
+    UINT8 pad2[WORK_CACHE_LINE - sizeof(UINT32)];
+
+    osd_work_item *volatile entries[WORK_DEQUE_SIZE];
+
+    /**
+     * Nonzero while the thread is parked, or about to be; a thread waking it
+     * clears this with a compare-and-swap so that each parked thread is
+     * woken only once
+     **/
+    volatile INT32 parked;
+
+    /**
+     * Set, with mutex held, to wake the thread up
+     **/
+    bool wakeup;
+
+    pthread_mutex_t mutex;
+
+    pthread_cond_t cond;
+
+    pthread_t id;
+
+    int threadid;
+} work_thread;
 
-/**
- * General structure:
- * - A pool of threads (num_processors + 1) is shared across all work queues.
- *   This pool of threads is created when the first work queue is created,
- *   and destroyed when the last work queue is destroyed.
- * - There is a single global queue of work items, across all queues; the
- *   pool of work queue threads takes items off of this single queue, and in
- *   this way, all work queues are handled simultaneously.
- * - Work queues themselves are nothing more than thin wrappers around a
- *   counter that is used to track when all items in that work queue have
- *   completed.
- **/
 
 /** **************************************************************************
  * Global variables
  ************************************************************************** **/
 
 /**
- * This is the number of work threads that have been started; when it is zero
- * and a work queue is created, worker threads are started.  When it is time
- * to shut down the worker threads (because there are no more work queues),
- * the count is decremented as each thread exits and when it gets to 0, the
- * g_threads_cond is signalled
+ * The pool of worker threads and the number of them, or NULL and 0 when
+ * there are no pool queues
  **/
+static work_thread *g_threads;
 static int g_threads_count;
 
-/**
- * Keep track of the thread ids so as to be able to join them, which avoids
- * pthreads memory leaks in buggy pthreads implementations.
- **/
-static pthread_t *g_thread_ids;
-
-/**
- * Just used to allow integer thread ids to be passed to thread main functions
- **/
-static int *g_thread_numbers;
-
 /**
  * This boolean is set to false when work threads are starting up, and is not
  * set to true until it is time for all work threads to exit
  **/
-static bool g_threads_stop;
+static volatile bool g_threads_stop;
 
 /**
- * This is the total number of work queues that are currently in existence;
- * when it goes to zero, the worker threads are shut down.
+ * This is the total number of pool work queues that are currently in
+ * existence; when it goes to zero, the worker threads are shut down.
  **/
 static int g_queues_count;
 
 /**
- * This is the list of work items waiting to be handled.  Each work item may
- * need to be run multiple times (with a new parameter each time, as per the
- * numitems parameter).  The thread to run the last parameter in the work item
- * removes the work_item from the global list and either signals a condition,
- * or frees the work_item directly, depending upon the work_item's flags.
+ * The injection stack of items queued from outside of the pool.  Items are
+ * pushed one at a time with a compare-and-swap, and taken all at once with
+ * an exchange, which is why it needs no protection from ABA.
  **/
-static osd_work_item *g_items, *g_items_tail;
+static osd_work_item *volatile g_injected;
 
 /**
  * This is a static array of osd_work_item structures, to be used instead of
@@ -142,9 +231,13 @@ static osd_work_item *g_items, *g_items_tail;
 static osd_work_item g_static_items[10000];
 
 /**
- * This is the list of static items that are freely available
+ * This is the list of static items that are available to be allocated; it
+ * is protected by g_free_mutex.  Items are released to g_released, without
+ * any lock, and moved back to g_free_items in one go when it runs out.
  **/
 static osd_work_item *g_free_items;
+static osd_work_item *volatile g_released;
+static pthread_mutex_t g_free_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 /**
  * This is set to true after the g_free_items list is initialized; only
@@ -153,30 +246,151 @@ static osd_work_item *g_free_items;
 static bool g_free_items_initialized;
 
 /**
- * This is a global mutex protecting g_threads_count, g_threads_stop,
- * g_queues_count, g_items, and g_items_tail.
+ * This is a global mutex protecting the creation and destruction of queues
+ * and of the pool of worker threads, but nothing that happens while items
+ * are queued and run.
  **/
 static pthread_mutex_t g_mutex = PTHREAD_MUTEX_INITIALIZER;
 
+
+/** **************************************************************************
+ * Deques
+ ************************************************************************** **/
+
 /**
- * Signalled when g_threads_count goes to 0
+ * Orders all memory accesses before the barrier ahead of all those after it
  **/
-static pthread_cond_t g_threads_cond = PTHREAD_COND_INITIALIZER;
+static inline void memory_barrier()
+{
+    __sync_synchronize();
+}
+
 
 /**
- * Signalled when g_items has a new entry
+ * Pushes an item onto the bottom of a thread's own deque; returns false if
+ * the deque is full.  Only the owner may call this.
  **/
-static pthread_cond_t g_items_cond = PTHREAD_COND_INITIALIZER;
+static bool deque_push(work_thread *thread, osd_work_item *item)
+{
+    UINT32 bottom = thread->bottom;
+
+    if ((INT32) (bottom - thread->top) >= WORK_DEQUE_SIZE) {
+        return false;
+    }
+
+    thread->entries[bottom & (WORK_DEQUE_SIZE - 1)] = item;
 
+    /* The entry must be visible before the bottom that covers it */
+    memory_barrier();
+    thread->bottom = bottom + 1;
 
-static void work_item_release_locked(osd_work_item *item)
+    return true;
+}
+
+
+/**
+ * Pops the item from the bottom of a thread's own deque, or returns NULL if
+ * it is empty.  Only the owner may call this.
+ **/
+static osd_work_item *deque_pop(work_thread *thread)
+{
+    UINT32 bottom = thread->bottom - 1;
+    thread->bottom = bottom;
+
+    /* Claiming the bottom entry must be visible before looking at top, or a
+       thief and the owner could both take the last entry */
+    memory_barrier();
+    UINT32 top = thread->top;
+
+    if ((INT32) (bottom - top) < 0) {
+        /* Empty */
+        thread->bottom = top;
+        return NULL;
+    }
+
+    osd_work_item *item = thread->entries[bottom & (WORK_DEQUE_SIZE - 1)];
+
+    if (bottom == top) {
+        /* This is the last entry, so race any thieves for it */
+        if (!__sync_bool_compare_and_swap(&thread->top, top, top + 1)) {
+            item = NULL;
+        }
+        thread->bottom = top + 1;
+    }
+
+    return item;
+}
+
+
+/**
+ * Steals the item from the top of another thread's deque.  Returns NULL if
+ * the deque is empty, or if another thread took the top item first.
+ **/
+static osd_work_item *deque_steal(work_thread *thread)
+{
+    UINT32 top = thread->top;
+    memory_barrier();
+    UINT32 bottom = thread->bottom;
+
+    if ((INT32) (bottom - top) <= 0) {
+        return NULL;
+    }
+
+    osd_work_item *item = thread->entries[top & (WORK_DEQUE_SIZE - 1)];
+
+    if (!__sync_bool_compare_and_swap(&thread->top, top, top + 1)) {
+        return NULL;
+    }
+
+    return item;
+}
+
+
+static bool deque_empty(work_thread *thread)
+{
+    return ((INT32) (thread->bottom - thread->top) <= 0);
+}
+
+
+/** **************************************************************************
+ * Work items
+ ************************************************************************** **/
+
+static osd_work_item *work_item_alloc()
+{
+    pthread_mutex_lock(&g_free_mutex);
+
+    if (!g_free_items) {
+        g_free_items = __sync_lock_test_and_set(&g_released, NULL);
+    }
+
+    osd_work_item *item = g_free_items;
+
+    if (item) {
+        g_free_items = item->next;
+    }
+
+    pthread_mutex_unlock(&g_free_mutex);
+
+    if (!item) {
+        item = (osd_work_item *) osd_malloc(sizeof(osd_work_item));
+    }
+
+    return item;
+}
+
+
+static void work_item_free(osd_work_item *item)
 {
     if ((item >= &(g_static_items[0])) &&
-        (item <= &(g_static_items[sizeof(g_static_items) / 
-                                  sizeof(g_static_items[0])])))
+        (item < &(g_static_items[sizeof(g_static_items) /
+                                 sizeof(g_static_items[0])])))
     {
-        item->next = g_free_items;
-        g_free_items = item;
+        osd_work_item *released;
+        do {
+            released = g_released;
+            item->next = released;
+        } while (!__sync_bool_compare_and_swap(&g_released, released, item));
     }
     else
     {
@@ -185,148 +399,306 @@ static void work_item_release_locked(osd_work_item *item)
 }
 
 
-static void work_queue_run_items_locked(int threadid)
+static void work_item_unref(osd_work_item *item)
+{
+    if (__sync_sub_and_fetch(&item->refs, 1) == 0)
+    {
+        work_item_free(item);
+    }
+}
+
+
+/**
+ * Called by the thread that completed the last index of an item
+ **/
+static void work_item_complete(osd_work_item *item)
 {
+    osd_work_queue *queue = item->queue;
+
     /**
-     * Run items in a loop until there are no more
+     * The queue can't be freed until completing is back to zero, which keeps
+     * it around until we're done signalling it
      **/
-    do
+    __sync_fetch_and_add(&queue->completing, 1);
+
+    __sync_sub_and_fetch(&queue->items_count, 1);
+
+    /**
+     * Waiters increment waiters before testing for completion, and we
+     * decrement items_count before testing waiters, both with full barriers,
+     * so either they see the completion or we see them
+     **/
+    if (queue->waiters)
     {
-        /**
-         * Save a pointer to the item, as g_items may change while we are
-         * working on this item
-         **/
-        osd_work_item *item = g_items;
+        pthread_mutex_lock(&queue->mutex);
+        pthread_cond_broadcast(&queue->cond);
+        pthread_mutex_unlock(&queue->mutex);
+    }
 
-        /**
-         * Save the start index of the items we are to run
-         **/
-        int index = item->numitemsrun;
-        
-        /**
-         * Increment the numitemsrun since we are running items.  If we are
-         * taking the last item to run out of the item, then no other work
-         * thread should see this item any more on the work item list, so
-         * remove it
-         **/
-        
-        item->numitemsrun += 1;
-        
-        if (item->numitemsrun == item->numitems)
+    __sync_fetch_and_sub(&queue->completing, 1);
+}
+
+
+/** **************************************************************************
+ * Worker threads
+ ************************************************************************** **/
+
+/**
+ * Wakes up one parked worker, if there is one
+ **/
+static void work_thread_wake_one()
+{
+    for (int i = 0; i < g_threads_count; i++)
+    {
+        work_thread *thread = &(g_threads[i]);
+
+        if (thread->parked &&
+            __sync_bool_compare_and_swap(&thread->parked, 1, 0))
         {
-            g_items = g_items->next;
+            pthread_mutex_lock(&thread->mutex);
+            thread->wakeup = true;
+            pthread_cond_signal(&thread->cond);
+            pthread_mutex_unlock(&thread->mutex);
+            return;
+        }
+    }
+}
 
-            if (!g_items)
-            {
-                g_items_tail = 0;
-            }
+
+/**
+ * Runs as many indices of an item as can be claimed, and then drops the
+ * reference to the item that the caller took from a deque, the injection
+ * stack, or an I/O queue.  thread is NULL for I/O queue threads, which don't
+ * share items.
+ **/
+static void work_item_run(work_thread *thread, osd_work_item *item,
+                          int threadid)
+{
+    INT32 index = __sync_fetch_and_add(&item->numitemsrun, 1);
+
+    /**
+     * If there are indices left after this one, make the item available for
+     * other workers to steal and help with
+     **/
+    if (thread && ((index + 1) < item->numitems))
+    {
+        __sync_fetch_and_add(&item->refs, 1);
+        if (deque_push(thread, item))
+        {
+            memory_barrier();
+            work_thread_wake_one();
         }
-        
-        /**
-         * Release the locks; we know that the work item won't be taken out
-         * from underneath us because it cannot be freed until the last item
-         * is completed, and that can't happen until we're done with it
-         **/
-        pthread_mutex_unlock(&g_mutex);
-        
-        /**
-         * Actually run the work item with the appropriate parameters
-         **/
-        
+        else
+        {
+            __sync_fetch_and_sub(&item->refs, 1);
+        }
+    }
+
+    while (index < item->numitems)
+    {
         void *result = (item->callback)
             (&(((char *) item->parambase)[index * item->paramstep]), threadid);
-        
-        /**
-         * Re-acquire the mutex so that we can safely update some fields
-         **/
-        pthread_mutex_lock(&g_mutex);
-        
-        /* Save away the result */
+
         item->result = result;
-        
+
+        if (__sync_add_and_fetch(&item->numitemscompleted, 1) ==
+            item->numitems)
+        {
+            work_item_complete(item);
+        }
+
+        index = __sync_fetch_and_add(&item->numitemsrun, 1);
+    }
+
+    work_item_unref(item);
+}
+
+
+/**
+ * Finds the next item for a worker to run: from its own deque, then from the
+ * injection stack, then by stealing from the other workers
+ **/
+static osd_work_item *work_thread_find_item(work_thread *thread)
+{
+    osd_work_item *item = deque_pop(thread);
+
+    if (item)
+    {
+        return item;
+    }
+
+    if (g_injected)
+    {
         /**
-         * If the work item was complete (meaning that we were the work thread
-         * that completed the very last work call), then we can handle its end
-         * of life stuff
+         * Take the whole stack, which is newest first, and push it onto our
+         * deque newest first, so that we pop the oldest first and thieves
+         * steal the newest
          **/
-        if (++item->numitemscompleted == item->numitems)
+        item = __sync_lock_test_and_set(&g_injected, NULL);
+
+        while (item)
         {
-            /**
-             * Get a reference to its queue before releasing the item so that
-             * we can update the queue if necessary
-             **/
-            osd_work_queue *queue = item->queue;
-            
-            /**
-             * If the flag said so, then just immediately auto free it
-             **/
-            if (item->flags & WORK_ITEM_FLAG_AUTO_RELEASE)
+            osd_work_item *next = item->next;
+
+            if (!deque_push(thread, item))
             {
-                /**
-                 * No one else can have a reference to it because the API user
-                 * never got a reference to it, and we've just completed the
-                 * last item so no other worker thread could be looking at it.
-                 * So it's safe to release it here.
-                 **/
-                work_item_release_locked(item);
+                /* No more room, so put the rest back where they came from */
+                while (item)
+                {
+                    next = item->next;
+                    osd_work_item *injected;
+                    do {
+                        injected = g_injected;
+                        item->next = injected;
+                    } while (!__sync_bool_compare_and_swap
+                             (&g_injected, injected, item));
+                    item = next;
+                }
+                break;
             }
-            
-            /**
-             * Decrement the queue's item count.  If it goes to zero, signal
-             * the condition just in case someone is waiting for it to be
-             * done.
-             **/
-            if (--queue->items_count == 0)
+
+            item = next;
+        }
+
+        item = deque_pop(thread);
+
+        if (item)
+        {
+            /* Let someone else have the rest */
+            if (!deque_empty(thread))
             {
-                pthread_cond_signal(&queue->cond);
+                memory_barrier();
+                work_thread_wake_one();
             }
+            return item;
         }
-    } while (g_items);
+    }
+
+    for (int i = 1; i < g_threads_count; i++)
+    {
+        work_thread *victim =
+            &(g_threads[(thread->threadid + i) % g_threads_count]);
+
+        /* Retry a few times if other thieves get in the way */
+        for (int tries = 0; (tries < 4) && !deque_empty(victim); tries++)
+        {
+            item = deque_steal(victim);
+            if (item)
+            {
+                return item;
+            }
+        }
+    }
+
+    return NULL;
 }
 
 
 /**
- * Worker thread function
+ * Returns true if there is any work that a worker could pick up
  **/
-static void *work_queue_thread_main(void *data)
+static bool work_available()
 {
-    int threadid = * (int *) data;
+    if (g_injected)
+    {
+        return true;
+    }
 
-    pthread_mutex_lock(&g_mutex);
-    
-    /**
-     * If it's time to stop, then exit this loop.
-     **/
-    while (!g_threads_stop)
+    for (int i = 0; i < g_threads_count; i++)
     {
-        /**
-         * If there are items, then handle the next item
-         **/
-        if (g_items)
+        if (!deque_empty(&(g_threads[i])))
         {
-            work_queue_run_items_locked(threadid);
+            return true;
         }
-        /**
-         * Else there are currently no items, so wait until g_items_cond is
-         * signalled, which happens either when there is a new item, or
-         * g_threads_stop is set; either way we will have something new to
-         * test at the top of the loop
-         **/
-        else
+    }
+
+    return false;
+}
+
+
+/**
+ * Spins for a short while waiting for work to show up; returns true if it
+ * did
+ **/
+static bool work_thread_spin()
+{
+    osd_ticks_t stop = osd_ticks() + WORK_SPIN_TICKS;
+
+    do
+    {
+        for (int spin = 0; spin < 1000; spin++)
         {
-            pthread_cond_wait(&g_items_cond, &g_mutex);
+            if (work_available())
+            {
+                return true;
+            }
         }
-    }
+    } while (!g_threads_stop && (osd_ticks() < stop));
+
+    return false;
+}
+
+
+/**
+ * Parks a worker until there is work for it
+ **/
+static void work_thread_park(work_thread *thread)
+{
+    pthread_mutex_lock(&thread->mutex);
+
+    thread->parked = 1;
 
     /**
-     * If this is the last work thread to exit, signal the g_threads_cond
+     * Anyone queueing work does so before looking for parked threads, and we
+     * say we're parked before looking for work, with full barriers in both
+     * cases, so either we see the work or they see us
      **/
-    if (--g_threads_count == 0)
+    memory_barrier();
+
+    if (!(work_available() || g_threads_stop))
     {
-        pthread_cond_signal(&g_threads_cond);
+        while (!thread->wakeup)
+        {
+            pthread_cond_wait(&thread->cond, &thread->mutex);
+        }
+        thread->wakeup = false;
     }
 
-    pthread_mutex_unlock(&g_mutex);
+    /**
+     * If someone claimed us to wake up after we found work without waiting,
+     * wakeup will be set once we unlock, and we'll just come straight back
+     * out the next time we park
+     **/
+    thread->parked = 0;
+
+    pthread_mutex_unlock(&thread->mutex);
+}
+
+
+/**
+ * Worker thread function
+ **/
+static void *work_thread_main(void *data)
+{
+    work_thread *thread = (work_thread *) data;
+
+    bool spin = false;
+
+    while (!g_threads_stop)
+    {
+        osd_work_item *item = work_thread_find_item(thread);
+
+        if (item)
+        {
+            spin = (item->queueflags & WORK_QUEUE_FLAG_HIGH_FREQ);
+            work_item_run(thread, item, thread->threadid);
+        }
+        else if (!(spin && work_thread_spin()))
+        {
+            spin = false;
+            work_thread_park(thread);
+        }
+    }
 
     return 0;
 }
@@ -334,70 +706,51 @@ static void *work_queue_thread_main(void *data)
 
 /**
  * This is called whenever it is time to destroy all of the work threads that
- * have been created
+ * have been created; must be called with g_mutex locked
  **/
 static void work_queue_destroy_threads_locked()
 {
     /**
-     * Set the flag that will tell all work threads to exit
+     * Set the flag that will tell all work threads to exit, and wake up
+     * every one of them so that they see it
      **/
     g_threads_stop = true;
 
-    /**
-     * Broadcast on the g_items_cond, so that any thread which is waiting for
-     * an item will wake up and go back to the top of its loop and see that
-     * the g_threads_stop flag is now set and will thus exit
-     **/
-    pthread_cond_broadcast(&g_items_cond);
-    
-    int threads_count = g_threads_count;
+    memory_barrier();
 
-    /**
-     * Wait util all of the threads have exited; because each decrements the
-     * g_threads_count, and because the last one that decrements the count to
-     * 0 signals the condition, waiting on the condition until g_threads_count
-     * is zero is sufficient
-     **/
-    while (g_threads_count)
+    for (int i = 0; i < g_threads_count; i++)
     {
-        pthread_cond_wait(&g_threads_cond, &g_mutex);
+        work_thread *thread = &(g_threads[i]);
+        pthread_mutex_lock(&thread->mutex);
+        thread->wakeup = true;
+        pthread_cond_signal(&thread->cond);
+        pthread_mutex_unlock(&thread->mutex);
     }
 
-    /**
-     * And, join them all to prevent pthreads memory leaks in buggy pthreads
-     * implementations
-     **/
-    for (int i = 0; i < threads_count; i++)
+    for (int i = 0; i < g_threads_count; i++)
     {
         void *dontcare;
-        (void) pthread_join(g_thread_ids[i], &dontcare);
+        (void) pthread_join(g_threads[i].id, &dontcare);
+        pthread_cond_destroy(&(g_threads[i].cond));
+        pthread_mutex_destroy(&(g_threads[i].mutex));
     }
 
-    osd_free(g_thread_ids);
+    osd_free(g_threads);
 
-    osd_free(g_thread_numbers);
+    g_threads = NULL;
 
-    g_thread_ids = NULL;
+    g_threads_count = 0;
 }
 
 
 /**
- * This method is called to create the work threads when the first work queue
- * is created.
+ * This method is called to create the work threads when the first pool work
+ * queue is created; must be called with g_mutex locked.
  **/
 static int work_queue_create_threads_locked()
 {
     int threads_count;
 
-    /**
-     * The number of threads to run is determined to be the number of
-     * processors in the system plus one.  This is a guess as to how to most
-     * effectively keep the processors busy.  I/O bound work queues may
-     * benefit from more threads, and purely processor-bound work queues only
-     * need one thread per CPU, but this compromise will likely work well in
-     * most cases.
-     **/
-
     /**
      * Allow a preprocessor symbol named OSDLIB_WORK_QUEUE_THREAD_COUNT to fix
      * the number of threads to start.  This may be useful for testing or for
@@ -410,8 +763,8 @@ static int work_queue_create_threads_locked()
     /**
      * If that's not defined, then if _SC_NPROCESSORS_ONLN is defined, it
      * means that the POSIX sysconf call to get the number of processors is
-     * available, so use it; but subtract one because empirical evidence shows
-     * that this is best.
+     * available, so use it; but subtract one because the thread queueing the
+     * work is generally busy too.
      **/
 #ifdef _SC_NPROCESSORS_ONLN
     threads_count = sysconf(_SC_NPROCESSORS_ONLN) - 1;
@@ -426,6 +779,16 @@ static int work_queue_create_threads_locked()
 #endif
 #endif
 
+    /**
+     * The environment can override either, which is how work_queue_test
+     * measures how the pool scales
+     **/
+    const char *processors = getenv(WORK_PROCESSORS_ENV);
+    if (processors && (atoi(processors) > 0))
+    {
+        threads_count = atoi(processors);
+    }
+
     if (threads_count > WORK_MAX_THREADS)
     {
         threads_count = WORK_MAX_THREADS;
@@ -436,79 +799,205 @@ static int work_queue_create_threads_locked()
         threads_count = 1;
     }
 
-    /**
-     * This variable will be set if the creation of any of the work threads
-     * fails, and will provoke a cleanup operation
-     **/
-    int ret = 0;
-
-    /**
-     * Be sure to initialize this global variable so that the threads that
-     * start do not think that they need to exit
-     **/
-    g_threads_stop = false;
-
-    /**
-     * Create the array to hold thread ids
-     **/
-    g_thread_ids = (pthread_t *) osd_malloc(sizeof(pthread_t) * threads_count);
+    g_threads = (work_thread *) osd_malloc(sizeof(work_thread) * threads_count);
+    if (g_threads == NULL)
+    {
+        return 1;
+    }
 
     /**
-     * Create the array to allow passing of integer thread ids to the thread
-     * main function
+     * Be sure to initialize every thread before starting any of them, since
+     * they look at each other's deques
      **/
-    g_thread_numbers = (int *) osd_malloc(sizeof(int) * threads_count);
     for (int i = 0; i < threads_count; i++)
     {
-        g_thread_numbers[i] = i;
+        work_thread *thread = &(g_threads[i]);
+        thread->top = thread->bottom = 0;
+        thread->parked = 0;
+        thread->wakeup = false;
+        thread->threadid = i;
+        pthread_mutex_init(&(thread->mutex), NULL);
+        pthread_cond_init(&(thread->cond), NULL);
     }
 
+    g_threads_stop = false;
+
     /**
      * Create threads_count work threads
      **/
     for (int i = 0; i < threads_count; i++)
     {
-        pthread_t newthread;
-        if (pthread_create(&newthread, NULL, &work_queue_thread_main,
-                           &(g_thread_numbers[i])))
+        if (pthread_create(&(g_threads[i].id), NULL, &work_thread_main,
+                           &(g_threads[i])))
         {
             /**
-             * On failure, set the flag, and stop trying to create new threads
+             * On failure, stop and destroy whatever threads were created
              **/
-            ret = 1;
+            for (int j = i; j < threads_count; j++)
+            {
+                pthread_cond_destroy(&(g_threads[j].cond));
+                pthread_mutex_destroy(&(g_threads[j].mutex));
+            }
+            g_threads_count = i;
+            work_queue_destroy_threads_locked();
+            return 1;
+        }
+
+        /**
+         * The new thread can start looking at the others' deques as soon as
+         * this is incremented, and they're all initialized already
+         **/
+        g_threads_count = i + 1;
+    }
+
+    return 0;
+}
+
+
+/** **************************************************************************
+ * I/O queue threads
+ ************************************************************************** **/
+
+/**
+ * Runs the items of one I/O queue, in the order in which they were queued
+ **/
+static void *work_queue_io_thread_main(void *data)
+{
+    osd_work_queue *queue = (osd_work_queue *) data;
+
+    pthread_mutex_lock(&queue->mutex);
+
+    while (true)
+    {
+        osd_work_item *item = queue->io_items;
+
+        if (item)
+        {
+            queue->io_items = item->next;
+            if (!queue->io_items)
+            {
+                queue->io_items_tail = NULL;
+            }
+
+            pthread_mutex_unlock(&queue->mutex);
+
+            work_item_run(NULL, item, 0);
+
+            pthread_mutex_lock(&queue->mutex);
+        }
+        else if (queue->io_stop)
+        {
             break;
         }
         else
         {
-            /* Store the newly-created thread's ID in the list */
-            g_thread_ids[i] = newthread;
-            
-            /**
-             * On success, increment the number of threads that have been
-             * created.  Note that the newly created thread will not do
-             * anything because we were called with g_mutex locked, and the
-             * work threads immediately try to acquire that lock and thus
-             * immediately wait until we are done
-             **/
-            g_threads_count += 1;
+            pthread_cond_wait(&queue->io_cond, &queue->mutex);
         }
     }
 
+    pthread_mutex_unlock(&queue->mutex);
+
+    return 0;
+}
+
+
+/** **************************************************************************
+ * Waiting
+ ************************************************************************** **/
+
+static bool work_wait_done(osd_work_queue *queue, osd_work_item *item)
+{
+    if (item)
+    {
+        return (item->numitemscompleted == item->numitems);
+    }
+
+    return (queue->items_count == 0);
+}
+
+
+/**
+ * Waits for either an item or, if item is NULL, a whole queue to complete.
+ * Returns TRUE if it did, or FALSE if the timeout expired first.
+ **/
+static int work_wait(osd_work_queue *queue, osd_work_item *item,
+                     osd_ticks_t timeout)
+{
+    if (work_wait_done(queue, item))
+    {
+        return TRUE;
+    }
+
+    if (timeout <= 0)
+    {
+        return FALSE;
+    }
+
+    osd_ticks_t now = osd_ticks();
+
+    osd_ticks_t deadline = now + timeout;
+
     /**
-     * If there was a failure, destroy all of the newly created threads
+     * On high frequency queues, completion is likely to be very close, so
+     * it's worth spinning for a bit instead of sleeping and being woken
      **/
-    if (ret)
+    if (queue->flags & WORK_QUEUE_FLAG_HIGH_FREQ)
     {
-        work_queue_destroy_threads_locked();
+        osd_ticks_t stop = now + WORK_SPIN_TICKS;
+        if (stop > deadline)
+        {
+            stop = deadline;
+        }
+
+        do
+        {
+            for (int spin = 0; spin < 1000; spin++)
+            {
+                if (work_wait_done(queue, item))
+                {
+                    return TRUE;
+                }
+            }
+        } while (osd_ticks() < stop);
     }
 
-    return ret;
+    osd_ticks_t tps = osd_ticks_per_second();
+
+    struct timespec ts;
+    ts.tv_sec = deadline / tps;
+    ts.tv_nsec = (deadline % tps) * (1000000000 / tps);
+
+    pthread_mutex_lock(&queue->mutex);
+
+    __sync_fetch_and_add(&queue->waiters, 1);
+
+    bool done;
+
+    while (!(done = work_wait_done(queue, item)))
+    {
+        if (pthread_cond_timedwait(&queue->cond, &queue->mutex, &ts) ==
+            ETIMEDOUT)
+        {
+            done = work_wait_done(queue, item);
+            break;
+        }
+    }
+
+    __sync_fetch_and_sub(&queue->waiters, 1);
+
+    pthread_mutex_unlock(&queue->mutex);
+
+    return done ? TRUE : FALSE;
 }
 
 
+/** **************************************************************************
+ * Exported functions
+ ************************************************************************** **/
+
 osd_work_queue *osd_work_queue_alloc(int flags)
 {
-    osd_work_queue *queue = (osd_work_queue *) 
+    osd_work_queue *queue = (osd_work_queue *)
         osd_malloc(sizeof(osd_work_queue));
 
     if (queue == NULL)
@@ -516,20 +1005,32 @@ osd_work_queue *osd_work_queue_alloc(int flags)
         return NULL;
     }
 
+    if (pthread_mutex_init(&(queue->mutex), NULL))
+    {
+        osd_free(queue);
+        return NULL;
+    }
+
     if (pthread_cond_init(&(queue->cond), NULL))
     {
+        pthread_mutex_destroy(&(queue->mutex));
         osd_free(queue);
         return NULL;
     }
 
+    queue->flags = flags;
     queue->items_count = 0;
+    queue->waiters = 0;
+    queue->completing = 0;
+    queue->io_items = queue->io_items_tail = NULL;
+    queue->io_stop = false;
 
-    g_queues_count += 1;
+    pthread_mutex_lock(&g_mutex);
 
     if (!g_free_items_initialized)
     {
         g_free_items = 0;
-        for (unsigned int i = 0; 
+        for (unsigned int i = 0;
              i < (sizeof(g_static_items) / sizeof(g_static_items[0])); i++)
         {
             osd_work_item *item = &(g_static_items[i]);
@@ -539,8 +1040,42 @@ osd_work_queue *osd_work_queue_alloc(int flags)
         g_free_items_initialized = true;
     }
 
+    int failed;
+
+    if (flags & WORK_QUEUE_FLAG_IO)
+    {
+        failed = pthread_cond_init(&(queue->io_cond), NULL);
+        if (!failed)
+        {
+            failed = pthread_create(&(queue->io_thread), NULL,
+                                    &work_queue_io_thread_main, queue);
+            if (failed)
+            {
+                pthread_cond_destroy(&(queue->io_cond));
+            }
+        }
+    }
+    else
+    {
+        /* Take this opportunity to create the work threads if they need to
+           be created */
+        failed = (g_threads == NULL) && work_queue_create_threads_locked();
+        if (!failed)
+        {
+            g_queues_count += 1;
+        }
+    }
+
     pthread_mutex_unlock(&g_mutex);
-    
+
+    if (failed)
+    {
+        pthread_cond_destroy(&(queue->cond));
+        pthread_mutex_destroy(&(queue->mutex));
+        osd_free(queue);
+        return NULL;
+    }
+
     return queue;
 }
 
@@ -553,56 +1088,55 @@ int osd_work_queue_items(osd_work_queue *queue)
 
 int osd_work_queue_wait(osd_work_queue *queue, osd_ticks_t timeout)
 {
-    /**
-     * NOTE: we ignore timeout and always wait forever
-     **/
-    (void) timeout;
+    return work_wait(queue, NULL, timeout);
+}
 
-    pthread_mutex_lock(&g_mutex);
 
+void osd_work_queue_free(osd_work_queue *queue)
+{
     /**
-     * Wait until the queue has no more items.
+     * Wait until the work queue is empty, and then until nobody is still
+     * signalling it about the last completion
      **/
-    while (queue->items_count)
+    while (!osd_work_queue_wait(queue, 100 * osd_ticks_per_second()))
     {
-        pthread_cond_wait(&queue->cond, &g_mutex);
     }
 
-    /**
-     * If we got here, then the queue is now empty so we can return
-     **/
-
-    pthread_mutex_unlock(&g_mutex);
-
-    return TRUE;
-}
-
+    while (queue->completing)
+    {
+        sched_yield();
+    }
 
-void osd_work_queue_free(osd_work_queue *queue)
-{
-    /**
-     * Wait until the work queue is empty.  We use a special timeout value,
-     * that we know means 'wait forever'.
-     **/
-    osd_work_queue_wait(queue, 0);
+    pthread_mutex_lock(&g_mutex);
 
-    /**
-     * Destroy the queue
-     **/
-    osd_free(queue);
+    if (queue->flags & WORK_QUEUE_FLAG_IO)
+    {
+        /**
+         * Stop the queue's own thread
+         **/
+        pthread_mutex_lock(&queue->mutex);
+        queue->io_stop = true;
+        pthread_cond_signal(&queue->io_cond);
+        pthread_mutex_unlock(&queue->mutex);
 
+        void *dontcare;
+        (void) pthread_join(queue->io_thread, &dontcare);
+        pthread_cond_destroy(&(queue->io_cond));
+    }
     /**
-     * Now decrement the queue count, and if it has gone to zero, destroy the
+     * Else decrement the queue count, and if it has gone to zero, destroy the
      * work threads as there are no more work queues that need to be serviced
      **/
-    pthread_mutex_lock(&g_mutex);
-
-    if (--g_queues_count == 0)
+    else if (--g_queues_count == 0)
     {
         work_queue_destroy_threads_locked();
     }
 
     pthread_mutex_unlock(&g_mutex);
+
+    pthread_cond_destroy(&(queue->cond));
+    pthread_mutex_destroy(&(queue->mutex));
+    osd_free(queue);
 }
 
 
@@ -611,33 +1145,11 @@ osd_work_item *osd_work_item_queue_multiple(osd_work_queue *queue,
                                             INT32 numitems, void *parambase,
                                             INT32 paramstep, UINT32 flags)
 {
-    osd_work_item *item;
-
-    pthread_mutex_lock(&g_mutex);
+    osd_work_item *item = work_item_alloc();
 
-    /* Take this opportunity to create the work threads if they need to be
-       created */
-    if (g_thread_ids == NULL)
+    if (item == NULL)
     {
-        if (work_queue_create_threads_locked())
-        {
-            pthread_mutex_unlock(&g_mutex);
-            return NULL;
-        }
-    }
-
-    if (g_free_items)
-    {
-        item = g_free_items;
-        g_free_items = item->next;
-    }
-    else {
-        item = (osd_work_item *) osd_malloc(sizeof(osd_work_item));
-
-        if (item == NULL)
-        {
-            return NULL;
-        }
+        return NULL;
     }
 
     item->callback = callback;
@@ -650,40 +1162,56 @@ osd_work_item *osd_work_item_queue_multiple(osd_work_queue *queue,
 
     item->flags = flags;
 
+    item->queueflags = queue->flags;
+
+    item->result = NULL;
+
     item->numitemsrun = 0;
 
     item->numitemscompleted = 0;
 
+    /* One reference for the entry about to be queued, and one for the
+       caller unless the item releases itself */
+    item->refs = (flags & WORK_ITEM_FLAG_AUTO_RELEASE) ? 1 : 2;
+
     item->queue = queue;
-    
-    queue->items_count += 1;
 
-    item->next = 0;
+    __sync_fetch_and_add(&queue->items_count, 1);
 
-    if (g_items_tail)
-    {
-        g_items_tail->next = item;
-        g_items_tail = item;
-    }
-    else
+    if (queue->flags & WORK_QUEUE_FLAG_IO)
     {
-        g_items = g_items_tail = item;
-    }
+        item->next = NULL;
 
-#if 0
-    pthread_cond_broadcast(&g_items_cond);
-#else
-    if (numitems == 1)
-    {
-        pthread_cond_signal(&g_items_cond);
+        pthread_mutex_lock(&queue->mutex);
+
+        if (queue->io_items_tail)
+        {
+            queue->io_items_tail->next = item;
+        }
+        else
+        {
+            queue->io_items = item;
+        }
+        queue->io_items_tail = item;
+
+        pthread_cond_signal(&queue->io_cond);
+
+        pthread_mutex_unlock(&queue->mutex);
     }
     else
     {
-        pthread_cond_broadcast(&g_items_cond);
+        osd_work_item *injected;
+        do {
+            injected = g_injected;
+            item->next = injected;
+        } while (!__sync_bool_compare_and_swap(&g_injected, injected, item));
+
+        /**
+         * Wake one parked worker; if there's more to do than it can handle,
+         * it will wake another, and so on
+         **/
+        work_thread_wake_one();
     }
-#endif
-    
-    pthread_mutex_unlock(&g_mutex);
 
     /* Enforce that the caller is not allowed to reference this item when they
        say to auto release it by returning NULL in that case */
@@ -693,14 +1221,7 @@ osd_work_item *osd_work_item_queue_multiple(osd_work_queue *queue,
 
 int osd_work_item_wait(osd_work_item *item, osd_ticks_t timeout)
 {
-    /**
-     * Just wait on the queue that this item belongs to.  This is done because
-     * MAME actually doesn't really use this method and this is the simplest
-     * way to implement it.  Providing for an implementation that can wait for
-     * this specific item to be finished is more heavyweight and hurts the
-     * performance of the rest of the work queue implementation.
-     **/
-    return osd_work_queue_wait(item->queue, timeout);
+    return work_wait(item->queue, item, timeout);
 }
 
 
@@ -712,9 +1233,5 @@ void *osd_work_item_result(osd_work_item *item)
 
 void osd_work_item_release(osd_work_item *item)
 {
-    pthread_mutex_lock(&g_mutex);
-
-    work_item_release_locked(item);
-
-    pthread_mutex_unlock(&g_mutex);
+    work_item_unref(item);
 }
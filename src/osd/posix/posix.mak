@@ -44,7 +44,12 @@ OSDOBJS = $(OBJ)/osd/posix/osd_main.o
 $(LIBOSD): $(OSDOBJS)
 
 
-# test program
+# test programs
 work_queue_test: $(MAKETREE) $(OBJ)/osd/posix/work_queue_test.o $(LIBOCORE)
 				 $(ECHO) Linking $@...
 				 $(LD) $(LDFLAGS) $(LDFLAGSEMULATOR) $^ $(LIBS) -o $@
+
+rendersw_test: $(MAKETREE) $(OBJ)/osd/posix/rendersw_test.o $(OBJ)/emu/emualloc.o \
+			   $(OBJ)/emu/video/rgbutil.o $(LIBOCORE)
+			   $(ECHO) Linking $@...
+			   $(LD) $(LDFLAGS) $(LDFLAGSEMULATOR) $^ $(LIBS) -o $@
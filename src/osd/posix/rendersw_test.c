@@ -0,0 +1,241 @@
+/** **************************************************************************
+ * rendersw_test.c
+ *
+ * Copyright Bryan Ischo and the MAME Team.
+ * Visit http://mamedev.org for licensing and usage restrictions.
+ *
+ ************************************************************************** **/
+
+#include "emu.h"
+#include "eminline.h"
+#include "video/rgbutil.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * Usage:
+ *
+ *   rendersw_test [seed] [count]
+ *       Draws count (default 20000) random textured quads with the software
+ *       renderer built both with and without its SSE2 row kernels, and checks
+ *       that both draw exactly the same pixels.  Exits non-zero on the first
+ *       quad that differs.
+ **/
+
+/* The renderer is a header-style template; build it twice, once per
+   setting of RENDERSW_ROW_KERNELS, in separate namespaces (its own headers
+   are included above, so they stay outside of both) */
+namespace scalar {
+#define RENDERSW_ROW_KERNELS 0
+#include "../../emu/rendersw.c"
+#undef RENDERSW_ROW_KERNELS
+}
+
+namespace vector {
+#define RENDERSW_ROW_KERNELS 1
+#include "../../emu/rendersw.c"
+#undef RENDERSW_ROW_KERNELS
+}
+
+#define DEST_WIDTH 96
+#define DEST_HEIGHT 64
+#define DEST_PITCH (DEST_WIDTH + 7)
+
+#define TEX_WIDTH 37
+#define TEX_HEIGHT 29
+#define TEX_ROWPIXELS (TEX_WIDTH + 3)
+
+static UINT32 g_texture32[TEX_HEIGHT * TEX_ROWPIXELS];
+static UINT16 g_texture16[TEX_HEIGHT * TEX_ROWPIXELS];
+static rgb_t g_palette[65536];
+
+static UINT32 g_initial[DEST_HEIGHT * DEST_PITCH];
+static UINT32 g_scalar[DEST_HEIGHT * DEST_PITCH];
+static UINT32 g_vector[DEST_HEIGHT * DEST_PITCH];
+
+static UINT32 random32()
+{
+    return (((UINT32) random() & 0xffff) << 16) | ((UINT32) random() & 0xffff);
+}
+
+static float random_float(float min, float max)
+{
+    return min + (((max - min) * (random() % 10001)) / 10000.0f);
+}
+
+/* Returns a color component that is often exactly 1.0 (or 0.0), so that the
+   uncolored and opaque fast paths are taken as well as the general ones */
+static float random_component()
+{
+    switch (random() % 4) {
+    case 0:
+    case 1:
+        return 1.0f;
+    case 2:
+        return (random() % 2) ? 0.0f : 1.5f;
+    default:
+        return random_float(0.0f, 1.0f);
+    }
+}
+
+static void randomize_texture(bool alpha)
+{
+    for (int i = 0; i < (int) (sizeof(g_texture32) / sizeof(g_texture32[0]));
+         i++) {
+        g_texture32[i] = random32();
+        if (!alpha) {
+            g_texture32[i] |= 0xff000000;
+        }
+        g_texture16[i] = random() % 256;
+    }
+
+    for (int i = 0; i < 65536; i++) {
+        g_palette[i] = random32();
+        if (!alpha) {
+            g_palette[i] |= 0xff000000;
+        }
+    }
+}
+
+/* Fills in a random textured quad that walks its texture along rows, which
+   is the case the row kernels handle */
+static void random_quad(render_primitive &prim, int format, int blendmode)
+{
+    memset(&prim, 0, sizeof(prim));
+
+    prim.type = render_primitive::QUAD;
+    prim.flags = (PRIMFLAG_TEXFORMAT(format) |
+                  PRIMFLAG_BLENDMODE(blendmode));
+
+    /* Sometimes hang off the edges of the destination to exercise
+       clipping */
+    prim.bounds.x0 = random_float(-16.0f, DEST_WIDTH - 1);
+    prim.bounds.x1 = prim.bounds.x0 + random_float(8.0f, DEST_WIDTH);
+    prim.bounds.y0 = random_float(-16.0f, DEST_HEIGHT - 1);
+    prim.bounds.y1 = prim.bounds.y0 + random_float(8.0f, DEST_HEIGHT);
+
+    prim.color.r = random_component();
+    prim.color.g = random_component();
+    prim.color.b = random_component();
+    prim.color.a = random_component();
+
+    prim.texture.rowpixels = TEX_ROWPIXELS;
+    prim.texture.width = TEX_WIDTH;
+    prim.texture.height = TEX_HEIGHT;
+    if ((format == TEXFORMAT_RGB32) || (format == TEXFORMAT_ARGB32)) {
+        prim.texture.base = g_texture32;
+        /* RGB32 may or may not have a lookup table */
+        if ((format == TEXFORMAT_RGB32) && (random() % 2)) {
+            prim.texture.palette = g_palette;
+        }
+    }
+    else {
+        prim.texture.base = g_texture16;
+        prim.texture.palette = g_palette;
+    }
+
+    /* Any scale, mirrored or not, but the same V across each row; the
+       renderer doesn't clamp unfiltered texels, so stay far enough inside
+       the texture that rounding the bounds can't step outside of it */
+    float u0 = random_float(0.25f, 0.75f), u1 = random_float(0.25f, 0.75f);
+    float v0 = random_float(0.25f, 0.75f), v1 = random_float(0.25f, 0.75f);
+    prim.texcoords.tl.u = prim.texcoords.bl.u = u0;
+    prim.texcoords.tr.u = prim.texcoords.br.u = u1;
+    prim.texcoords.tl.v = prim.texcoords.tr.v = v0;
+    prim.texcoords.bl.v = prim.texcoords.br.v = v1;
+}
+
+template <typename _Scalar, typename _Vector>
+static bool compare(const char *name, const render_primitive &prim, int n)
+{
+    memcpy(g_scalar, g_initial, sizeof(g_initial));
+    memcpy(g_vector, g_initial, sizeof(g_initial));
+
+    _Scalar::draw_primitive(prim, g_scalar, DEST_WIDTH, DEST_HEIGHT,
+                            DEST_PITCH);
+    _Vector::draw_primitive(prim, g_vector, DEST_WIDTH, DEST_HEIGHT,
+                            DEST_PITCH);
+
+    for (int i = 0; i < DEST_HEIGHT * DEST_PITCH; i++) {
+        if (g_scalar[i] != g_vector[i]) {
+            printf("Quad %d (%s, format %d, blend mode %d, color "
+                   "%g,%g,%g,%g, palette %s) differs at %d,%d: "
+                   "%08x expected, %08x drawn\n", n, name,
+                   PRIMFLAG_GET_TEXFORMAT(prim.flags),
+                   PRIMFLAG_GET_BLENDMODE(prim.flags), prim.color.a,
+                   prim.color.r, prim.color.g, prim.color.b,
+                   prim.texture.palette ? "yes" : "no", i % DEST_PITCH,
+                   i / DEST_PITCH, g_scalar[i], g_vector[i]);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    /* The format and blend mode combinations that reach a row kernel */
+    static const int combos[][2] = {
+        { TEXFORMAT_PALETTE16, BLENDMODE_NONE },
+        { TEXFORMAT_PALETTE16, BLENDMODE_ALPHA },
+        { TEXFORMAT_PALETTEA16, BLENDMODE_ALPHA },
+        { TEXFORMAT_RGB32, BLENDMODE_NONE },
+        { TEXFORMAT_RGB32, BLENDMODE_ALPHA },
+        { TEXFORMAT_ARGB32, BLENDMODE_NONE },
+        { TEXFORMAT_ARGB32, BLENDMODE_ALPHA }
+    };
+    unsigned int seed;
+    int count = 20000;
+
+    if (argc > 1) {
+        seed = atoi(argv[1]);
+    }
+    else {
+        seed = time(NULL);
+    }
+    if (argc > 2) {
+        count = atoi(argv[2]);
+    }
+
+    printf("Seeding random with: %u\n", seed);
+
+    srandom(seed);
+
+    for (int n = 0; n < count; n++) {
+        if ((n % 1000) == 0) {
+            randomize_texture(random() % 2);
+            for (int i = 0; i < DEST_HEIGHT * DEST_PITCH; i++) {
+                g_initial[i] = random32();
+            }
+        }
+
+        int combo = random() % (sizeof(combos) / sizeof(combos[0]));
+        render_primitive prim;
+        random_quad(prim, combos[combo][0], combos[combo][1]);
+
+        /* The standard destination the kernels are written for, the same
+           without reading the destination, and two that must keep using
+           the scalar code */
+        if (!compare<scalar::software_renderer<UINT32, 0,0,0, 16,8,0>,
+                     vector::software_renderer<UINT32, 0,0,0, 16,8,0> >
+                ("RGB32", prim, n) ||
+            !compare<scalar::software_renderer<UINT32, 0,0,0, 16,8,0, true>,
+                     vector::software_renderer<UINT32, 0,0,0, 16,8,0, true> >
+                ("RGB32 no destination read", prim, n) ||
+            !compare<scalar::software_renderer<UINT32, 0,0,0, 16,8,0, false, true>,
+                     vector::software_renderer<UINT32, 0,0,0, 16,8,0, false, true> >
+                ("RGB32 bilinear", prim, n) ||
+            !compare<scalar::software_renderer<UINT32, 0,0,0, 0,8,16>,
+                     vector::software_renderer<UINT32, 0,0,0, 0,8,16> >
+                ("BGR32", prim, n)) {
+            return -1;
+        }
+    }
+
+    printf("%d quads drawn identically\n", count);
+
+    return 0;
+}
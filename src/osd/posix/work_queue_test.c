@@ -7,10 +7,26 @@
  ************************************************************************** **/
 
 #include "osdcore.h"
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 #include <unistd.h>
 
+/**
+ * Usage:
+ *
+ *   work_queue_test [seed]
+ *       Stress test: randomly creates and destroys queues, and queues single
+ *       and multiple, auto released and waited for items on them.
+ *
+ *   work_queue_test -b [max_threads]
+ *       Contention benchmark: runs a few workloads modelled on MAME's uses of
+ *       work queues with the pool sized at 1, 2, 4, ... threads up to
+ *       max_threads (default WORK_MAX_THREADS), and prints the throughput
+ *       and speedup over one thread for each, to show how the pool scales.
+ **/
+
 #define A_LONG_TIME (osd_ticks_per_second() * 1000)
 
 typedef struct work_queue_list_element
@@ -137,10 +153,160 @@ static void add_work_item(work_queue_list_element *elem, bool multiple,
 }
 
 
+/**
+ * A benchmark workload: each round queues work and waits for it all to
+ * complete, like a rasterizer waiting for its scanlines or a sound chip
+ * waiting for its tasks
+ **/
+typedef struct benchmark_workload
+{
+    const char *name;
+
+    /* Queues one round of work onto the queue */
+    void (*queue_round)(osd_work_queue *queue);
+
+    /* How many callbacks each round makes */
+    int items_per_round;
+
+    /* How many rounds to run */
+    int rounds;
+} benchmark_workload;
+
+/* Parameters of benchmark work units; each just spins for a while */
+static int g_unit_params[256];
+
+static volatile int g_sink;
+
+static void *benchmark_callback(void *param, int threadid)
+{
+    int spins = * (int *) param;
+    int sum = 0;
+
+    for (int i = 0; i < spins; i++) {
+        sum += i ^ threadid;
+    }
+
+    g_sink = sum;
+
+    return 0;
+}
+
+
+/* Like poly.c: one item of 256 small units per round */
+static void queue_round_multiple(osd_work_queue *queue)
+{
+    osd_work_item_queue_multiple(queue, &benchmark_callback, 256,
+                                 (void *) g_unit_params, sizeof(int),
+                                 WORK_ITEM_FLAG_AUTO_RELEASE);
+}
+
+
+/* Like the discrete sound tasks: 32 separate items per round */
+static void queue_round_single(osd_work_queue *queue)
+{
+    for (int i = 0; i < 32; i++) {
+        osd_work_item_queue(queue, &benchmark_callback,
+                            (void *) &(g_unit_params[i]),
+                            WORK_ITEM_FLAG_AUTO_RELEASE);
+    }
+}
+
+
+static benchmark_workload g_workloads[] =
+{
+    { "multiple", &queue_round_multiple, 256, 2000 },
+    { "single", &queue_round_single, 32, 10000 }
+};
+
+
+/**
+ * Runs one workload with the pool sized at threads, and returns the number of
+ * callbacks made per second
+ **/
+static double run_workload(const benchmark_workload *workload, int threads,
+                           int spins)
+{
+    char value[16];
+    snprintf(value, sizeof(value), "%d", threads);
+    setenv("OSDPROCESSORS", value, 1);
+
+    for (unsigned int i = 0;
+         i < (sizeof(g_unit_params) / sizeof(g_unit_params[0])); i++) {
+        g_unit_params[i] = spins;
+    }
+
+    /* Creating the first queue creates the pool with the new size, and
+       freeing the last destroys it */
+    osd_work_queue *queue =
+        osd_work_queue_alloc(WORK_QUEUE_FLAG_MULTI | WORK_QUEUE_FLAG_HIGH_FREQ);
+
+    osd_ticks_t start = osd_ticks();
+
+    for (int round = 0; round < workload->rounds; round++) {
+        (workload->queue_round)(queue);
+        osd_work_queue_wait(queue, A_LONG_TIME);
+    }
+
+    osd_ticks_t elapsed = osd_ticks() - start;
+
+    osd_work_queue_free(queue);
+
+    if (elapsed <= 0) {
+        elapsed = 1;
+    }
+
+    return (((double) workload->items_per_round * workload->rounds) *
+            osd_ticks_per_second() / elapsed);
+}
+
+
+static int benchmark(int max_threads)
+{
+    /* Tiny units measure the queue's own overhead and contention; larger
+       ones how well real work spreads across the pool */
+    static const int spins[] = { 10, 1000 };
+
+    printf("Work queue scaling, %ld processors online\n",
+           sysconf(_SC_NPROCESSORS_ONLN));
+
+    for (unsigned int w = 0;
+         w < (sizeof(g_workloads) / sizeof(g_workloads[0])); w++) {
+        for (unsigned int s = 0; s < (sizeof(spins) / sizeof(spins[0]));
+             s++) {
+            printf("\n%s, %d spins per unit:\n", g_workloads[w].name,
+                   spins[s]);
+            printf("%8s %14s %8s\n", "threads", "units/sec", "speedup");
+
+            double base = 0;
+
+            for (int threads = 1; threads <= max_threads; threads *= 2) {
+                double rate = run_workload(&(g_workloads[w]), threads,
+                                           spins[s]);
+                if (threads == 1) {
+                    base = rate;
+                }
+                printf("%8d %14.0f %7.2fx\n", threads, rate, rate / base);
+                fflush(stdout);
+            }
+        }
+    }
+
+    return 0;
+}
+
+
 int main(int argc, char **argv)
 {
     unsigned int seed;
 
+    if ((argc > 1) && !strcmp(argv[1], "-b")) {
+        int max_threads = (argc > 2) ? atoi(argv[2]) : WORK_MAX_THREADS;
+        if ((max_threads < 1) || (max_threads > WORK_MAX_THREADS)) {
+            max_threads = WORK_MAX_THREADS;
+        }
+        return benchmark(max_threads);
+    }
+
     if (argc > 1) {
         seed = atoi(argv[1]);
     }
@@ -28,6 +28,9 @@
 #include <unistd.h>
 #include <stdio.h>
 #include <errno.h>
+#if !defined(SDLMAME_WIN32) && !defined(SDLMAME_OS2)
+#include <sys/mman.h>
+#endif
 
 // MAME headers
 #include "sdlfile.h"
@@ -359,6 +362,55 @@ file_error osd_write(osd_file *file, const void *buffer, UINT64 offset, UINT32 c
 }
 
 
+//============================================================
+//  osd_map
+//============================================================
+
+file_error osd_map(osd_file *file, UINT64 offset, UINT64 length, const void **data)
+{
+#if defined(SDLMAME_WIN32) || defined(SDLMAME_OS2)
+	return FILERR_FAILURE;
+#else
+	// mappings start on a page boundary, so map from the page containing the offset
+	size_t pagemask = (size_t)sysconf(_SC_PAGESIZE) - 1;
+	UINT64 base = offset & ~(UINT64)pagemask;
+	UINT64 span = length + (offset - base);
+	void *mapping;
+
+	if (file->type != SDLFILE_FILE || length == 0)
+		return FILERR_FAILURE;
+
+	// on 32-bit builds a large file may not fit in the address space
+	if ((size_t)span != span)
+		return FILERR_OUT_OF_MEMORY;
+
+	mapping = mmap(NULL, (size_t)span, PROT_READ, MAP_SHARED, file->handle, base);
+	if (mapping == MAP_FAILED)
+		return error_to_file_error(errno);
+
+	*data = (const UINT8 *)mapping + (offset - base);
+	return FILERR_NONE;
+#endif
+}
+
+
+//============================================================
+//  osd_unmap
+//============================================================
+
+void osd_unmap(const void *data, UINT64 length)
+{
+#if !defined(SDLMAME_WIN32) && !defined(SDLMAME_OS2)
+	// the mapping is page aligned, so its start can be recovered from the address
+	size_t pagemask = (size_t)sysconf(_SC_PAGESIZE) - 1;
+	size_t start = (size_t)data;
+	size_t base = start & ~pagemask;
+
+	munmap((void *)base, length + (start - base));
+#endif
+}
+
+
 //============================================================
 //  osd_close
 //============================================================
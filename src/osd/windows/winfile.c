@@ -270,6 +270,58 @@ file_error osd_write(osd_file *file, const void *buffer, UINT64 offset, UINT32 l
 }
 
 
+//============================================================
+//  osd_map
+//============================================================
+
+file_error osd_map(osd_file *file, UINT64 offset, UINT64 length, const void **data)
+{
+	SYSTEM_INFO info;
+	UINT64 base;
+	HANDLE mapping;
+	void *view;
+
+	if (file->type != WINFILE_FILE || length == 0)
+		return FILERR_FAILURE;
+
+	// views start on an allocation granularity boundary, so map from the one before the offset
+	GetSystemInfo(&info);
+	base = offset - offset % info.dwAllocationGranularity;
+
+	// on 32-bit builds a large file may not fit in the address space
+	if ((SIZE_T)(length + (offset - base)) != length + (offset - base))
+		return FILERR_OUT_OF_MEMORY;
+
+	mapping = CreateFileMapping(file->handle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping == NULL)
+		return win_error_to_file_error(GetLastError());
+
+	// the view keeps the mapping object alive, so the handle can go right away
+	view = MapViewOfFile(mapping, FILE_MAP_READ, (DWORD)(base >> 32), (DWORD)base, (SIZE_T)(length + (offset - base)));
+	CloseHandle(mapping);
+	if (view == NULL)
+		return win_error_to_file_error(GetLastError());
+
+	*data = (const UINT8 *)view + (offset - base);
+	return FILERR_NONE;
+}
+
+
+//============================================================
+//  osd_unmap
+//============================================================
+
+void osd_unmap(const void *data, UINT64 length)
+{
+	SYSTEM_INFO info;
+	UINT64 start = (UINT64)(UINT_PTR)data;
+
+	// the view is aligned to the allocation granularity, so its start can be recovered from the address
+	GetSystemInfo(&info);
+	UnmapViewOfFile((void *)(UINT_PTR)(start - start % info.dwAllocationGranularity));
+}
+
+
 //============================================================
 //  osd_close
 //============================================================